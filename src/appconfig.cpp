@@ -81,6 +81,9 @@ AppConfig::ConfigHelp AppConfig::ms_help = {
 ";            Possible values: auto, or an integer number.\n"
 ";  hlt_wait: Interrupts polling time in nanoseconds when the CPU enters an HALT state.\n"
 ";            Affects responsiveness in guest operating systems that use the HLT instruction for idling.\n"
+";  hlt_skip: Advance the time directly to the next timer event when the CPU is in an HALT state.\n"
+";            Reduces the host CPU usage of idle guests. hlt_wait is ignored if enabled.\n"
+";            Possible values: yes, no.\n"
 		},
 
 		{ GUI_SECTION,
@@ -131,13 +134,20 @@ AppConfig::ConfigHelp AppConfig::ms_help = {
 		},
 
 		{ CAPTURE_SECTION,
-";     directory: Directory where things like video, audio, savestates, and screenshots get captured.\n"
-";  video_format: Format to use for video recordings.\n"
-";                Possible values: zmbv, mpng\n"
-";                 zmbv: DOSBox Capture Codec\n"
-";                 mpng: Motion PNG\n"
-"; video_quality: Compression level of the video stream (higher levels have very high load on the CPU).\n"
-";                Possible values: integer between 0 (uncompressed) and 9 (max compression).\n"
+";       directory: Directory where things like video, audio, savestates, and screenshots get captured.\n"
+";    video_format: Format to use for video recordings.\n"
+";                  Possible values: zmbv, mpng\n"
+";                   zmbv: DOSBox Capture Codec\n"
+";                   mpng: Motion PNG\n"
+";   video_quality: Compression level of the video stream (higher levels have very high load on the CPU).\n"
+";                  Possible values: integer between 0 (uncompressed) and 9 (max compression).\n"
+";     state_chain: Maximum number of savestates a savestate can depend on. When greater than 0, a savestate\n"
+";                  stores only the RAM pages changed since the last saved or restored state, which must\n"
+";                  then be kept. Use 0 to always store the whole RAM.\n"
+"; rewind_interval: Milliseconds of emulated time between the in-memory snapshots used to rewind the\n"
+";                  machine (see FUNC_REWIND). Use 0 to disable. Disks are not part of the snapshots,\n"
+";                  so the machine can't be rewound past a disk write or a floppy change.\n"
+";   rewind_memory: Maximum amount of memory used by the rewind snapshots, in MiB.\n"
 		},
 
 		{ DISPLAY_SECTION,
@@ -202,6 +212,9 @@ AppConfig::ConfigHelp AppConfig::ms_help = {
 "; ps_bit_bug: Enable the Palette Size (PS) bit bug emulation.\n"
 ";              This VGA Attribute Controller's bit is not used in 256-color mode, except in the ET4000AX rev. TC6058AF\n"
 ";              (req. by Copper '92 demo).\n"
+"; render_threads: Number of threads used to render graphics modes frames.\n"
+";                 Possible values: auto, or an integer number between 1 and 16.\n"
+";                  auto: half of the host CPU cores, at least 2\n"
 		},
 
 		{ DRIVES_SECTION,
@@ -571,6 +584,9 @@ AppConfig::ConfigSections AppConfig::ms_sections = {
 		{ CAPTURE_VIDEO_FORMAT,  PROGRAM_CONFIG, PUBLIC_CFGKEY, "zmbv" },
 		{ CAPTURE_VIDEO_QUALITY, PROGRAM_CONFIG, PUBLIC_CFGKEY, "3"    },
 		{ CAPTURE_VIDEO_MODE,    PROGRAM_CONFIG, HIDDEN_CFGKEY, "avi"  },
+		{ CAPTURE_STATE_CHAIN,     PROGRAM_CONFIG, PUBLIC_CFGKEY, "0"    },
+		{ CAPTURE_REWIND_INTERVAL, PROGRAM_CONFIG, PUBLIC_CFGKEY, "1000" },
+		{ CAPTURE_REWIND_MEMORY,   PROGRAM_CONFIG, PUBLIC_CFGKEY, "64"   },
 	} },
 	{ DISPLAY_SECTION, {
 		{ DISPLAY_TYPE,             MACHINE_CONFIG, PUBLIC_CFGKEY, "color"                       },
@@ -592,6 +608,7 @@ AppConfig::ConfigSections AppConfig::ms_sections = {
 		{ CPU_MODEL,     MACHINE_CONFIG, PUBLIC_CFGKEY, "auto" },
 		{ CPU_FREQUENCY, MACHINE_CONFIG, PUBLIC_CFGKEY, "auto" },
 		{ CPU_HLT_WAIT,  PROGRAM_CONFIG, PUBLIC_CFGKEY, "500"  },
+		{ CPU_HLT_SKIP,  PROGRAM_CONFIG, PUBLIC_CFGKEY, "yes"  },
 	} },
 	{ MEM_SECTION, {
 		{ MEM_RAM_EXP,   MACHINE_CONFIG, PUBLIC_CFGKEY, "auto" },
@@ -600,6 +617,7 @@ AppConfig::ConfigSections AppConfig::ms_sections = {
 	{ VGA_SECTION, {
 		{ VGA_ROM,        MACHINE_CONFIG, PUBLIC_CFGKEY, ""   },
 		{ VGA_PS_BIT_BUG, MACHINE_CONFIG, PUBLIC_CFGKEY, "no" },
+		{ VGA_RENDER_THREADS, PROGRAM_CONFIG, PUBLIC_CFGKEY, "auto" },
 	} },
 	{ CMOS_SECTION, {
 		{ CMOS_IMAGE_FILE,     MACHINE_CONFIG, PUBLIC_CFGKEY, "auto" },
@@ -616,6 +634,9 @@ AppConfig::ConfigSections AppConfig::ms_sections = {
 		{ DRIVES_FDD_LAT,       MACHINE_CONFIG, PUBLIC_CFGKEY, "1.0"  },
 		{ DRIVES_HDC_TYPE,      MACHINE_CONFIG, PUBLIC_CFGKEY, "auto" },
 		{ DRIVES_HDD_COMMIT,    PROGRAM_CONFIG, PUBLIC_CFGKEY, "yes"  },
+		{ DRIVES_HDD_CACHE,     PROGRAM_CONFIG, HIDDEN_CFGKEY, "2048" },
+		{ DRIVES_HDD_READAHEAD, PROGRAM_CONFIG, HIDDEN_CFGKEY, "64"   },
+		{ DRIVES_HDD_MMAP,      PROGRAM_CONFIG, HIDDEN_CFGKEY, "yes"  },
 		{ DRIVES_CDROM,         MACHINE_CONFIG, PUBLIC_CFGKEY, "none" },
 		{ DRIVES_CDROM_IDLE,    MACHINE_CONFIG, HIDDEN_CFGKEY, "30"   },
 	} },
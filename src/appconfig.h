@@ -181,6 +181,9 @@ public:
 #define CAPTURE_VIDEO_MODE      "video_mode"
 #define CAPTURE_VIDEO_FORMAT    "video_format"
 #define CAPTURE_VIDEO_QUALITY   "video_quality"
+#define CAPTURE_STATE_CHAIN     "state_chain"
+#define CAPTURE_REWIND_INTERVAL "rewind_interval"
+#define CAPTURE_REWIND_MEMORY   "rewind_memory"
 
 #define DISPLAY_SECTION          "display"
 #define DISPLAY_TYPE             "type"
@@ -207,6 +210,7 @@ public:
 #define CPU_MODEL               "model"
 #define CPU_FREQUENCY           "frequency"
 #define CPU_HLT_WAIT            "hlt_wait"
+#define CPU_HLT_SKIP            "hlt_skip"
 
 #define MEM_SECTION             "memory"
 #define MEM_RAM_EXP             "expansion"
@@ -220,6 +224,7 @@ public:
 #define VGA_SECTION             "vga"
 #define VGA_ROM                 "rom"
 #define VGA_PS_BIT_BUG          "ps_bit_bug"
+#define VGA_RENDER_THREADS      "render_threads"
 
 #define DRIVES_SECTION          "drives"
 #define DRIVES_FDD_A            "floppy_a"
@@ -231,6 +236,9 @@ public:
 #define DRIVES_FDC_OVR          "fdc_overhead"
 #define DRIVES_HDC_TYPE         "hdc_type"
 #define DRIVES_HDD_COMMIT       "hdd_commit"
+#define DRIVES_HDD_CACHE        "hdd_cache"
+#define DRIVES_HDD_READAHEAD    "hdd_readahead"
+#define DRIVES_HDD_MMAP         "hdd_mmap"
 #define DRIVES_CDROM            "cdrom"
 #define DRIVES_CDROM_IDLE       "cdrom_idle"
 
@@ -20,7 +20,7 @@
 #ifndef IBMULATOR_MIDI_H
 #define IBMULATOR_MIDI_H
 
-#include "shared_queue.h"
+#include "lockfree_queue.h"
 #include "mididev.h"
 #include "midifile.h"
 #include "statebuf.h"
@@ -34,7 +34,7 @@ private:
 	friend class MIDIDev;
 	
 	bool m_quit;
-	shared_queue<MIDI_fun_t> m_cmd_queue;
+	mpsc_queue<MIDI_fun_t> m_cmd_queue;
 	std::unique_ptr<MIDIDev> m_device;
 	
 	struct State {
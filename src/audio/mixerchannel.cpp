@@ -34,6 +34,7 @@ m_audiotype(_audiotype),
 m_update_clbk(_callback),
 m_capture_clbk([](bool){})
 {
+	m_prof_zone = g_profiler.zone(_name, "audio");
 }
 
 MixerChannel::~MixerChannel()
@@ -304,6 +305,7 @@ void MixerChannel::update(uint64_t _time_span_ns)
 		 * before calling the update
 		 */
 		m_first_update = false;
+		ProfileScope prof(m_prof_zone);
 		m_update_clbk(_time_span_ns, first_upd);
 
 		PDEBUGF(LOG_V2, LOG_MIXER, "%s: updated, enabled=%d, active=%d\n",
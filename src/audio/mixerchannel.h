@@ -195,6 +195,7 @@ private:
 	std::atomic<bool> m_enabled = false;
 	bool m_active = false;
 	MixerChannelHandler m_update_clbk;
+	Profiler::ZoneID m_prof_zone;
 	std::atomic<uint64_t> m_disable_time = 0;
 	uint64_t m_disable_timeout = EFFECTS_MIN_DUR_NS;
 	bool m_first_update = true;
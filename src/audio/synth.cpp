@@ -73,7 +73,7 @@ void Synth::reset()
 {
 	std::lock_guard<std::mutex> lock(m_evt_lock);
 	m_channel->enable(false);
-	m_events.clear();
+	clear_events();
 	m_fr_rem = 0.0;
 	if(m_chips[0]) {
 		m_chips[0]->reset();
@@ -112,6 +112,65 @@ SynthChip * Synth::get_chip(int _id)
 	return m_chips[_id];
 }
 
+void Synth::add_overflow_event(const Event &_evt)
+{
+	// Machine thread
+	std::lock_guard<std::mutex> lock(m_overflow_lock);
+	if(m_overflow.empty()) {
+		PWARNF(LOG_V0, LOG_AUDIO, "%s: event queue full, the mixer is late\n", m_name.c_str());
+	}
+	m_overflow.push_back(_evt);
+	m_overflowing.store(true, std::memory_order_release);
+}
+
+bool Synth::peek_event(Event &_evt)
+{
+	// Mixer thread, the overflow list is read only after the queue
+	if(m_events.try_and_copy(_evt)) {
+		return true;
+	}
+	if(!m_overflowing.load(std::memory_order_acquire)) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_overflow_lock);
+	// the queue can have received events older than the overflowed ones
+	if(m_events.try_and_copy(_evt)) {
+		return true;
+	}
+	if(m_overflow.empty()) {
+		return false;
+	}
+	_evt = m_overflow.front();
+	return true;
+}
+
+void Synth::pop_event()
+{
+	// Mixer thread, removes the event returned by peek_event()
+	Event evt;
+	if(m_events.try_and_pop(evt)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_overflow_lock);
+	if(m_events.try_and_pop(evt) || m_overflow.empty()) {
+		return;
+	}
+	m_overflow.pop_front();
+	if(m_overflow.empty()) {
+		PDEBUGF(LOG_V0, LOG_AUDIO, "%s: event queue overflow recovered\n", m_name.c_str());
+		m_overflowing.store(false, std::memory_order_release);
+	}
+}
+
+void Synth::clear_events()
+{
+	// the caller must exclude the Mixer with m_evt_lock
+	std::lock_guard<std::mutex> lock(m_overflow_lock);
+	m_events.clear();
+	m_overflow.clear();
+	m_overflowing.store(false, std::memory_order_release);
+}
+
 unsigned Synth::generate(AudioBuffer &_outbuffer, uint64_t _delta_ns)
 {
 	// called by the Mixer thread
@@ -143,7 +202,7 @@ bool Synth::create_samples(uint64_t _time_span_ns, bool _first_upd)
 	Event event, next_event;
 	unsigned generated_frames = 0;
 	next_event.time = 0;
-	bool empty = m_events.empty();
+	bool empty = !has_events();
 	double needed_frames = double(_time_span_ns) * m_channel->in_spec().rate/1e9;
 	
 	static AudioBuffer outbuffer;
@@ -151,7 +210,7 @@ bool Synth::create_samples(uint64_t _time_span_ns, bool _first_upd)
 	
 	PDEBUGF(LOG_V2, LOG_MIXER, "%s: %d events\n", m_name.c_str(), m_events.size());
 	while(next_event.time < mtime_ns) {
-		empty = !m_events.try_and_copy(event);
+		empty = !peek_event(event);
 		if(empty || event.time > mtime_ns) {
 			if(is_silent() && m_channel->check_disable_time(mtime_ns)) {
 				m_last_time = 0;
@@ -170,8 +229,8 @@ bool Synth::create_samples(uint64_t _time_span_ns, bool _first_upd)
 		PDEBUGF(LOG_V2, LOG_MIXER, "%s: %02Xh <- %02Xh\n", m_name.c_str(), event.reg, event.value);
 		m_synthcmd_fn(event);
 
-		m_events.try_and_pop();
-		if(!m_events.try_and_copy(next_event) || next_event.time > mtime_ns) {
+		pop_event();
+		if(!peek_event(next_event) || next_event.time > mtime_ns) {
 			//no more events or the next event is in the future
 			next_event.time = mtime_ns;
 		}
@@ -210,19 +269,19 @@ void Synth::save_state(StateBuf &_state)
 		m_chips[1]->save_state(_state);
 	}
 
-	typename std::deque<Event>::iterator it;
-	size_t evt_count;
-	evt_count = m_events.acquire_iterator(it);
-	StateHeader h{evt_count * sizeof(Event), "SynthEvents"};
-	if(evt_count) {
-		std::vector<uint8_t> evts(h.data_size);
-		uint8_t *ptr = &evts[0];
-		for(size_t i=0; i<evt_count; i++,it++) {
-			*((Event*)ptr) = *it;
-			ptr += sizeof(Event);
-		}
-		m_events.release_iterator();
-		_state.write(&evts[0], h);
+	// the Mixer can't pop events while the lock is held
+	std::vector<Event> evts;
+	evts.reserve(m_events.size());
+	m_events.for_each([&](const Event &_evt) {
+		evts.push_back(_evt);
+	});
+	{
+		std::lock_guard<std::mutex> olock(m_overflow_lock);
+		evts.insert(evts.end(), m_overflow.begin(), m_overflow.end());
+	}
+	StateHeader h{evts.size() * sizeof(Event), "SynthEvents"};
+	if(!evts.empty()) {
+		_state.write((uint8_t*)&evts[0], h);
 	} else {
 		_state.write(nullptr, h);
 	}
@@ -234,7 +293,7 @@ void Synth::restore_state(StateBuf &_state)
 
 	std::lock_guard<std::mutex> lock(m_evt_lock);
 
-	m_events.clear();
+	clear_events();
 	m_last_time = 0;
 
 	if(m_chips[0]) {
@@ -259,7 +318,7 @@ void Synth::restore_state(StateBuf &_state)
 		std::vector<Event> evts(evtcnt);
 		_state.read((uint8_t*)&evts[0],h);
 		for(int i=0; i<evtcnt; i++) {
-			m_events.push(evts[i]);
+			add_event(evts[i]);
 		}
 	} else {
 		_state.skip();
@@ -22,6 +22,10 @@
 #include "mixer.h"
 #include "machine.h"
 #include "vgm.h"
+#include "lockfree_queue.h"
+#include <deque>
+
+#define SYNTH_EVENTS_QUEUE 16384
 
 class SynthChip
 {
@@ -63,7 +67,11 @@ private:
 	bool        m_new_data;
 	VGMFile     m_vgm;
 	std::mutex  m_evt_lock;
-	shared_deque<Event> m_events;
+	spsc_queue<Event, SYNTH_EVENTS_QUEUE> m_events; // Machine -> Mixer
+	// events that didn't fit in m_events, all newer than the ones in it
+	std::mutex  m_overflow_lock;
+	std::deque<Event> m_overflow;
+	std::atomic<bool> m_overflowing = false;
 	double      m_fr_rem;
 	synthfunc_t m_synthcmd_fn;
 	genfunc_t   m_generate_fn;
@@ -88,10 +96,14 @@ public:
 		return m_channel->is_enabled();
 	}
 	inline void add_event(const Event &_evt) {
-		m_events.push(_evt);
+		// never wait for the Mixer, it could be paused
+		if(LIKELY(!m_overflowing.load(std::memory_order_acquire)) && m_events.try_push(_evt)) {
+			return;
+		}
+		add_overflow_event(_evt);
 	}
 	inline bool has_events() {
-		return !m_events.empty();
+		return !m_events.empty() || m_overflowing.load(std::memory_order_acquire);
 	}
 	inline bool is_capturing() {
 		return m_vgm.is_open();
@@ -110,6 +122,10 @@ protected:
 
 private:
 	unsigned generate(AudioBuffer &_outbuffer, uint64_t _delta_ns);
+	void add_overflow_event(const Event &_evt);
+	bool peek_event(Event &_evt);
+	void pop_event();
+	void clear_events();
 	bool is_silent();
 	void on_capture(bool _start);
 	void p_enable_channel();
@@ -31,6 +31,7 @@ m_quit(false),
 m_recording(false),
 m_vga_display(_vgadisp),
 m_video_sink(-1),
+m_lost_frames(0),
 m_mixer(_mixer),
 m_audio_sink(-1)
 {
@@ -72,12 +73,16 @@ void Capture::capture_loop()
 			return;
 		}
 		try {
-			VideoFrame frame;
+			std::unique_ptr<VideoFrame> frame;
 			// This thread's frequency will be auto capped to the vga fps.
 			// When the machine is paused this 'wait' will timeout within 2 frames time;
 			auto result = m_video_frames.wait_for_and_pop(frame, g_machine.get_heartbeat() * 2);
 			if(result == std::cv_status::no_timeout) {
-				m_rec_target->push_video_frame(frame);
+				// frames lost because the queue was full are replaced by this
+				// one, so that video and audio stay in sync
+				for(unsigned i=0; i<=frame->lost; i++) {
+					m_rec_target->push_video_frame(*frame);
+				}
 				
 				size_t avail = m_audio_buffer.get_read_avail();
 				if(avail) {
@@ -171,8 +176,18 @@ void Capture::sig_config_changed(std::mutex &_mutex, std::condition_variable &_c
 void Capture::video_sink(const FrameBuffer &_buffer, const VideoModeInfo &_mode,
 	const VideoTimings &_timings)
 {
-	// called by the Machine thread
-	m_video_frames.push(VideoFrame(_buffer, _mode, _timings));
+	// called by the Machine thread, with the VGA display locked: don't wait
+	// for the capture thread, it could be waiting for the same lock.
+	auto frame = std::make_unique<VideoFrame>(_buffer, _mode, _timings);
+	frame->lost = m_lost_frames;
+	if(m_video_frames.try_push(std::move(frame))) {
+		m_lost_frames = 0;
+	} else {
+		if(!m_lost_frames) {
+			PWARNF(LOG_V0, LOG_GUI, "Capture: the encoder is late, frames will be duplicated\n");
+		}
+		m_lost_frames++;
+	}
 }
 
 void Capture::audio_sink(const std::vector<int16_t> &_data, int _category)
@@ -263,6 +278,7 @@ void Capture::start_capture()
 	std::string dest = m_rec_target->open(destdir); // can throw
 	
 	m_vga_display->enable_buffering(true);
+	m_lost_frames = 0;
 	
 	try {
 		m_video_sink = m_vga_display->register_sink(
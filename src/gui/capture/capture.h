@@ -21,13 +21,16 @@
 #define IBMULATOR_CAPTURE_H
 
 #include "mixer.h"
-#include "shared_queue.h"
+#include "lockfree_queue.h"
 #include "pacer.h"
 #include "capture_target.h"
 #include "videoframe.h"
 
 typedef std::function<void()> Capture_fun_t;
 
+// about 3.5 seconds of video at 70Hz
+#define CAPTURE_FRAMES_QUEUE 256
+
 // enum classes are a PITA...
 enum class CaptureMode {
 	NONE,
@@ -42,10 +45,13 @@ private:
 	bool m_quit;
 	bool m_recording;
 	std::unique_ptr<CaptureTarget> m_rec_target;
-	shared_queue<Capture_fun_t> m_cmd_queue;
+	mpsc_queue<Capture_fun_t> m_cmd_queue;
 	VGADisplay *m_vga_display;
 	int m_video_sink;
-	shared_queue<VideoFrame> m_video_frames;
+	// frames are allocated by the sink, so that the queue can be long enough
+	// for the encoder's stalls without reserving memory for every slot
+	spsc_queue<std::unique_ptr<VideoFrame>, CAPTURE_FRAMES_QUEUE> m_video_frames;
+	unsigned m_lost_frames; // Machine thread
 	Mixer *m_mixer;
 	int m_audio_sink;
 	RingBuffer m_audio_buffer;
@@ -27,6 +27,7 @@ struct VideoFrame
 	FrameBuffer buffer;
 	VideoModeInfo mode;
 	VideoTimings timings;
+	unsigned lost = 0; // number of frames lost before this one
 	
 	VideoFrame() {}
 	VideoFrame(const FrameBuffer &_b, const VideoModeInfo &_m, const VideoTimings &_t):
@@ -34,7 +35,8 @@ struct VideoFrame
 	VideoFrame(VideoFrame &&_vf):
 		buffer(std::move(_vf.buffer)),
 		mode(_vf.mode),
-		timings(_vf.timings) {}
+		timings(_vf.timings),
+		lost(_vf.lost) {}
 	VideoFrame(const VideoFrame &) = delete;
 	~VideoFrame() {}
 	
@@ -43,6 +45,7 @@ struct VideoFrame
 		buffer = std::move(_vf.buffer);
 		mode = _vf.mode;
 		timings = _vf.timings;
+		lost = _vf.lost;
 		return *this;
 	}
 };
@@ -113,6 +113,7 @@ const std::map<ProgramEvent::FuncName, std::function<void(GUI&,const ProgramEven
 	{ ProgramEvent::FuncName::FUNC_LOAD_STATE,           &GUI::pevt_func_load_state           },
 	{ ProgramEvent::FuncName::FUNC_QUICK_SAVE_STATE,     &GUI::pevt_func_quick_save_state     },
 	{ ProgramEvent::FuncName::FUNC_QUICK_LOAD_STATE,     &GUI::pevt_func_quick_load_state     },
+	{ ProgramEvent::FuncName::FUNC_REWIND,               &GUI::pevt_func_rewind               },
 	{ ProgramEvent::FuncName::FUNC_GRAB_MOUSE,           &GUI::pevt_func_grab_mouse           },
 	{ ProgramEvent::FuncName::FUNC_SYS_SPEED_UP,         &GUI::pevt_func_sys_speed_up         },
 	{ ProgramEvent::FuncName::FUNC_SYS_SPEED_DOWN,       &GUI::pevt_func_sys_speed_down       },
@@ -2676,6 +2677,22 @@ void GUI::pevt_func_quick_load_state(const ProgramEvent::Func&, EventPhase _phas
 	restore_state({QUICKSAVE_RECORD, QUICKSAVE_DESC, "", 0, 0});
 }
 
+void GUI::pevt_func_rewind(const ProgramEvent::Func &_func, EventPhase _phase)
+{
+	if(_phase != EventPhase::EVT_START) {
+		return;
+	}
+	PDEBUGF(LOG_V1, LOG_GUI, "Rewind func event, steps=%d\n", _func.params[0]);
+
+	for(const auto & [key, state] : m_key_state) {
+		if(state) {
+			send_key_to_machine(key, KEY_RELEASED);
+		}
+	}
+
+	m_machine->cmd_rewind(std::max(_func.params[0], 1));
+}
+
 void GUI::pevt_func_grab_mouse(const ProgramEvent::Func&, EventPhase _phase)
 {
 	if(_phase != EventPhase::EVT_START) {
@@ -3166,7 +3183,7 @@ void GUI::WindowManager::update(uint64_t _current_time)
 
 	// timers are where the timed windows events take place
 	// like the interface messages clears
-	while(!timers.update(_current_time));
+	timers.update(_current_time);
 	
 	if(revert_focus) {
 		if(revert_focus->IsVisible()) {
@@ -27,6 +27,7 @@
 #include "windows/interface.h"
 #include "matrix.h"
 #include "timers.h"
+#include "shared_queue.h"
 #include "keymap.h"
 #include "state_record.h"
 #include "tts.h"
@@ -424,6 +425,7 @@ private:
 	void pevt_func_save_state(const ProgramEvent::Func&, EventPhase);
 	void pevt_func_load_state(const ProgramEvent::Func&, EventPhase);
 	void pevt_func_quick_save_state(const ProgramEvent::Func&, EventPhase);
+	void pevt_func_rewind(const ProgramEvent::Func&, EventPhase);
 	void pevt_func_quick_load_state(const ProgramEvent::Func&, EventPhase);
 	void pevt_func_grab_mouse(const ProgramEvent::Func&, EventPhase);
 	void pevt_func_sys_speed(const ProgramEvent::Func&, EventPhase);
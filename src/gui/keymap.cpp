@@ -52,6 +52,7 @@ const std::map<ProgramEvent::FuncName, ProgramEvent::FuncCategory> ProgramEvent:
 	{ FuncName::FUNC_LOAD_STATE,           FuncCategory::GUI },
 	{ FuncName::FUNC_QUICK_SAVE_STATE,     FuncCategory::GUI },
 	{ FuncName::FUNC_QUICK_LOAD_STATE,     FuncCategory::GUI },
+	{ FuncName::FUNC_REWIND,               FuncCategory::Emulation },
 	{ FuncName::FUNC_GRAB_MOUSE,           FuncCategory::GUI },
 	{ FuncName::FUNC_SYS_SPEED_UP,         FuncCategory::Emulation },
 	{ FuncName::FUNC_SYS_SPEED_DOWN,       FuncCategory::Emulation },
@@ -116,6 +116,7 @@ struct ProgramEvent {
 		FUNC_LOAD_STATE,           // open the load state dialog
 		FUNC_QUICK_SAVE_STATE,     // quick save the current emulator's state
 		FUNC_QUICK_LOAD_STATE,     // quick load the last saved state
+		FUNC_REWIND,               // go back to a previous in-memory snapshot (1 param: number of snapshots)
 		FUNC_GRAB_MOUSE,           // lock / unlock mouse to emulator
 		FUNC_SYS_SPEED_UP,         // increase emulation speed (whole system)
 		FUNC_SYS_SPEED_DOWN,       // decrease emulation speed (whole system)
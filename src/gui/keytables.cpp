@@ -61,6 +61,7 @@ const std::map<std::string, ProgramEvent::FuncName> Keymap::ms_prog_funcs_table
 	{ "FUNC_LOAD_STATE",            ProgramEvent::FuncName::FUNC_LOAD_STATE           },
 	{ "FUNC_QUICK_SAVE_STATE",      ProgramEvent::FuncName::FUNC_QUICK_SAVE_STATE     },
 	{ "FUNC_QUICK_LOAD_STATE",      ProgramEvent::FuncName::FUNC_QUICK_LOAD_STATE     },
+	{ "FUNC_REWIND",                ProgramEvent::FuncName::FUNC_REWIND               },
 	{ "FUNC_GRAB_MOUSE",            ProgramEvent::FuncName::FUNC_GRAB_MOUSE           },
 	{ "FUNC_SYS_SPEED",             ProgramEvent::FuncName::FUNC_SYS_SPEED            },
 	{ "FUNC_SYS_SPEED_UP",          ProgramEvent::FuncName::FUNC_SYS_SPEED_UP         },
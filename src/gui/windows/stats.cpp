@@ -19,6 +19,8 @@
 
 #include "ibmulator.h"
 #include "program.h"
+#include "filesys.h"
+#include "profiler.h"
 #include "gui.h"
 #include "machine.h"
 #include "mixer.h"
@@ -31,9 +33,11 @@
 #include <iomanip>
 
 event_map_t Stats::ms_evt_map = {
-	GUI_EVT( "cmd_reset", "click", Stats::on_cmd_reset ),
-	GUI_EVT( "close",     "click", DebugTools::DebugWindow::on_cancel ),
-	GUI_EVT( "*",       "keydown", Window::on_keydown )
+	GUI_EVT( "cmd_reset",   "click", Stats::on_cmd_reset ),
+	GUI_EVT( "cmd_profile", "click", Stats::on_cmd_profile ),
+	GUI_EVT( "cmd_trace",   "click", Stats::on_cmd_trace ),
+	GUI_EVT( "close",       "click", DebugTools::DebugWindow::on_cancel ),
+	GUI_EVT( "*",         "keydown", Window::on_keydown )
 };
 
 Stats::Stats(GUI * _gui, Machine *_machine, Mixer *_mixer, Rml::Element *_button)
@@ -51,6 +55,10 @@ void Stats::create()
 	m_stats.fps = get_element("FPS");
 	m_stats.machine = get_element("machine");
 	m_stats.mixer = get_element("mixer");
+	m_stats.profiler = get_element("profiler");
+
+	m_tools.profile = get_element("cmd_profile");
+	m_tools.trace = get_element("cmd_trace");
 }
 
 void Stats::update()
@@ -110,6 +118,12 @@ void Stats::update()
 	ss << "Buffer size: " << m_mixer->get_buffer_read_avail() << "<br />";
 	ss << "Delay (us): " << m_mixer->get_buffer_read_avail_us() << "<br />";
 	m_stats.mixer->SetInnerRML(ss.str().c_str());
+
+	ss.str("");
+	print_profiler(ss);
+	m_stats.profiler->SetInnerRML(ss.str().c_str());
+	m_tools.profile->SetClass("on", g_profiler.is_enabled());
+	m_tools.trace->SetClass("on", g_profiler.is_tracing());
 }
 
 static const std::string endline = "<br />";
@@ -185,6 +199,54 @@ void Stats::print(std::ostream &_os, const HWBench &_bench)
 	_os << "CPU clock diff: " << int64_t(vdiff/1.0e6) << "<br />";
 }
 
+void Stats::print_profiler(std::ostream &_os)
+{
+	if(!g_profiler.is_enabled()) {
+		_os << "disabled" << endline;
+		return;
+	}
+	_os << std::fixed;
+	_os << "zone: load% - avg/max us - calls/s" << endline;
+	for(auto &zone : g_profiler.get_stats()) {
+		_os << zone.name << " (" << zone.category << "): ";
+		_os.precision(1);
+		_os << (zone.load * 100.0) << " - ";
+		_os.precision(2);
+		_os << zone.avg_us << "/" << zone.max_us << " - ";
+		_os.precision(0);
+		_os << zone.calls << endline;
+	}
+}
+
+void Stats::on_cmd_profile(Rml::Event &)
+{
+	if(g_profiler.is_tracing()) {
+		m_gui->show_dbg_message("stop the trace first");
+		return;
+	}
+	g_profiler.enable(!g_profiler.is_enabled());
+	m_gui->show_dbg_message(g_profiler.is_enabled() ? "profiler enabled" : "profiler disabled");
+}
+
+void Stats::on_cmd_trace(Rml::Event &)
+{
+	if(!g_profiler.is_tracing()) {
+		g_profiler.start_trace();
+		m_gui->show_dbg_message("trace recording started");
+		return;
+	}
+	std::string path = g_program.config().find_file(CAPTURE_SECTION, CAPTURE_DIR);
+	std::string tracefile = FileSys::get_next_filename(path, "trace_", ".json");
+	try {
+		// the recording is stopped even if the file can't be written
+		g_profiler.stop_trace(tracefile);
+		m_gui->show_dbg_message("trace saved to " + tracefile);
+	} catch(std::exception &e) {
+		PERRF(LOG_GUI, "Cannot save the trace: %s\n", e.what());
+		m_gui->show_dbg_message("cannot save the trace");
+	}
+}
+
 void Stats::on_cmd_reset(Rml::Event &)
 {
 	// same thread
@@ -192,4 +254,7 @@ void Stats::on_cmd_reset(Rml::Event &)
 	
 	// different thread
 	m_machine->cmd_reset_bench();
+
+	// atomic counters
+	g_profiler.reset();
 }
\ No newline at end of file
@@ -31,8 +31,11 @@ class Stats final : public DebugTools::DebugWindow
 {
 private:
 	struct {
-		Rml::Element *fps, *machine, *mixer;
+		Rml::Element *fps, *machine, *mixer, *profiler;
 	} m_stats = {};
+	struct {
+		Rml::Element *profile, *trace;
+	} m_tools = {};
 
 	Machine * m_machine;
 	Mixer * m_mixer;
@@ -40,6 +43,8 @@ private:
 	static event_map_t ms_evt_map;
 
 	void on_cmd_reset(Rml::Event &);
+	void on_cmd_profile(Rml::Event &);
+	void on_cmd_trace(Rml::Event &);
 	
 public:
 	Stats(GUI * _gui, Machine *_machine, Mixer *_mixer, Rml::Element *_button);
@@ -53,6 +58,7 @@ protected:
 private:
 	void print(std::ostream &_os, const Bench &_bench);
 	void print(std::ostream &_os, const HWBench &_bench);
+	void print_profiler(std::ostream &_os);
 };
 
 
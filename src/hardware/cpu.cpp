@@ -116,14 +116,17 @@ void CPU::config_changed()
 	if(m_hlt_state_cycles == 0) {
 		m_hlt_state_cycles = 1;
 	}
+	m_hlt_skip = g_program.config().get_bool(CPU_SECTION, CPU_HLT_SKIP, true);
 
 	PINFOF(LOG_V0, LOG_CPU, "Installed CPU: %s @ %.0fMHz\n", m_model.c_str(), freq);
 	PINFOF(LOG_V1, LOG_CPU, "  Family: %d86, Signature: 0x%04x\n", m_family, m_signature);
 	PINFOF(LOG_V1, LOG_CPU, "  Cycle time: %u nsec (%.3fMHz)\n", m_cycle_time, m_frequency);
-	PINFOF(LOG_V1, LOG_CPU, "  HALT state cycles: %d (%d ns)\n", m_hlt_state_cycles, m_hlt_state_cycles * m_cycle_time);
+	PINFOF(LOG_V1, LOG_CPU, "  HALT state cycles: %d (%d ns)%s\n", m_hlt_state_cycles, m_hlt_state_cycles * m_cycle_time,
+			m_hlt_skip ? ", skip to next timer event" : "");
 
 	g_cpubus.config_changed();
 	g_cpuexecutor.config_changed();
+	g_cpudecoder.flush_cache();
 }
 
 void CPU::reset(uint _signal)
@@ -151,7 +154,10 @@ void CPU::reset(uint _signal)
 		}
 	}
 
+	m_rep_cycles = 0;
+
 	g_cpucore.reset();
+	g_cpudecoder.flush_cache();
 	g_cpuexecutor.reset(_signal);
 	g_cpubus.reset();
 }
@@ -172,6 +178,7 @@ void CPU::save_state(StateBuf &_state)
 	g_cpubus.save_state(_state);
 
 	// decoder and executor don't have a state to save and restore
+	// (the decoder's cache is flushed on restore)
 }
 
 void CPU::restore_state(StateBuf &_state)
@@ -182,8 +189,10 @@ void CPU::restore_state(StateBuf &_state)
 	_state.read(&m_s,h);
 
 	m_instr = &m_s.instr;
+	m_rep_cycles = 0;
 
 	g_cpuexecutor.reset(MACHINE_HARD_RESET);
+	g_cpudecoder.flush_cache();
 
 	// restore the core before the bus.
 	g_cpucore.restore_state(_state);
@@ -204,7 +213,10 @@ uint CPU::step()
 	CPUCore core_log;
 	CPUState state_log;
 	CPUException log_exc;
+	CPUException fault;
 	bool do_log = false;
+	bool rep_iteration = false;
+	uint32_t rep_bulk = 0;
 
 	g_cpubus.reset_counters();
 	CPUCycles cycles = { 0,0,0,0,0,0 };
@@ -225,6 +237,9 @@ uint CPU::step()
 				}
 			}
 
+			// page faults of the instruction are delivered without unwinding
+			g_cpuexecutor.enable_abort_faults(true);
+
 			if(LIKELY(m_instr->cseip != CS_EIP)) {
 				// When RF is set, it causes any debug fault to be ignored during the next instruction.
 				if(UNLIKELY(DR7_ENABLED_ANY && !FLAG_RF && !interrupts_inhibited(CPU_INHIBIT_DEBUG))) {
@@ -256,37 +271,73 @@ uint CPU::step()
 				}
 			}
 
-			// instruction execution
-			g_cpuexecutor.execute(m_instr);
+			if(UNLIKELY(m_instr->rep)) {
+				// iterations after the first can be executed in bulk if their
+				// cost is known (see CPUExecutor::rep_bulk())
+				rep_iteration = !m_instr->rep_first;
+				if(rep_iteration && m_rep_cycles && m_run_timers) {
+					g_cpuexecutor.rep_bulk_setup(get_rep_bulk_max());
+				} else {
+					g_cpuexecutor.rep_bulk_setup(0);
+				}
+			}
 
-			cycles.eu = get_execution_cycles(g_cpubus.memory_accessed());
-			int io_time = g_devices.get_last_io_time();
-			if(io_time) {
-				cycles.io = get_io_cycles(io_time);
+			// instruction execution, unless its fetch faulted
+			if(LIKELY(!g_cpuexecutor.fault_pending())) {
+				g_cpuexecutor.execute(m_instr, g_cpudecoder.decoded_fn());
+			}
+
+			if(UNLIKELY(g_cpuexecutor.fault_pending())) {
+				// the instruction raised a fault without throwing it
+				fault = g_cpuexecutor.take_fault();
+			} else {
+				if(UNLIKELY(rep_iteration)) {
+					rep_bulk = g_cpuexecutor.rep_bulk_count();
+				}
+
+				cycles.eu = get_execution_cycles(g_cpubus.memory_accessed());
+				int io_time = g_devices.get_last_io_time();
+				if(io_time) {
+					cycles.io = get_io_cycles(io_time);
+				}
+				m_instr->cycles.rep = 0;
 			}
-			m_instr->cycles.rep = 0;
 		} catch(CPUException &e) {
-			PDEBUGF(LOG_V2, LOG_CPU, "CPU exception %s\n", e.name());
-			if(STOP_AT_EXC && ((1<<e.vector)&STOP_AT_EXC_VEC)) {
+			fault = e;
+		} catch(CPUShutdown &s) {
+			if(!g_cpuexecutor.fault_pending()) {
+				PDEBUGF(LOG_V2, LOG_CPU, "Entering shutdown for %s\n", s.what());
+				g_cpu.enter_sleep_state(CPU_STATE_SHUTDOWN);
+				cycles.eu = 5; //just a random number
+				rep_iteration = false;
+			}
+		}
+		g_cpuexecutor.enable_abort_faults(false);
+		if(UNLIKELY(g_cpuexecutor.fault_pending())) {
+			// the instruction continued after a page fault and threw something
+			// else, the page fault comes first
+			fault = g_cpuexecutor.take_fault();
+		}
+
+		if(fault.vector != CPU_INVALID_INT) {
+			PDEBUGF(LOG_V2, LOG_CPU, "CPU exception %s\n", fault.name());
+			if(STOP_AT_EXC && ((1<<fault.vector)&STOP_AT_EXC_VEC)) {
 				g_machine.set_single_step(true);
-				if(e.vector == CPU_UD_EXC && UD6_AUTO_DUMP) {
+				if(fault.vector == CPU_UD_EXC && UD6_AUTO_DUMP) {
 					PERRF(LOG_CPU,"illegal opcode at 0x%07X, dumping code segment\n", m_instr->cseip);
 					g_machine.memdump(REG_CS.desc.base, GET_LIMIT(CS));
 				}
 			}
 			if(CPULOG) {
 				if(!do_log) {
-					m_logger.set_prev_i_exc(e, m_instr->cseip);
+					m_logger.set_prev_i_exc(fault, m_instr->cseip);
 				} else {
-					log_exc = e;
+					log_exc = fault;
 				}
 			}
-			exception(e);
-			cycles.eu = 5; //just a random number
-		} catch(CPUShutdown &s) {
-			PDEBUGF(LOG_V2, LOG_CPU, "Entering shutdown for %s\n", s.what());
-			g_cpu.enter_sleep_state(CPU_STATE_SHUTDOWN);
+			exception(fault);
 			cycles.eu = 5; //just a random number
+			rep_iteration = false;
 		}
 
 	} else {
@@ -296,6 +347,16 @@ uint CPU::step()
 		cycles.eu = m_hlt_state_cycles;
 	}
 
+	if(rep_bulk) {
+		// the bus was not used, every iteration costs the same as the last
+		// regular one
+		g_cpubus.update(0);
+		int tot_cycles = get_rep_bulk_cycles(rep_bulk);
+		m_s.icount++;
+		m_s.ccount += tot_cycles;
+		return tot_cycles;
+	}
+
 	if(g_cpubus.pq_is_valid()) {
 		g_cpubus.update(cycles.decode + cycles.eu);
 		// other possible strategies:
@@ -315,6 +376,7 @@ uint CPU::step()
 	cycles.bus = g_cpubus.fetch_cycles() + g_cpubus.mem_r_cycles();
 
 	int tot_cycles = cycles.sum();
+	m_rep_cycles = rep_iteration ? tot_cycles : 0;
 	if(cycles.bus && (g_machine.get_virt_time_ns()%15085)<((tot_cycles*m_cycle_time))) {
 		// DRAM refresh
 		// TODO count only for DRAM not other bus uses
@@ -340,6 +402,81 @@ uint CPU::step()
 	return tot_cycles;
 }
 
+/* Executes instructions back to back until _cycles are spent, the virtual
+ * time _time reaches the next timer event, or the machine is paused.
+ * The timers' time is advanced after every instruction (devices must see the
+ * correct time during I/O) except for the last one; firing the timers and
+ * setting the final time is left to the caller.
+ * Returns the number of cycles spent.
+ */
+int32_t CPU::run(int32_t _cycles, EventTimers &_timers, uint64_t &_time, unsigned &_icount)
+{
+	int32_t spent = 0;
+	uint64_t time = _timers.get_time();
+	m_run_timers = &_timers;
+	while(true) {
+		int32_t c = step();
+		if(c > 0) {
+			// c is 0 only if (REP && CX==0)
+			if(UNLIKELY(m_s.activity_state != CPU_STATE_ACTIVE) && m_hlt_skip && !m_s.HRQ) {
+				// nothing can wake up the CPU before the next timer event, so
+				// jump straight to it (or to the end of the cycles budget)
+				uint64_t next = _timers.get_next_timer_time();
+				if(next > time) {
+					uint64_t idle = (next - time - 1) / m_cycle_time + 1;
+					idle = std::min(idle, uint64_t(_cycles - spent));
+					if(int32_t(idle) > c) {
+						m_s.ccount += idle - c;
+						c = idle;
+					}
+				}
+			}
+			_icount++;
+			spent += c;
+			time += uint64_t(c) * m_cycle_time;
+			if(time >= _timers.get_next_timer_time() || spent >= _cycles) {
+				break;
+			}
+			_timers.advance_time(time);
+		}
+		if(UNLIKELY(g_machine.is_paused())) {
+			break;
+		}
+	}
+	m_run_timers = nullptr;
+	_time = time;
+	return spent;
+}
+
+/* Returns the max number of REP iterations that can be executed in bulk before
+ * the next timer event, DRAM refresh cycles included.
+ */
+uint32_t CPU::get_rep_bulk_max() const
+{
+	uint64_t now = m_run_timers->get_time();
+	uint64_t next = m_run_timers->get_next_timer_time();
+	if(next <= now) {
+		return 0;
+	}
+	uint64_t avail = next - now;
+	uint64_t refresh = (avail / 15085 + 1) * g_memory.dram_cycles() * m_cycle_time;
+	if(avail <= refresh) {
+		return 0;
+	}
+	avail -= refresh;
+	return std::min(avail / (uint64_t(m_rep_cycles) * m_cycle_time), uint64_t(UINT32_MAX));
+}
+
+int CPU::get_rep_bulk_cycles(uint32_t _count) const
+{
+	int cycles = _count * m_rep_cycles;
+	// a DRAM refresh every 15085ns, same as the per-instruction approximation
+	uint64_t now = m_run_timers->get_time();
+	uint64_t end = now + uint64_t(cycles) * m_cycle_time;
+	cycles += (end / 15085 - now / 15085) * g_memory.dram_cycles();
+	return cycles;
+}
+
 int CPU::get_execution_cycles(bool _memtx)
 {
 	unsigned cycles_spent = 0;
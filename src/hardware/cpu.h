@@ -76,6 +76,8 @@ Sig    Model       Step
 
 #include "cpu/executor.h"
 
+class EventTimers;
+
 class CPU
 {
 protected:
@@ -85,9 +87,14 @@ protected:
 	double   m_frequency = .0;
 	uint32_t m_cycle_time = 0;
 	unsigned m_hlt_state_cycles = 1;
+	bool m_hlt_skip = false;
 	Instruction *m_instr = nullptr;
 	std::function<void(void)> m_shutdown_trap;
 
+	// REP string operations bulk execution
+	EventTimers *m_run_timers = nullptr; // valid only inside run()
+	int m_rep_cycles = 0; // cycles spent by the last REP iteration
+
 	CPUState m_s;
 
 	CPULogger m_logger;
@@ -103,6 +110,7 @@ public:
 	void config_changed();
 
 	uint step();
+	int32_t run(int32_t _cycles, EventTimers &_timers, uint64_t &_time, unsigned &_icount);
 
 	inline std::string model() const { return m_model; }
 	inline unsigned family() const { return m_family; }
@@ -158,6 +166,8 @@ protected:
 
 	int get_execution_cycles(bool _memtx);
 	int get_io_cycles(int _io_time);
+	uint32_t get_rep_bulk_max() const;
+	int get_rep_bulk_cycles(uint32_t _count) const;
 };
 
 
@@ -21,6 +21,7 @@
 #include "bus.h"
 #include "mmu.h"
 #include "../cpu.h"
+#include "executor.h"
 #include "program.h"
 #include <cstring>
 
@@ -39,6 +40,10 @@ CPUBus::CPUBus()
 
 void CPUBus::init()
 {
+	// the pages of the queued bytes are marked as code pages by fill_pq()
+	g_memory.register_code_handler([this](uint32_t) {
+		pq_mark_stale();
+	});
 }
 
 void CPUBus::reset()
@@ -99,6 +104,7 @@ void CPUBus::restore_state(StateBuf &_state)
 {
 	_state.read(&m_s, {sizeof(m_s), "CPUBus"});
 	enable_paging(IS_PAGING());
+	pq_mark_stale();
 }
 
 void CPUBus::enable_paging(bool _enabled)
@@ -158,11 +164,22 @@ void CPUBus::update(int _cycles)
 #endif
 }
 
+void CPUBus::fetch_fault(const CPUException &_fault)
+{
+	// decoding continues with zeros and the instruction is not executed
+	g_cpuexecutor.abort_fault(_fault);
+}
+
 template<int len>
-uint32_t CPUBus::mmu_read(uint32_t _linear, int &_cycles)
+bool CPUBus::mmu_read(uint32_t _linear, int &_cycles, uint32_t &_value, CPUException &_fault)
 {
-	uint32_t phy = g_cpummu.TLB_lookup(_linear, len, IS_USER_PL, false);
-	return g_memory.read<len>(phy, _cycles);
+	uint32_t phy;
+	if(!g_cpummu.TLB_translate(_linear, len, IS_USER_PL, false, phy, _fault)) {
+		return false;
+	}
+	g_memory.mark_code_page(phy);
+	_value = g_memory.read<len>(phy, _cycles);
+	return true;
 }
 
 template<int bytes, bool paging>
@@ -201,42 +218,51 @@ int CPUBus::fill_pq(int _amount, int _cycles, bool _paddress)
 		if(paging) {
 			// reads must be inside dword boundaries
 			assert((PAGE_OFFSET(m_s.pq_tail) + adv) <= 4096);
-			try {
-				switch(adv) {
-					default: assert(false); break;
-					case 2: { // word aligned
-						uint16_t v = mmu_read<2>(m_s.pq_tail, c);
+			// #PF are returned by the page walk instead of thrown, prefetching
+			// past the end of a mapped page is common
+			uint32_t v;
+			CPUException fault;
+			bool mapped;
+			switch(adv) {
+				default: assert(false); return cycles;
+				case 2: // word aligned
+					mapped = mmu_read<2>(m_s.pq_tail, c, v, fault);
+					if(mapped) {
 						*pq_ptr = v;
 						*(pq_ptr + 1) = v >> 8;
-
-						break;
 					}
-					case 1: // 1-byte unaligned (right)
-						*pq_ptr = mmu_read<1>(m_s.pq_tail, c);
-						break;
-					case 4: { // dword aligned
-						uint32_t v = mmu_read<4>(m_s.pq_tail, c);
+					break;
+				case 1: // 1-byte unaligned (right)
+					mapped = mmu_read<1>(m_s.pq_tail, c, v, fault);
+					if(mapped) {
+						*pq_ptr = v;
+					}
+					break;
+				case 4: // dword aligned
+					mapped = mmu_read<4>(m_s.pq_tail, c, v, fault);
+					if(mapped) {
 						*pq_ptr = v;
 						*(pq_ptr + 1) = v >> 8;
 						*(pq_ptr + 2) = v >> 16;
 						*(pq_ptr + 3) = v >> 24;
-						break;
 					}
-					case 3: { // 1-byte unaligned (left)
-						uint32_t v = mmu_read<4>(m_s.pq_tail-1, c);
+					break;
+				case 3: // 1-byte unaligned (left)
+					mapped = mmu_read<4>(m_s.pq_tail-1, c, v, fault);
+					if(mapped) {
 						*pq_ptr = v >> 8;
 						*(pq_ptr + 1) = v >> 16;
 						*(pq_ptr + 2) = v >> 24;
-						break;
 					}
-				}
-			} catch(CPUException &) {
-				// #PF are catched here
+					break;
+			}
+			if(!mapped) {
 				if(_amount) {
 					// the requested amount is not present
-					// throw page fault for instruction decoding
+					// page fault for instruction decoding
 					m_s.pq_valid = false;
-					throw;
+					fetch_fault(fault);
+					return cycles;
 				} else {
 					// no amount required, queue is filled with 0 or more valid bytes
 					// don't throw exceptions for code prefetching
@@ -245,6 +271,7 @@ int CPUBus::fill_pq(int _amount, int _cycles, bool _paddress)
 				}
 			}
 		} else {
+			g_memory.mark_code_page(m_s.pq_tail);
 			switch(adv) {
 				default: assert(false); break;
 				case 2:  { // word aligned
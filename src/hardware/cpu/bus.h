@@ -45,6 +45,11 @@ private:
 		int      pq_len;
 	} m_s;
 
+	// linear address of the first queued byte fetched after the last write to
+	// a code page, bytes before it can differ from memory (as on the real
+	// hardware, the queue is not flushed by writes)
+	uint32_t m_pq_coherent = 0;
+
 	int m_width = 0;
 	int m_pq_size = 0;
 	int m_pq_thres = 0;
@@ -113,9 +118,52 @@ public:
 		m_s.pq_len = 0;
 		m_s.pq_left = m_s.cseip;
 		m_s.pq_tail = m_s.pq_left;
+		m_pq_coherent = m_s.pq_left;
 	}
 	void reset_pq();
 
+	// The memory write sequence number the next instruction byte is known to
+	// be current at, or 0 if it has been queued before the last write to a
+	// code page.
+	inline uint64_t pq_seq() const {
+		if(int32_t(m_s.cseip - m_pq_coherent) >= 0) {
+			return g_memory.write_seq();
+		}
+		return 0;
+	}
+	// Forget the origin of the queued bytes (eg. after an address translation
+	// change or a write to a code page).
+	inline void pq_mark_stale() {
+		m_pq_coherent = m_s.pq_tail;
+	}
+	// Returns true if the bytes already in the queue are equal to _bytes.
+	inline bool pq_match(const uint8_t *_bytes, int _len) const {
+		int len = std::min(_len, m_s.pq_len);
+		const uint8_t *pq = &m_s.pq[m_s.cseip - m_s.pq_left];
+		for(int i=0; i<len; i++) {
+			if(pq[i] != _bytes[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+	// Consumes _len instruction bytes, filling the queue exactly like the
+	// instruction decoding would.
+	inline void skip(int _len) {
+		while(_len) {
+			if(m_s.pq_len == 0) {
+				fetch<uint8_t,1>();
+				_len--;
+				continue;
+			}
+			int len = std::min(_len, m_s.pq_len);
+			m_s.pq_len -= len;
+			m_s.cseip += len;
+			m_s.eip += len;
+			_len -= len;
+		}
+	}
+
 	template<unsigned S> inline uint32_t mem_read(uint32_t _addr)
 	{
 		return p_mem_read<S>(_addr, m_mem_r_cycles);
@@ -158,9 +206,11 @@ private:
 		return m_s.pq_len == 0;
 	}
 	uint8_t *move_pq_data();
-	template<int len> uint32_t mmu_read(uint32_t _linear, int &_cycles);
+	template<int len> bool mmu_read(uint32_t _linear, int &_cycles, uint32_t &_value,
+			CPUException &_fault);
 	template<int bytes, bool paging> int fill_pq(int _amount, int _cycles, bool _paddress);
 	int (CPUBus::*fill_pq_fn)(int, int, bool) = nullptr;
+	void fetch_fault(const CPUException &_fault);
 
 	template<class T, int L>
 	T fetch()
@@ -171,6 +221,10 @@ private:
 				m_pfetch_cycles += m_cycles_ahead;
 				m_cycles_ahead = 0;
 			}
+			if(UNLIKELY(m_s.pq_len < L)) {
+				// page fault, see fetch_fault()
+				return 0;
+			}
 		}
 		T data;
 		switch(L) {
@@ -201,7 +255,11 @@ private:
 		T data;
 		uint32_t phy = m_s.cseip;
 		if(IS_PAGING()) {
-			phy = g_cpummu.TLB_lookup(m_s.cseip, L, IS_USER_PL, false);
+			CPUException fault;
+			if(UNLIKELY(!g_cpummu.TLB_translate(m_s.cseip, L, IS_USER_PL, false, phy, fault))) {
+				fetch_fault(fault);
+				return 0;
+			}
 		}
 		data = mem_read<L>(phy);
 		m_s.cseip += L;
@@ -44,6 +44,7 @@ void CPUCore::reset()
 	memset(m_segregs, 0, sizeof(SegReg)*10);
 
 	m_eflags = 0x00000002;
+	m_lf.mask = 0;
 	m_cr[0] = 0x0;
 	m_cr[2] = 0x0;
 	m_cr[3] = 0x0;
@@ -124,6 +125,7 @@ void CPUCore::handle_mode_change()
 			SEG_PRESENT |
 			SEG_READWRITE |
 			SEG_ACCESSED);
+		m_segregs[REGI_CS].update_window();
 		CPL = 0;
 		PDEBUGF(LOG_V2, LOG_CPU, "now in Real mode\n");
 	}
@@ -160,6 +162,7 @@ void CPUCore::load_segment_real(SegReg & _segreg, uint16_t _value)
 		_segreg.desc.page_granular = false;
 		_segreg.desc.big = false;
 	}
+	_segreg.update_window();
 }
 
 void CPUCore::load_segment_defaults(SegReg & _segreg, uint16_t _value)
@@ -196,6 +199,7 @@ void CPUCore::load_segment_defaults(SegReg & _segreg, uint16_t _value)
 			SEG_READWRITE
 		);
 	}
+	_segreg.update_window();
 }
 
 void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
@@ -248,6 +252,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		/* all done and well, load the register */
 		REG_SS.desc = descriptor;
 		REG_SS.sel = selector;
+		REG_SS.update_window();
 
 	} else if(_segreg.is(REG_DS) || _segreg.is(REG_ES)
 	        || _segreg.is(REG_FS)|| _segreg.is(REG_GS)) {
@@ -258,6 +263,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 			_segreg.desc = 0;
 			_segreg.desc.set_AR(SEG_SEGMENT); /* data/code segment */
 			_segreg.desc.valid = false; /* invalidate null selector */
+			_segreg.update_window();
 			return;
 		}
 
@@ -303,6 +309,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		/* all done and well, load the register */
 		_segreg.desc = descriptor;
 		_segreg.sel = selector;
+		_segreg.update_window();
 
 	} else {
 
@@ -360,6 +367,7 @@ void CPUCore::set_CS(Selector &selector, Descriptor &descriptor, uint8_t cpl)
 	REG_CS.sel = selector;
 	REG_CS.desc = descriptor;
 	REG_CS.sel.cpl = cpl;
+	REG_CS.update_window();
 
 	//the pq must be invalidated by the caller!
 }
@@ -376,6 +384,7 @@ void CPUCore::set_SS(Selector &selector, Descriptor &descriptor, uint8_t cpl)
 	REG_SS.sel = selector;
 	REG_SS.desc = descriptor;
 	REG_SS.sel.cpl = cpl;
+	REG_SS.update_window();
 }
 
 void CPUCore::set_FLAGS(uint16_t _val)
@@ -383,6 +392,7 @@ void CPUCore::set_FLAGS(uint16_t _val)
 	uint16_t f16 = uint16_t(m_eflags);
 	// bit1 is fixed 1
 	m_eflags = (_val & FMASK_VALID) | (m_eflags & 0x30000) | 2;
+	m_lf.mask = 0;
 	if(m_eflags & FMASK_TF) {
 		g_cpu.set_async_event();
 	}
@@ -396,6 +406,7 @@ void CPUCore::set_EFLAGS(uint32_t _val)
 	uint32_t f32 = m_eflags;
 	// bit1 is fixed 1
 	m_eflags = (_val & FMASK_VALID) | 2;
+	m_lf.mask = 0;
 	if(m_eflags & FMASK_TF) {
 		g_cpu.set_async_event();
 	}
@@ -606,6 +617,27 @@ const char *SegReg::to_string() const
 	else { return "??"; }
 }
 
+void SegReg::update_window()
+{
+	// same tests as CPUExecutor::seg_test_read() and seg_test_write()
+	window.read = desc.valid && !(desc.is_code_segment() && !desc.is_readable());
+	window.write = desc.valid && desc.is_writeable();
+	if(desc.is_expand_down()) {
+		uint32_t upper_limit = desc.big ? 0xFFFFFFFF : 0xFFFF;
+		if(desc.limit >= upper_limit - 1) {
+			// empty
+			window.lo = 1;
+			window.hi = 0;
+		} else {
+			window.lo = desc.limit + 1;
+			window.hi = upper_limit - 1;
+		}
+	} else {
+		window.lo = 0;
+		window.hi = desc.limit;
+	}
+}
+
 void SegReg::validate()
 {
 	if(desc.dpl < CPL) {
@@ -615,6 +647,7 @@ void SegReg::validate()
 		{
 			sel.value = 0;
 			desc.valid = false;
+			update_window();
 		}
 	}
 }
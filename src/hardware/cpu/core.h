@@ -80,6 +80,7 @@ extern CPUCore g_cpucore;
 #define FMASK_RF   (1 << FBITN_RF)  // 16 RESUME FLAG
 #define FMASK_VM   (1 << FBITN_VM)  // 17 VIRTUAL 8086 MODE
 
+#define FMASK_ARITH  (FMASK_CF|FMASK_PF|FMASK_AF|FMASK_ZF|FMASK_SF|FMASK_OF)
 #define FMASK_FLAGS  0xFFFF
 #define FMASK_EFLAGS 0x3FFFF
 #define FMASK_VALID  0x00037FD5 // only supported bits for EFLAGS register
@@ -170,10 +171,31 @@ struct SegReg
 	Selector sel;
 	Descriptor desc;
 
+	/* The offsets that pass the CPUExecutor::seg_check() tests, precomputed
+	 * from desc. update_window() must be called every time desc changes.
+	 * An access outside the window goes through the full checks.
+	 */
+	struct {
+		uint32_t lo;
+		uint32_t hi;
+		bool read;
+		bool write;
+	} window;
+
 	inline bool is(const SegReg & _segreg) const {
 		return (this==&_segreg);
 	}
+	inline bool in_window(uint32_t _offset, unsigned _len) const {
+		return (_offset >= window.lo && _offset <= window.hi && (window.hi - _offset) >= (_len-1));
+	}
+	inline bool can_read(uint32_t _offset, unsigned _len) const {
+		return window.read && in_window(_offset, _len);
+	}
+	inline bool can_write(uint32_t _offset, unsigned _len) const {
+		return window.write && in_window(_offset, _len);
+	}
 
+	void update_window();
 	void validate();
 	const char *to_string() const;
 };
@@ -364,6 +386,17 @@ bits.
 #define IS_PAGING() g_cpucore.is_paging()
 
 
+// operations which arithmetic flags are evaluated lazily
+enum LazyFlagsOp {
+	LF_ADD,   // ADD, ADC with CF=0
+	LF_ADC,   // ADC with CF=1
+	LF_SUB,   // SUB, CMP, SBB with CF=0
+	LF_SBB,   // SBB with CF=1
+	LF_LOGIC, // AND, OR, XOR, TEST
+	LF_INC,   // INC (CF is not affected)
+	LF_DEC    // DEC (CF is not affected)
+};
+
 class CPUCore
 {
 protected:
@@ -377,6 +410,20 @@ protected:
 	// status and control registers
 	uint32_t m_eflags;
 	uint32_t m_eip, m_prev_eip;
+
+	/* Lazy arithmetic flags.
+	 * ALU operations record their operands and result, and the flags in mask
+	 * are computed only when they are read. The same bits in m_eflags are
+	 * stale.
+	 */
+	struct {
+		uint32_t mask; // EFLAGS bits to compute
+		uint32_t op;   // LazyFlagsOp
+		uint32_t msb;  // sign bit of the operand size
+		uint32_t res;
+		uint32_t op1;
+		uint32_t op2;
+	} m_lf;
 	uint32_t m_cr[4];
 	uint32_t m_dr[8];
 	uint32_t m_tr[8];
@@ -395,9 +442,12 @@ protected:
 	void load_segment_defaults(SegReg & _segreg, uint16_t _value);
 
 	inline void set_flag(uint8_t _flagnum, bool _val) {
+		m_lf.mask &= ~(1<<_flagnum);
 		m_eflags = (m_eflags &~ (1<<_flagnum)) | ((_val)<<_flagnum);
 	}
 
+	inline uint32_t lazy_flags(uint32_t _mask) const;
+
 	void handle_mode_change();
 
 public:
@@ -449,8 +499,32 @@ public:
 	inline uint32_t get_EIP() const { return m_eip; }
 	inline void restore_EIP() { m_eip = m_prev_eip; }
 
-	inline uint16_t get_FLAGS(uint16_t _mask) const { return (uint16_t(m_eflags) & _mask); }
-	inline uint32_t get_EFLAGS(uint32_t _mask) const { return (m_eflags & _mask); }
+	inline uint16_t get_FLAGS(uint16_t _mask) const { return get_EFLAGS(_mask); }
+	inline uint32_t get_EFLAGS(uint32_t _mask) const {
+		uint32_t lazy = m_lf.mask & _mask;
+		if(lazy) {
+			return ((m_eflags & ~lazy) | lazy_flags(lazy)) & _mask;
+		}
+		return (m_eflags & _mask);
+	}
+
+	template<typename T>
+	inline void set_lazy_flags(LazyFlagsOp _op, T _res, T _op1, T _op2) {
+		uint32_t mask = FMASK_ARITH;
+		if(_op == LF_INC || _op == LF_DEC) {
+			// CF must keep its current value
+			if(m_lf.mask & FMASK_CF) {
+				set_flag(FBITN_CF, lazy_flags(FMASK_CF));
+			}
+			mask &= ~FMASK_CF;
+		}
+		m_lf.mask = mask;
+		m_lf.op = _op;
+		m_lf.msb = 1u << (sizeof(T)*8 - 1);
+		m_lf.res = _res;
+		m_lf.op1 = _op1;
+		m_lf.op2 = _op2;
+	}
 
 	       void set_FLAGS(uint16_t _val);
 	       void set_EFLAGS(uint32_t _val);
@@ -559,4 +633,59 @@ public:
 };
 
 
+inline uint32_t CPUCore::lazy_flags(uint32_t _mask) const
+{
+	const uint32_t res = m_lf.res;
+	const uint32_t op1 = m_lf.op1;
+	const uint32_t op2 = m_lf.op2;
+	const uint32_t msb = m_lf.msb;
+	uint32_t flags = 0;
+
+	if(_mask & FMASK_CF) {
+		bool cf;
+		switch(m_lf.op) {
+			case LF_ADD: cf = (res < op1); break;
+			case LF_ADC: cf = (res <= op1); break;
+			case LF_SUB: cf = (op1 < op2); break;
+			case LF_SBB: cf = (op1 < res) || (op2 == ((msb << 1) - 1)); break;
+			default: cf = false; break;
+		}
+		flags |= uint32_t(cf) << FBITN_CF;
+	}
+	if(_mask & FMASK_PF) {
+		flags |= uint32_t(!__builtin_parity(res & 0xFF)) << FBITN_PF;
+	}
+	if(_mask & FMASK_AF) {
+		bool af;
+		switch(m_lf.op) {
+			case LF_INC: af = ((res & 0x0f) == 0); break;
+			case LF_DEC: af = ((res & 0x0f) == 0x0f); break;
+			case LF_LOGIC: af = false; break; // unknown
+			default: af = ((op1 ^ op2) ^ res) & 0x10; break;
+		}
+		flags |= uint32_t(af) << FBITN_AF;
+	}
+	if(_mask & FMASK_ZF) {
+		flags |= uint32_t(res == 0) << FBITN_ZF;
+	}
+	if(_mask & FMASK_SF) {
+		flags |= uint32_t(bool(res & msb)) << FBITN_SF;
+	}
+	if(_mask & FMASK_OF) {
+		bool of;
+		switch(m_lf.op) {
+			case LF_ADD:
+			case LF_ADC: of = ((op1 ^ op2 ^ msb) & (res ^ op2)) & msb; break;
+			case LF_SUB:
+			case LF_SBB: of = ((op1 ^ op2) & (op1 ^ res)) & msb; break;
+			case LF_INC: of = (res == msb); break;
+			case LF_DEC: of = (res == msb - 1); break;
+			default: of = false; break;
+		}
+		flags |= uint32_t(of) << FBITN_OF;
+	}
+
+	return flags;
+}
+
 #endif
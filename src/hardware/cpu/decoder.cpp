@@ -22,11 +22,129 @@
 #include "core.h"
 #include "../memory.h"
 #include "hardware/cpu.h"
+#include "executor.h"
 
 CPUDecoder g_cpudecoder;
 
 
+CPUDecoder::CPUDecoder()
+{
+	flush_cache();
+}
+
+void CPUDecoder::flush_cache()
+{
+	for(auto &block : m_cache) {
+		block.phy = ~0;
+		block.count = 0;
+	}
+	m_block = nullptr;
+	m_fn = nullptr;
+}
+
+bool CPUDecoder::cache_phy(uint32_t _cseip, uint32_t &_phy) const
+{
+	// the physical address must be known without side effects
+	if(IS_PAGING()) {
+		if(!g_cpummu.TLB_probe(_cseip, IS_USER_PL, _phy)) {
+			return false;
+		}
+	} else {
+		_phy = _cseip;
+	}
+	_phy &= g_memory.address_mask();
+	return g_memory.is_static(_phy);
+}
+
+CPUDecoder::Block * CPUDecoder::new_block(uint32_t _phy)
+{
+	Block *block = &m_cache[(_phy ^ (_phy >> 12)) & (CPU_DECODE_CACHE_SIZE-1)];
+	block->phy = _phy;
+	block->big = REG_CS.desc.big;
+	block->seq = g_cpubus.pq_seq();
+	block->count = 0;
+	m_block_pos = 0;
+	return block;
+}
+
 Instruction * CPUDecoder::decode()
+{
+#if CPU_DECODE_CACHE
+	Block *block = nullptr;
+	uint32_t cseip = g_cpubus.cseip();
+	uint32_t phy = m_block_phy;
+	if(m_block && cseip == m_block_cseip) {
+		// the execution continues in sequence
+		block = m_block;
+	} else if(cache_phy(cseip, phy)) {
+		block = &m_cache[(phy ^ (phy >> 12)) & (CPU_DECODE_CACHE_SIZE-1)];
+		if(block->phy != phy) {
+			block = new_block(phy);
+		}
+		m_block_pos = 0;
+	}
+	m_block = nullptr;
+	m_fn = nullptr;
+	if(block) {
+		if(block->big != REG_CS.desc.big || block->seq < g_memory.page_write_seq(phy)) {
+			// the page has been written, start over from here
+			block = new_block(phy);
+		}
+		if(m_block_pos < block->count) {
+			Instruction *instr = &block->instr[m_block_pos];
+			if(!g_cpubus.pq_match(instr->bytes, instr->size)) {
+				// the queue holds bytes fetched before a write
+				block = nullptr;
+			} else {
+				uint32_t eip = g_cpubus.eip();
+				// the prefetch queue must be updated as if the bytes were decoded
+				g_cpubus.skip(instr->size);
+				m_instr = *instr;
+				m_instr.eip = eip;
+				m_instr.cseip = cseip;
+				m_fn = block->fn[m_block_pos];
+				phy += instr->size;
+				if(PAGE_OFFSET(phy)) {
+					m_block = block;
+					m_block_pos++;
+					m_block_cseip = cseip + instr->size;
+					m_block_phy = phy;
+				}
+				return &m_instr;
+			}
+		}
+	}
+	uint64_t seq = g_cpubus.pq_seq();
+#endif
+
+	decode_instr();
+
+#if CPU_DECODE_CACHE
+	// append to the block only if the bytes haven't been modified after they
+	// were fetched and all of them were fetched
+	if(block && block->count < CPU_DECODE_BLOCK_SIZE &&
+	   !g_cpuexecutor.fault_pending() && m_instr.size <= CPU_MAX_INSTR_SIZE &&
+	   PAGE_OFFSET(phy) + m_instr.size <= 0x1000 &&
+	   g_memory.page_write_seq(phy) <= seq)
+	{
+		m_fn = g_cpuexecutor.get_fn(m_instr);
+		block->instr[block->count] = m_instr;
+		block->fn[block->count] = m_fn;
+		block->count++;
+		phy += m_instr.size;
+		if(PAGE_OFFSET(phy)) {
+			m_block = block;
+			m_block_pos = block->count;
+			m_block_cseip = cseip + m_instr.size;
+			m_block_phy = phy;
+		}
+	}
+#endif
+
+	return &m_instr;
+}
+
+void CPUDecoder::decode_instr()
 {
 	uint8_t opcode;
 	unsigned cycles_table = CTB_IDX_NONE;
@@ -158,8 +276,6 @@ restart_opcode:
 	}
 	m_instr.cycles = ms_cycles[cycles_table][cycles_op*CPU_COUNT + (CPU_FAMILY-CPU_286)];
 	m_instr.size = m_ilen;
-
-	return &m_instr;
 }
 
 void CPUDecoder::illegal_opcode()
@@ -26,10 +26,16 @@
 
 #define CPU_MAX_INSTR_SIZE 15
 
+#define CPU_DECODE_CACHE      CPU_USE_PQ
+#define CPU_DECODE_CACHE_SIZE 512 // number of blocks, must be a power of 2
+#define CPU_DECODE_BLOCK_SIZE 16  // max number of instructions in a block
+
 class CPUExecutor;
 class CPUDecoder;
 extern CPUDecoder g_cpudecoder;
 
+typedef void (CPUExecutor::*CPUExecutorFnPtr)();
+
 #if 1
 #define ILLEGAL_286           \
 	if(CPU_FAMILY<=CPU_286) { \
@@ -155,6 +161,33 @@ private:
 	uint32_t m_ilen;
 	Instruction m_instr;
 
+	/* Decoded instructions cache, made of blocks of instructions executed in
+	 * sequence, indexed by the physical address of their first instruction.
+	 * A block grows while the execution flows through it and ends at the end
+	 * of its page. Along with the instructions it stores their executor
+	 * functions already resolved (see CPUExecutor::get_fn()).
+	 * Blocks are valid as long as their memory page is not written; every
+	 * instruction is still checked against the bytes already in the prefetch
+	 * queue.
+	 */
+	struct Block {
+		uint32_t phy;     // physical address of the first instruction
+		bool big;         // CS.big at decoding time
+		uint64_t seq;     // memory write sequence number at fetching time
+		unsigned count;   // number of instructions
+		Instruction instr[CPU_DECODE_BLOCK_SIZE];
+		CPUExecutorFnPtr fn[CPU_DECODE_BLOCK_SIZE];
+	};
+	Block m_cache[CPU_DECODE_CACHE_SIZE];
+	// the block of the last decoded instruction, if execution can continue
+	// with its next one
+	Block *m_block = nullptr;
+	unsigned m_block_pos = 0;   // index of the next instruction in m_block
+	uint32_t m_block_cseip = 0; // linear address of the next instruction
+	uint32_t m_block_phy = 0;   // physical address of the next instruction
+	// the executor function of the last decoded instruction, if resolved
+	CPUExecutorFnPtr m_fn = nullptr;
+
 	enum CyclesTableIndex {
 		CTB_IDX_NONE,
 		CTB_IDX_0F,
@@ -197,13 +230,29 @@ private:
 	static const Cycles * ms_cycles[CTB_COUNT];
 
 public:
+	CPUDecoder();
+
 	Instruction * decode();
+	void flush_cache();
+	// Stops the current block, to be called when the address translation
+	// changes.
+	inline void break_block() {
+		m_block = nullptr;
+	}
+	// The executor function of the last decoded instruction, or nullptr if it
+	// must be resolved by the executor.
+	inline CPUExecutorFnPtr decoded_fn() const {
+		return m_fn;
+	}
 	inline uint32_t get_next_cseip() {
 		//return the linear address of the next decoded instruction
 		return g_cpubus.cseip();
 	}
 
 private:
+	void decode_instr();
+	bool cache_phy(uint32_t _cseip, uint32_t &_phy) const;
+	Block * new_block(uint32_t _phy);
 	void prefix_none(uint8_t _opcode, unsigned &ctb_idx_, unsigned &ctb_op_);
 	void prefix_none_32(uint8_t _opcode, unsigned &ctb_idx_, unsigned &ctb_op_);
 	void prefix_0F(uint8_t _opcode, unsigned &ctb_idx_, unsigned &ctb_op_);
@@ -213,10 +262,8 @@ private:
 
 	inline uint8_t fetchb() {
 		uint8_t b = g_cpubus.fetchb();
-		if(CPULOG && (CPULOG_WRITE_HEX || CPULOG_WRITE_DISASM)) {
-			if(m_ilen < CPU_MAX_INSTR_SIZE) {
-				m_instr.bytes[m_ilen] = b;
-			}
+		if(m_ilen < CPU_MAX_INSTR_SIZE) {
+			m_instr.bytes[m_ilen] = b;
 		}
 		m_ilen += 1;
 		return b;
@@ -224,10 +271,8 @@ private:
 
 	inline uint16_t fetchw() {
 		uint16_t w = g_cpubus.fetchw();
-		if(CPULOG && (CPULOG_WRITE_HEX || CPULOG_WRITE_DISASM)) {
-			if(m_ilen+1 < CPU_MAX_INSTR_SIZE) {
-				*(uint16_t*)(&m_instr.bytes[m_ilen]) = w;
-			}
+		if(m_ilen+1 < CPU_MAX_INSTR_SIZE) {
+			*(uint16_t*)(&m_instr.bytes[m_ilen]) = w;
 		}
 		m_ilen += 2;
 		return w;
@@ -235,10 +280,8 @@ private:
 
 	inline uint32_t fetchdw() {
 		uint32_t dw = g_cpubus.fetchdw();
-		if(CPULOG && (CPULOG_WRITE_HEX || CPULOG_WRITE_DISASM)) {
-			if(m_ilen+3 < CPU_MAX_INSTR_SIZE) {
-				*(uint32_t*)(&m_instr.bytes[m_ilen]) = dw;
-			}
+		if(m_ilen+3 < CPU_MAX_INSTR_SIZE) {
+			*(uint32_t*)(&m_instr.bytes[m_ilen]) = dw;
 		}
 		m_ilen += 4;
 		return dw;
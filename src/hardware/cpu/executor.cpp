@@ -59,6 +59,9 @@ void CPUExecutor::reset(uint _signal)
 {
 	m_instr = nullptr;
 	m_reset = true;
+	m_fault = CPUException();
+	m_fault_rollback = false;
+	m_abort_faults = false;
 	m_base_ds = REGI_DS;
 	m_base_ss = REGI_SS;
 
@@ -74,12 +77,25 @@ void CPUExecutor::config_changed()
 {
 	if(CPU_FAMILY <= CPU_286) {
 		m_max_instr_size = 10;
+		m_functions = ms_functions<CPU_286>;
 	} else {
 		m_max_instr_size = 15;
+		m_functions = ms_functions<CPU_386>;
 	}
 }
 
-void CPUExecutor::execute(Instruction * _instr)
+CPUExecutor::FnPtr CPUExecutor::get_fn(const Instruction &_instr) const
+{
+	if(_instr.rep && rep_string_op(_instr.opcode)) {
+		if(_instr.addr32) {
+			return &CPUExecutor::rep_32;
+		}
+		return &CPUExecutor::rep_16;
+	}
+	return m_functions[ec_to_i(_instr.fn)];
+}
+
+void CPUExecutor::execute(Instruction * _instr, FnPtr _fn)
 {
 	m_instr = _instr;
 
@@ -110,7 +126,8 @@ void CPUExecutor::execute(Instruction * _instr)
 		// Priority 7:
 		//  Code-Segment Limit Violation
 		PERRF(LOG_CPU, "CS limit violation!\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 
 	/* All IA-32 processors manage the RF flag as follows. The RF Flag is
@@ -124,7 +141,9 @@ void CPUExecutor::execute(Instruction * _instr)
 	if(m_instr->fn == CPUExecutorFn::INVALID) {
 		// Priority 8:
 		//   Illegal opcode
-		illegal_opcode();
+		log_illegal_opcode();
+		raise_fault(CPU_UD_EXC, 0);
+		return;
 	}
 
 	if(m_instr->size > m_max_instr_size) {
@@ -134,7 +153,8 @@ void CPUExecutor::execute(Instruction * _instr)
 		 * greater than 10 (286) or 15 (386+) bytes in length, it generates
 		 * an exception #13 (General Protection Violation)
 		 */
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 
 	if(UNLIKELY(m_instr->lock)) {
@@ -142,7 +162,8 @@ void CPUExecutor::execute(Instruction * _instr)
 		// #GP(O) if the current privilege level is bigger (less privileged)
 		// than the I/O privilege level.
 		if(CPU_FAMILY==CPU_286 && IS_PMODE() && CPL>FLAG_IOPL) {
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return;
 		}
 	}
 
@@ -158,22 +179,16 @@ void CPUExecutor::execute(Instruction * _instr)
 			m_base_ss = REGI_SS;
 		}
 
-		exec_fn = ms_functions[ec_to_i(m_instr->fn)];
+		exec_fn = _fn ? _fn : get_fn(*m_instr);
 
 		if(m_instr->addr32) {
 			EA_get_segreg = &CPUExecutor::EA_get_segreg_32;
 			EA_get_offset = &CPUExecutor::EA_get_offset_32;
 			m_addr_mask = 0xFFFFFFFF;
-			if(m_instr->rep && rep_string_op(m_instr->opcode)) {
-				exec_fn = &CPUExecutor::rep_32;
-			}
 		} else {
 			EA_get_segreg = &CPUExecutor::EA_get_segreg_16;
 			EA_get_offset = &CPUExecutor::EA_get_offset_16;
 			m_addr_mask = 0xFFFF;
-			if(m_instr->rep && rep_string_op(m_instr->opcode)) {
-				exec_fn = &CPUExecutor::rep_16;
-			}
 		}
 
 		m_reset = false;
@@ -181,34 +196,75 @@ void CPUExecutor::execute(Instruction * _instr)
 
 	(this->*exec_fn)();
 
+	if(UNLIKELY(fault_pending())) {
+		return;
+	}
 	if(m_instr && !m_instr->rep) {
 		COMMIT_EIP();
 	}
 }
 
+void CPUExecutor::abort_fault(const CPUException &_fault)
+{
+	if(!m_abort_faults) {
+		throw _fault;
+	}
+	if(!fault_pending()) {
+		m_fault = _fault;
+		m_fault_core = g_cpucore;
+		m_fault_rollback = true;
+	}
+}
+
+void CPUExecutor::fault_rollback()
+{
+	// undo what the instruction did after the fault, as if it was thrown
+	uint32_t cr0 = REG_CR0, cr3 = REG_CR3;
+	g_cpucore = m_fault_core;
+	if(cr0 != REG_CR0 || cr3 != REG_CR3) {
+		g_cpubus.enable_paging(IS_PAGING());
+		g_cpummu.TLB_flush();
+	}
+	m_fault_rollback = false;
+}
+
 void CPUExecutor::rep_16()
 {
 	if(REG_CX == 0) {
 		return;
 	}
 
-	try {
-		// Perform the string operation once.
-		(this->*(ms_functions[ec_to_i(m_instr->fn)]))();
-	} catch(CPUException &e) {
-		/* A repeating string operation can be suspended by an exception.
-		 * 1. The source and destination registers point to the next string
-		 * elements to be operated on
-		 * 2. The EIP register points to the string instruction
-		 * 3. The ECX register has the value it held following the last
-		 * successful iteration of the instruction.
-		 */
-		RESTORE_EIP();
-		throw;
+	// Perform as many iterations as possible directly on system RAM.
+	uint32_t count = 0;
+	if(m_rep_bulk_max) {
+		count = rep_bulk(REG_CX);
 	}
+	if(count) {
+		REG_CX -= count;
+	} else {
+		try {
+			// Perform the string operation once.
+			(this->*(m_functions[ec_to_i(m_instr->fn)]))();
+		} catch(CPUException &e) {
+			/* A repeating string operation can be suspended by an exception.
+			 * 1. The source and destination registers point to the next string
+			 * elements to be operated on
+			 * 2. The EIP register points to the string instruction
+			 * 3. The ECX register has the value it held following the last
+			 * successful iteration of the instruction.
+			 */
+			RESTORE_EIP();
+			throw;
+		}
+		if(UNLIKELY(fault_pending())) {
+			// same as above, for faults raised without unwinding
+			RESTORE_EIP();
+			return;
+		}
 
-	// Decrement CX by 1; no flags are modified.
-	REG_CX -= 1;
+		// Decrement CX by 1; no flags are modified.
+		REG_CX -= 1;
+	}
 	if(REG_CX == 0) {
 		// REP finished and IP points to the next instr.
 		COMMIT_EIP();
@@ -242,14 +298,26 @@ void CPUExecutor::rep_32()
 		return;
 	}
 
-	try {
-		(this->*(ms_functions[ec_to_i(m_instr->fn)]))();
-	} catch(CPUException &e) {
-		RESTORE_EIP();
-		throw;
+	uint32_t count = 0;
+	if(m_rep_bulk_max) {
+		count = rep_bulk(REG_ECX);
 	}
+	if(count) {
+		REG_ECX -= count;
+	} else {
+		try {
+			(this->*(m_functions[ec_to_i(m_instr->fn)]))();
+		} catch(CPUException &e) {
+			RESTORE_EIP();
+			throw;
+		}
+		if(UNLIKELY(fault_pending())) {
+			RESTORE_EIP();
+			return;
+		}
 
-	REG_ECX -= 1;
+		REG_ECX -= 1;
+	}
 	if(REG_ECX == 0) {
 		COMMIT_EIP();
 		return;
@@ -268,6 +336,12 @@ void CPUExecutor::rep_32()
 }
 
 void CPUExecutor::illegal_opcode()
+{
+	log_illegal_opcode();
+	throw CPUException(CPU_UD_EXC, 0);
+}
+
+void CPUExecutor::log_illegal_opcode()
 {
 	char buf[CPU_MAX_INSTR_SIZE * 2 + 1];
 	char * writecode = buf;
@@ -277,7 +351,6 @@ void CPUExecutor::illegal_opcode()
 		writecode += 2;
 	}
 	PDEBUGF(LOG_V2, LOG_CPU, "Illegal opcode: %s\n", buf);
-	throw CPUException(CPU_UD_EXC, 0);
 }
 
 uint64_t CPUExecutor::fetch_descriptor(Selector & _selector, uint8_t _exc_vec)
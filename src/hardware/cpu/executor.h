@@ -61,6 +61,9 @@ public:
 	uint32_t m_addr_mask = 0xFFFF;
 	unsigned m_max_instr_size = 10;
 
+	using FnPtr = void (CPUExecutor::*)();
+	const FnPtr *m_functions = ms_functions<CPU_286>; // the current CPU family's functions
+
 	inttrap_intervalTree_t m_inttraps_tree;
 	std::vector<inttrap_interval_t> m_inttraps_intervals;
 	//TODO change this map to a stack
@@ -78,6 +81,22 @@ public:
 		unsigned pages;
 	} m_cached_phy = {};
 
+	// REP string operations executed in bulk (see executor/string.cpp)
+	uint32_t m_rep_bulk_max = 0;   // max iterations the current step can execute
+	uint32_t m_rep_bulk_count = 0; // iterations executed in bulk by the current step
+
+	// Fault raised without unwinding by the current instruction (see raise_fault())
+	CPUException m_fault;
+	/* Page faults of the instruction being decoded or executed are raised with
+	 * abort_fault(), which saves the core state. The instruction continues
+	 * with dummy values, but every following memory access is suppressed, and
+	 * the core is rolled back when the fault is taken.
+	 */
+	bool m_abort_faults = false;
+	bool m_fault_rollback = false;
+	CPUCore m_fault_core;
+	void fault_rollback();
+
 	uint8_t load_eb();
 	uint8_t load_rb();
 	uint16_t load_ew();
@@ -113,12 +132,19 @@ public:
 	void write_flags(uint16_t _flags);
 	void write_eflags(uint32_t _eflags, bool _change_IOPL, bool _change_IF, bool _change_NT, bool _change_VM);
 
+	/* The *_check functions throw the CPU exception, while the *_test ones
+	 * raise it with raise_fault() and return false, so that instruction
+	 * handlers can return early without unwinding.
+	 */
 	void seg_check(SegReg & _seg, uint32_t _offset, unsigned _len, bool _write, uint8_t _vector=CPU_INVALID_INT, uint16_t _errcode=0);
-	void seg_check_read(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode);
-	void seg_check_write(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode);
+	bool seg_test(SegReg & _seg, uint32_t _offset, unsigned _len, bool _write, uint8_t _vector=CPU_INVALID_INT, uint16_t _errcode=0);
+	bool seg_test_read(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode);
+	bool seg_test_write(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode);
 	void io_check(uint16_t _port, unsigned _len);
+	bool io_test(uint16_t _port, unsigned _len);
 
-	void mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write);
+	// Returns false if a fault is pending (see abort_fault()).
+	bool mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write);
 
 	uint8_t  read_byte();
 	uint16_t read_word();
@@ -205,10 +231,10 @@ public:
 	uint16_t AND_w(uint16_t op1, uint16_t op2);
 	uint32_t AND_d(uint32_t op1, uint32_t op2);
 
-	void BT_w(uint32_t _op1, uint16_t _op2);
-	void BT_d(uint64_t _op1, uint32_t _op2);
-	uint16_t BT_ew(uint16_t _op2, bool _rmw);
-	uint32_t BT_ed(uint32_t _op2, bool _rmw);
+	template<unsigned F> void BT_w(uint32_t _op1, uint16_t _op2);
+	template<unsigned F> void BT_d(uint64_t _op1, uint32_t _op2);
+	template<unsigned F> uint16_t BT_ew(uint16_t _op2, bool _rmw);
+	template<unsigned F> uint32_t BT_ed(uint32_t _op2, bool _rmw);
 
 	void CMP_b(uint8_t op1, uint8_t op2);
 	void CMP_w(uint16_t op1, uint16_t op2);
@@ -217,8 +243,8 @@ public:
 	uint16_t DEC_w(uint16_t _op1);
 	uint32_t DEC_d(uint32_t _op1);
 
-	int16_t IMUL_w(int16_t op1, int16_t op2);
-	int32_t IMUL_d(int32_t op1, int32_t op2);
+	template<unsigned F> int16_t IMUL_w(int16_t op1, int16_t op2);
+	template<unsigned F> int32_t IMUL_d(int32_t op1, int32_t op2);
 
 	void INSB(uint32_t _offset);
 	void INSW(uint32_t _offset);
@@ -254,30 +280,30 @@ public:
 	void OUTSW(uint16_t _value);
 	void OUTSD(uint32_t _value);
 
-	uint8_t  ROL_b(uint8_t  _op1, uint8_t _count);
-	uint16_t ROL_w(uint16_t _op1, uint8_t _count);
-	uint32_t ROL_d(uint32_t _op1, uint8_t _count);
-	uint8_t  ROR_b(uint8_t  _op1, uint8_t _count);
-	uint16_t ROR_w(uint16_t _op1, uint8_t _count);
-	uint32_t ROR_d(uint32_t _op1, uint8_t _count);
-	uint8_t  RCL_b(uint8_t  _op1, uint8_t _count);
-	uint16_t RCL_w(uint16_t _op1, uint8_t _count);
-	uint32_t RCL_d(uint32_t _op1, uint8_t _count);
-	uint8_t  RCR_b(uint8_t  _op1, uint8_t _count);
-	uint16_t RCR_w(uint16_t _op1, uint8_t _count);
-	uint32_t RCR_d(uint32_t _op1, uint8_t _count);
-
-	uint8_t  SHL_b(uint8_t  _op1, uint8_t _count);
-	uint16_t SHL_w(uint16_t _op1, uint8_t _count);
-	uint32_t SHL_d(uint32_t _op1, uint8_t _count);
-	uint8_t  SHR_b(uint8_t  _op1, uint8_t _count);
-	uint16_t SHR_w(uint16_t _op1, uint8_t _count);
-	uint32_t SHR_d(uint32_t _op1, uint8_t _count);
-	uint8_t  SAR_b(uint8_t  _op1, uint8_t _count);
-	uint16_t SAR_w(uint16_t _op1, uint8_t _count);
-	uint32_t SAR_d(uint32_t _op1, uint8_t _count);
-
-	void SDT(unsigned _reg);
+	template<unsigned F> uint8_t  ROL_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t ROL_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t ROL_d(uint32_t _op1, uint8_t _count);
+	template<unsigned F> uint8_t  ROR_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t ROR_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t ROR_d(uint32_t _op1, uint8_t _count);
+	template<unsigned F> uint8_t  RCL_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t RCL_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t RCL_d(uint32_t _op1, uint8_t _count);
+	template<unsigned F> uint8_t  RCR_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t RCR_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t RCR_d(uint32_t _op1, uint8_t _count);
+
+	template<unsigned F> uint8_t  SHL_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t SHL_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t SHL_d(uint32_t _op1, uint8_t _count);
+	template<unsigned F> uint8_t  SHR_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t SHR_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t SHR_d(uint32_t _op1, uint8_t _count);
+	template<unsigned F> uint8_t  SAR_b(uint8_t  _op1, uint8_t _count);
+	template<unsigned F> uint16_t SAR_w(uint16_t _op1, uint8_t _count);
+	template<unsigned F> uint32_t SAR_d(uint32_t _op1, uint8_t _count);
+
+	template<unsigned F> void SDT(unsigned _reg);
 
 	uint16_t SHLD_w(uint16_t _op1, uint16_t _op2, uint8_t _count);
 	uint32_t SHLD_d(uint32_t _op1, uint32_t _op2, uint8_t _count);
@@ -304,6 +330,26 @@ public:
 	void rep_16();
 	void rep_32();
 	void illegal_opcode();
+	void log_illegal_opcode();
+
+	inline void raise_fault(uint8_t _vector, uint16_t _errcode) {
+		if(!fault_pending()) {
+			m_fault = CPUException(_vector, _errcode);
+		}
+	}
+
+	uint32_t rep_bulk(uint32_t _count);
+	uint8_t * rep_bulk_ptr(SegReg &_seg, uint32_t _offset, unsigned _size, bool _write,
+			uint32_t &_count, uint32_t &_phy);
+	void rep_bulk_advance(unsigned _reg, uint32_t _bytes);
+	template<typename T> uint32_t rep_bulk_movs(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_stos(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_lods(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_scas(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_cmps(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_ins(uint32_t _count);
+	template<typename T> uint32_t rep_bulk_outs(uint32_t _count);
+	template<typename T> void rep_bulk_cmp(T _op1, T _op2);
 
 public:
 
@@ -312,9 +358,29 @@ public:
 	void reset(uint _signal);
 	void config_changed();
 
-	void execute(Instruction * _instr);
+	// _fn is the function of _instr if already known (see get_fn())
+	void execute(Instruction * _instr, FnPtr _fn = nullptr);
+	FnPtr get_fn(const Instruction &_instr) const;
 	Instruction * get_current_instruction() { return m_instr; }
 
+	// A fault raised by execute() must be delivered by the caller
+	inline bool fault_pending() const { return m_fault.vector != CPU_INVALID_INT; }
+	inline CPUException take_fault() {
+		CPUException fault = m_fault;
+		m_fault = CPUException();
+		if(m_fault_rollback) {
+			fault_rollback();
+		}
+		return fault;
+	}
+	// Faults in the middle of an instruction are thrown if not enabled (eg.
+	// during the delivery of interrupts and exceptions).
+	inline void enable_abort_faults(bool _enabled) { m_abort_faults = _enabled; }
+	void abort_fault(const CPUException &_fault);
+
+	inline void rep_bulk_setup(uint32_t _max) { m_rep_bulk_max = _max; m_rep_bulk_count = 0; }
+	inline uint32_t rep_bulk_count() const { return m_rep_bulk_count; }
+
 	void interrupt(uint8_t _vector);
 	void interrupt_pmode(uint8_t _vector, bool _soft_int,
 			bool _push_error, uint16_t _error_code);
@@ -328,10 +394,10 @@ private:
 
 	void INVALID() {}
 
-	void AAA();
-	void AAD();
-	void AAM();
-	void AAS();
+	template<unsigned F> void AAA();
+	template<unsigned F> void AAD();
+	template<unsigned F> void AAM();
+	template<unsigned F> void AAS();
 
 	void ADC_eb_rb();
 	void ADC_ew_rw();
@@ -389,25 +455,25 @@ private:
 	void BSR_rw_ew();
 	void BSR_rd_ed();
 
-	void BT_ew_rw();
-	void BT_ed_rd();
-	void BT_ew_ib();
-	void BT_ed_ib();
+	template<unsigned F> void BT_ew_rw();
+	template<unsigned F> void BT_ed_rd();
+	template<unsigned F> void BT_ew_ib();
+	template<unsigned F> void BT_ed_ib();
 
-	void BTC_ew_rw();
-	void BTC_ed_rd();
-	void BTC_ew_ib();
-	void BTC_ed_ib();
+	template<unsigned F> void BTC_ew_rw();
+	template<unsigned F> void BTC_ed_rd();
+	template<unsigned F> void BTC_ew_ib();
+	template<unsigned F> void BTC_ed_ib();
 
-	void BTR_ew_rw();
-	void BTR_ed_rd();
-	void BTR_ew_ib();
-	void BTR_ed_ib();
+	template<unsigned F> void BTR_ew_rw();
+	template<unsigned F> void BTR_ed_rd();
+	template<unsigned F> void BTR_ew_ib();
+	template<unsigned F> void BTR_ed_ib();
 
-	void BTS_ew_rw();
-	void BTS_ed_rd();
-	void BTS_ew_ib();
-	void BTS_ed_ib();
+	template<unsigned F> void BTS_ew_rw();
+	template<unsigned F> void BTS_ed_rd();
+	template<unsigned F> void BTS_ew_ib();
+	template<unsigned F> void BTS_ed_ib();
 
 	void CALL_rel16();
 	void CALL_rel32();
@@ -452,8 +518,8 @@ private:
 	void CMPSD_a16();
 	void CMPSD_a32();
 
-	void DAA();
-	void DAS();
+	template<unsigned F> void DAA();
+	template<unsigned F> void DAS();
 
 	void DIV_eb();
 	void DIV_ew();
@@ -476,15 +542,15 @@ private:
 	void IDIV_ew();
 	void IDIV_ed();
 
-	void IMUL_eb();
-	void IMUL_ew();
-	void IMUL_ed();
-	void IMUL_rw_ew();
-	void IMUL_rd_ed();
-	void IMUL_rw_ew_ib();
-	void IMUL_rd_ed_ib();
-	void IMUL_rw_ew_iw();
-	void IMUL_rd_ed_id();
+	template<unsigned F> void IMUL_eb();
+	template<unsigned F> void IMUL_ew();
+	template<unsigned F> void IMUL_ed();
+	template<unsigned F> void IMUL_rw_ew();
+	template<unsigned F> void IMUL_rd_ed();
+	template<unsigned F> void IMUL_rw_ew_ib();
+	template<unsigned F> void IMUL_rd_ed_ib();
+	template<unsigned F> void IMUL_rw_ew_iw();
+	template<unsigned F> void IMUL_rd_ed_id();
 
 	void IN_AL_ib();
 	void IN_AL_DX();
@@ -511,7 +577,7 @@ private:
 	void INT_ib();
 	void INTO();
 
-	void IRET();
+	template<unsigned F> void IRET();
 	void IRETD();
 
 	void JO_cb();
@@ -672,9 +738,9 @@ private:
 	void MOVZX_rd_eb();
 	void MOVZX_rd_ew();
 
-	void MUL_eb();
-	void MUL_ew();
-	void MUL_ed();
+	template<unsigned F> void MUL_eb();
+	template<unsigned F> void MUL_ew();
+	template<unsigned F> void MUL_ed();
 
 	void NEG_eb();
 	void NEG_ew();
@@ -743,75 +809,75 @@ private:
 	void PUSHF();
 	void PUSHFD();
 
-	void ROL_eb_ib();
-	void ROL_ew_ib();
-	void ROL_ed_ib();
-	void ROL_eb_1();
-	void ROL_ew_1();
-	void ROL_ed_1();
-	void ROL_eb_CL();
-	void ROL_ew_CL();
-	void ROL_ed_CL();
-	void ROR_eb_ib();
-	void ROR_ew_ib();
-	void ROR_ed_ib();
-	void ROR_eb_1();
-	void ROR_ew_1();
-	void ROR_ed_1();
-	void ROR_eb_CL();
-	void ROR_ew_CL();
-	void ROR_ed_CL();
-	void RCL_eb_ib();
-	void RCL_ew_ib();
-	void RCL_ed_ib();
-	void RCL_eb_1();
-	void RCL_ew_1();
-	void RCL_ed_1();
-	void RCL_eb_CL();
-	void RCL_ew_CL();
-	void RCL_ed_CL();
-	void RCR_eb_ib();
-	void RCR_ew_ib();
-	void RCR_ed_ib();
-	void RCR_eb_1();
-	void RCR_ew_1();
-	void RCR_ed_1();
-	void RCR_eb_CL();
-	void RCR_ew_CL();
-	void RCR_ed_CL();
+	template<unsigned F> void ROL_eb_ib();
+	template<unsigned F> void ROL_ew_ib();
+	template<unsigned F> void ROL_ed_ib();
+	template<unsigned F> void ROL_eb_1();
+	template<unsigned F> void ROL_ew_1();
+	template<unsigned F> void ROL_ed_1();
+	template<unsigned F> void ROL_eb_CL();
+	template<unsigned F> void ROL_ew_CL();
+	template<unsigned F> void ROL_ed_CL();
+	template<unsigned F> void ROR_eb_ib();
+	template<unsigned F> void ROR_ew_ib();
+	template<unsigned F> void ROR_ed_ib();
+	template<unsigned F> void ROR_eb_1();
+	template<unsigned F> void ROR_ew_1();
+	template<unsigned F> void ROR_ed_1();
+	template<unsigned F> void ROR_eb_CL();
+	template<unsigned F> void ROR_ew_CL();
+	template<unsigned F> void ROR_ed_CL();
+	template<unsigned F> void RCL_eb_ib();
+	template<unsigned F> void RCL_ew_ib();
+	template<unsigned F> void RCL_ed_ib();
+	template<unsigned F> void RCL_eb_1();
+	template<unsigned F> void RCL_ew_1();
+	template<unsigned F> void RCL_ed_1();
+	template<unsigned F> void RCL_eb_CL();
+	template<unsigned F> void RCL_ew_CL();
+	template<unsigned F> void RCL_ed_CL();
+	template<unsigned F> void RCR_eb_ib();
+	template<unsigned F> void RCR_ew_ib();
+	template<unsigned F> void RCR_ed_ib();
+	template<unsigned F> void RCR_eb_1();
+	template<unsigned F> void RCR_ew_1();
+	template<unsigned F> void RCR_ed_1();
+	template<unsigned F> void RCR_eb_CL();
+	template<unsigned F> void RCR_ew_CL();
+	template<unsigned F> void RCR_ed_CL();
 
 	void RET_near_o16();
 	void RET_near_o32();
 	void RET_far_o16();
 	void RET_far_o32();
 
-	void SAL_eb_ib();
-	void SAL_ew_ib();
-	void SAL_ed_ib();
-	void SAL_eb_1();
-	void SAL_ew_1();
-	void SAL_ed_1();
-	void SAL_eb_CL();
-	void SAL_ew_CL();
-	void SAL_ed_CL();
-	void SHR_eb_ib();
-	void SHR_ew_ib();
-	void SHR_ed_ib();
-	void SHR_eb_1();
-	void SHR_ew_1();
-	void SHR_ed_1();
-	void SHR_eb_CL();
-	void SHR_ew_CL();
-	void SHR_ed_CL();
-	void SAR_eb_ib();
-	void SAR_ew_ib();
-	void SAR_ed_ib();
-	void SAR_eb_1();
-	void SAR_ew_1();
-	void SAR_ed_1();
-	void SAR_eb_CL();
-	void SAR_ew_CL();
-	void SAR_ed_CL();
+	template<unsigned F> void SAL_eb_ib();
+	template<unsigned F> void SAL_ew_ib();
+	template<unsigned F> void SAL_ed_ib();
+	template<unsigned F> void SAL_eb_1();
+	template<unsigned F> void SAL_ew_1();
+	template<unsigned F> void SAL_ed_1();
+	template<unsigned F> void SAL_eb_CL();
+	template<unsigned F> void SAL_ew_CL();
+	template<unsigned F> void SAL_ed_CL();
+	template<unsigned F> void SHR_eb_ib();
+	template<unsigned F> void SHR_ew_ib();
+	template<unsigned F> void SHR_ed_ib();
+	template<unsigned F> void SHR_eb_1();
+	template<unsigned F> void SHR_ew_1();
+	template<unsigned F> void SHR_ed_1();
+	template<unsigned F> void SHR_eb_CL();
+	template<unsigned F> void SHR_ew_CL();
+	template<unsigned F> void SHR_ed_CL();
+	template<unsigned F> void SAR_eb_ib();
+	template<unsigned F> void SAR_ew_ib();
+	template<unsigned F> void SAR_ed_ib();
+	template<unsigned F> void SAR_eb_1();
+	template<unsigned F> void SAR_ew_1();
+	template<unsigned F> void SAR_ed_1();
+	template<unsigned F> void SAR_eb_CL();
+	template<unsigned F> void SAR_ew_CL();
+	template<unsigned F> void SAR_ed_CL();
 
 	void SAHF();
 
@@ -856,8 +922,8 @@ private:
 	void SETLE_eb();
 	void SETNLE_eb();
 
-	void SGDT();
-	void SIDT();
+	template<unsigned F> void SGDT();
+	template<unsigned F> void SIDT();
 	void SLDT_ew();
 
 	void SHLD_ew_rw_ib();
@@ -940,14 +1006,15 @@ private:
 	void XOR_ed_ib();
 
 
-	using FnPtr = void (CPUExecutor::*)();
+	// one table per CPU family, family dependent functions are specialized
+	template<unsigned F>
 	static constexpr FnPtr ms_functions[] = {
 		&CPUExecutor::INVALID,
 
-		&CPUExecutor::AAA,
-		&CPUExecutor::AAD,
-		&CPUExecutor::AAM,
-		&CPUExecutor::AAS,
+		&CPUExecutor::AAA<F>,
+		&CPUExecutor::AAD<F>,
+		&CPUExecutor::AAM<F>,
+		&CPUExecutor::AAS<F>,
 
 		&CPUExecutor::ADC_eb_rb,
 		&CPUExecutor::ADC_ew_rw,
@@ -1005,25 +1072,25 @@ private:
 		&CPUExecutor::BSR_rw_ew,
 		&CPUExecutor::BSR_rd_ed,
 
-		&CPUExecutor::BT_ew_rw,
-		&CPUExecutor::BT_ed_rd,
-		&CPUExecutor::BT_ew_ib,
-		&CPUExecutor::BT_ed_ib,
+		&CPUExecutor::BT_ew_rw<F>,
+		&CPUExecutor::BT_ed_rd<F>,
+		&CPUExecutor::BT_ew_ib<F>,
+		&CPUExecutor::BT_ed_ib<F>,
 
-		&CPUExecutor::BTC_ew_rw,
-		&CPUExecutor::BTC_ed_rd,
-		&CPUExecutor::BTC_ew_ib,
-		&CPUExecutor::BTC_ed_ib,
+		&CPUExecutor::BTC_ew_rw<F>,
+		&CPUExecutor::BTC_ed_rd<F>,
+		&CPUExecutor::BTC_ew_ib<F>,
+		&CPUExecutor::BTC_ed_ib<F>,
 
-		&CPUExecutor::BTR_ew_rw,
-		&CPUExecutor::BTR_ed_rd,
-		&CPUExecutor::BTR_ew_ib,
-		&CPUExecutor::BTR_ed_ib,
+		&CPUExecutor::BTR_ew_rw<F>,
+		&CPUExecutor::BTR_ed_rd<F>,
+		&CPUExecutor::BTR_ew_ib<F>,
+		&CPUExecutor::BTR_ed_ib<F>,
 
-		&CPUExecutor::BTS_ew_rw,
-		&CPUExecutor::BTS_ed_rd,
-		&CPUExecutor::BTS_ew_ib,
-		&CPUExecutor::BTS_ed_ib,
+		&CPUExecutor::BTS_ew_rw<F>,
+		&CPUExecutor::BTS_ed_rd<F>,
+		&CPUExecutor::BTS_ew_ib<F>,
+		&CPUExecutor::BTS_ed_ib<F>,
 
 		&CPUExecutor::CALL_rel16,
 		&CPUExecutor::CALL_rel32,
@@ -1068,8 +1135,8 @@ private:
 		&CPUExecutor::CMPSD_a16,
 		&CPUExecutor::CMPSD_a32,
 
-		&CPUExecutor::DAA,
-		&CPUExecutor::DAS,
+		&CPUExecutor::DAA<F>,
+		&CPUExecutor::DAS<F>,
 
 		&CPUExecutor::DIV_eb,
 		&CPUExecutor::DIV_ew,
@@ -1092,15 +1159,15 @@ private:
 		&CPUExecutor::IDIV_ew,
 		&CPUExecutor::IDIV_ed,
 
-		&CPUExecutor::IMUL_eb,
-		&CPUExecutor::IMUL_ew,
-		&CPUExecutor::IMUL_ed,
-		&CPUExecutor::IMUL_rw_ew,
-		&CPUExecutor::IMUL_rd_ed,
-		&CPUExecutor::IMUL_rw_ew_ib,
-		&CPUExecutor::IMUL_rd_ed_ib,
-		&CPUExecutor::IMUL_rw_ew_iw,
-		&CPUExecutor::IMUL_rd_ed_id,
+		&CPUExecutor::IMUL_eb<F>,
+		&CPUExecutor::IMUL_ew<F>,
+		&CPUExecutor::IMUL_ed<F>,
+		&CPUExecutor::IMUL_rw_ew<F>,
+		&CPUExecutor::IMUL_rd_ed<F>,
+		&CPUExecutor::IMUL_rw_ew_ib<F>,
+		&CPUExecutor::IMUL_rd_ed_ib<F>,
+		&CPUExecutor::IMUL_rw_ew_iw<F>,
+		&CPUExecutor::IMUL_rd_ed_id<F>,
 
 		&CPUExecutor::IN_AL_ib,
 		&CPUExecutor::IN_AL_DX,
@@ -1127,7 +1194,7 @@ private:
 		&CPUExecutor::INT_ib,
 		&CPUExecutor::INTO,
 
-		&CPUExecutor::IRET,
+		&CPUExecutor::IRET<F>,
 		&CPUExecutor::IRETD,
 
 		&CPUExecutor::JO_cb,
@@ -1288,9 +1355,9 @@ private:
 		&CPUExecutor::MOVZX_rd_eb,
 		&CPUExecutor::MOVZX_rd_ew,
 
-		&CPUExecutor::MUL_eb,
-		&CPUExecutor::MUL_ew,
-		&CPUExecutor::MUL_ed,
+		&CPUExecutor::MUL_eb<F>,
+		&CPUExecutor::MUL_ew<F>,
+		&CPUExecutor::MUL_ed<F>,
 
 		&CPUExecutor::NEG_eb,
 		&CPUExecutor::NEG_ew,
@@ -1359,75 +1426,75 @@ private:
 		&CPUExecutor::PUSHF,
 		&CPUExecutor::PUSHFD,
 
-		&CPUExecutor::ROL_eb_ib,
-		&CPUExecutor::ROL_ew_ib,
-		&CPUExecutor::ROL_ed_ib,
-		&CPUExecutor::ROL_eb_1,
-		&CPUExecutor::ROL_ew_1,
-		&CPUExecutor::ROL_ed_1,
-		&CPUExecutor::ROL_eb_CL,
-		&CPUExecutor::ROL_ew_CL,
-		&CPUExecutor::ROL_ed_CL,
-		&CPUExecutor::ROR_eb_ib,
-		&CPUExecutor::ROR_ew_ib,
-		&CPUExecutor::ROR_ed_ib,
-		&CPUExecutor::ROR_eb_1,
-		&CPUExecutor::ROR_ew_1,
-		&CPUExecutor::ROR_ed_1,
-		&CPUExecutor::ROR_eb_CL,
-		&CPUExecutor::ROR_ew_CL,
-		&CPUExecutor::ROR_ed_CL,
-		&CPUExecutor::RCL_eb_ib,
-		&CPUExecutor::RCL_ew_ib,
-		&CPUExecutor::RCL_ed_ib,
-		&CPUExecutor::RCL_eb_1,
-		&CPUExecutor::RCL_ew_1,
-		&CPUExecutor::RCL_ed_1,
-		&CPUExecutor::RCL_eb_CL,
-		&CPUExecutor::RCL_ew_CL,
-		&CPUExecutor::RCL_ed_CL,
-		&CPUExecutor::RCR_eb_ib,
-		&CPUExecutor::RCR_ew_ib,
-		&CPUExecutor::RCR_ed_ib,
-		&CPUExecutor::RCR_eb_1,
-		&CPUExecutor::RCR_ew_1,
-		&CPUExecutor::RCR_ed_1,
-		&CPUExecutor::RCR_eb_CL,
-		&CPUExecutor::RCR_ew_CL,
-		&CPUExecutor::RCR_ed_CL,
+		&CPUExecutor::ROL_eb_ib<F>,
+		&CPUExecutor::ROL_ew_ib<F>,
+		&CPUExecutor::ROL_ed_ib<F>,
+		&CPUExecutor::ROL_eb_1<F>,
+		&CPUExecutor::ROL_ew_1<F>,
+		&CPUExecutor::ROL_ed_1<F>,
+		&CPUExecutor::ROL_eb_CL<F>,
+		&CPUExecutor::ROL_ew_CL<F>,
+		&CPUExecutor::ROL_ed_CL<F>,
+		&CPUExecutor::ROR_eb_ib<F>,
+		&CPUExecutor::ROR_ew_ib<F>,
+		&CPUExecutor::ROR_ed_ib<F>,
+		&CPUExecutor::ROR_eb_1<F>,
+		&CPUExecutor::ROR_ew_1<F>,
+		&CPUExecutor::ROR_ed_1<F>,
+		&CPUExecutor::ROR_eb_CL<F>,
+		&CPUExecutor::ROR_ew_CL<F>,
+		&CPUExecutor::ROR_ed_CL<F>,
+		&CPUExecutor::RCL_eb_ib<F>,
+		&CPUExecutor::RCL_ew_ib<F>,
+		&CPUExecutor::RCL_ed_ib<F>,
+		&CPUExecutor::RCL_eb_1<F>,
+		&CPUExecutor::RCL_ew_1<F>,
+		&CPUExecutor::RCL_ed_1<F>,
+		&CPUExecutor::RCL_eb_CL<F>,
+		&CPUExecutor::RCL_ew_CL<F>,
+		&CPUExecutor::RCL_ed_CL<F>,
+		&CPUExecutor::RCR_eb_ib<F>,
+		&CPUExecutor::RCR_ew_ib<F>,
+		&CPUExecutor::RCR_ed_ib<F>,
+		&CPUExecutor::RCR_eb_1<F>,
+		&CPUExecutor::RCR_ew_1<F>,
+		&CPUExecutor::RCR_ed_1<F>,
+		&CPUExecutor::RCR_eb_CL<F>,
+		&CPUExecutor::RCR_ew_CL<F>,
+		&CPUExecutor::RCR_ed_CL<F>,
 
 		&CPUExecutor::RET_near_o16,
 		&CPUExecutor::RET_near_o32,
 		&CPUExecutor::RET_far_o16,
 		&CPUExecutor::RET_far_o32,
 
-		&CPUExecutor::SAL_eb_ib,
-		&CPUExecutor::SAL_ew_ib,
-		&CPUExecutor::SAL_ed_ib,
-		&CPUExecutor::SAL_eb_1,
-		&CPUExecutor::SAL_ew_1,
-		&CPUExecutor::SAL_ed_1,
-		&CPUExecutor::SAL_eb_CL,
-		&CPUExecutor::SAL_ew_CL,
-		&CPUExecutor::SAL_ed_CL,
-		&CPUExecutor::SHR_eb_ib,
-		&CPUExecutor::SHR_ew_ib,
-		&CPUExecutor::SHR_ed_ib,
-		&CPUExecutor::SHR_eb_1,
-		&CPUExecutor::SHR_ew_1,
-		&CPUExecutor::SHR_ed_1,
-		&CPUExecutor::SHR_eb_CL,
-		&CPUExecutor::SHR_ew_CL,
-		&CPUExecutor::SHR_ed_CL,
-		&CPUExecutor::SAR_eb_ib,
-		&CPUExecutor::SAR_ew_ib,
-		&CPUExecutor::SAR_ed_ib,
-		&CPUExecutor::SAR_eb_1,
-		&CPUExecutor::SAR_ew_1,
-		&CPUExecutor::SAR_ed_1,
-		&CPUExecutor::SAR_eb_CL,
-		&CPUExecutor::SAR_ew_CL,
-		&CPUExecutor::SAR_ed_CL,
+		&CPUExecutor::SAL_eb_ib<F>,
+		&CPUExecutor::SAL_ew_ib<F>,
+		&CPUExecutor::SAL_ed_ib<F>,
+		&CPUExecutor::SAL_eb_1<F>,
+		&CPUExecutor::SAL_ew_1<F>,
+		&CPUExecutor::SAL_ed_1<F>,
+		&CPUExecutor::SAL_eb_CL<F>,
+		&CPUExecutor::SAL_ew_CL<F>,
+		&CPUExecutor::SAL_ed_CL<F>,
+		&CPUExecutor::SHR_eb_ib<F>,
+		&CPUExecutor::SHR_ew_ib<F>,
+		&CPUExecutor::SHR_ed_ib<F>,
+		&CPUExecutor::SHR_eb_1<F>,
+		&CPUExecutor::SHR_ew_1<F>,
+		&CPUExecutor::SHR_ed_1<F>,
+		&CPUExecutor::SHR_eb_CL<F>,
+		&CPUExecutor::SHR_ew_CL<F>,
+		&CPUExecutor::SHR_ed_CL<F>,
+		&CPUExecutor::SAR_eb_ib<F>,
+		&CPUExecutor::SAR_ew_ib<F>,
+		&CPUExecutor::SAR_ed_ib<F>,
+		&CPUExecutor::SAR_eb_1<F>,
+		&CPUExecutor::SAR_ew_1<F>,
+		&CPUExecutor::SAR_ed_1<F>,
+		&CPUExecutor::SAR_eb_CL<F>,
+		&CPUExecutor::SAR_ew_CL<F>,
+		&CPUExecutor::SAR_ed_CL<F>,
 
 		&CPUExecutor::SAHF,
 
@@ -1472,8 +1539,8 @@ private:
 		&CPUExecutor::SETLE_eb,
 		&CPUExecutor::SETNLE_eb,
 
-		&CPUExecutor::SGDT,
-		&CPUExecutor::SIDT,
+		&CPUExecutor::SGDT<F>,
+		&CPUExecutor::SIDT<F>,
 		&CPUExecutor::SLDT_ew,
 
 		&CPUExecutor::SHLD_ew_rw_ib,
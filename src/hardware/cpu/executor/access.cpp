@@ -20,7 +20,7 @@
 #include "ibmulator.h"
 #include "hardware/cpu/executor.h"
 
-void CPUExecutor::seg_check_read(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode)
+bool CPUExecutor::seg_test_read(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode)
 {
 	assert(_len!=0);
 
@@ -30,26 +30,31 @@ void CPUExecutor::seg_check_read(SegReg & _seg, uint32_t _offset, unsigned _len,
 			upper_limit = 0xFFFFFFFF;
 		}
 		if(_offset <= _seg.desc.limit || _offset > upper_limit || (upper_limit - _offset) < _len) {
-			PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): segment limit violation exp.down\n");
-			throw CPUException(_vector, _errcode);
+			PDEBUGF(LOG_V2, LOG_CPU, "seg_test_read(): segment limit violation exp.down\n");
+			raise_fault(_vector, _errcode);
+			return false;
 		}
 	} else if((_len-1) > _seg.desc.limit || _offset > (_seg.desc.limit-(_len-1))) {
-		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): segment limit violation\n");
-		throw CPUException(_vector, _errcode);
+		PDEBUGF(LOG_V2, LOG_CPU, "seg_test_read(): segment limit violation\n");
+		raise_fault(_vector, _errcode);
+		return false;
 	}
 	if(_seg.desc.is_code_segment() && !_seg.desc.is_readable()) {
-		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): execute only\n");
-		throw CPUException(_vector, _errcode);
+		PDEBUGF(LOG_V2, LOG_CPU, "seg_test_read(): execute only\n");
+		raise_fault(_vector, _errcode);
+		return false;
 	}
+	return true;
 }
 
-void CPUExecutor::seg_check_write(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode)
+bool CPUExecutor::seg_test_write(SegReg & _seg, uint32_t _offset, unsigned _len, uint8_t _vector, uint16_t _errcode)
 {
 	assert(_len!=0);
 
 	if(!_seg.desc.is_writeable()) {
-		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment not writeable\n");
-		throw CPUException(_vector, _errcode);
+		PDEBUGF(LOG_V2, LOG_CPU, "seg_test_write(): segment not writeable\n");
+		raise_fault(_vector, _errcode);
+		return false;
 	}
 	if(_seg.desc.is_expand_down()) {
 		uint32_t upper_limit = 0xFFFF;
@@ -57,33 +62,45 @@ void CPUExecutor::seg_check_write(SegReg & _seg, uint32_t _offset, unsigned _len
 			upper_limit = 0xFFFFFFFF;
 		}
 		if(_offset <= _seg.desc.limit || _offset > upper_limit || (upper_limit - _offset) < _len) {
-			PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment limit violation exp.down\n");
-			throw CPUException(_vector, _errcode);
+			PDEBUGF(LOG_V2, LOG_CPU, "seg_test_write(): segment limit violation exp.down\n");
+			raise_fault(_vector, _errcode);
+			return false;
 		}
 	} else if((_len-1) > _seg.desc.limit || _offset > (_seg.desc.limit-(_len-1))) {
-		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment limit violation\n");
-		throw CPUException(_vector, _errcode);
+		PDEBUGF(LOG_V2, LOG_CPU, "seg_test_write(): segment limit violation\n");
+		raise_fault(_vector, _errcode);
+		return false;
 	}
+	return true;
 }
 
-void CPUExecutor::seg_check(SegReg & _seg, uint32_t _offset, unsigned _len,
+bool CPUExecutor::seg_test(SegReg & _seg, uint32_t _offset, unsigned _len,
 		bool _write, uint8_t _vector, uint16_t _errcode)
 {
 	if(_vector == CPU_INVALID_INT) {
 		_vector = _seg.is(REG_SS)?CPU_SS_EXC:CPU_GP_EXC;
 	}
 	if(!_seg.desc.valid) {
-		PDEBUGF(LOG_V2, LOG_CPU, "seg_check(): segment not valid\n");
-		throw CPUException(_vector, _errcode);
+		PDEBUGF(LOG_V2, LOG_CPU, "seg_test(): segment not valid\n");
+		raise_fault(_vector, _errcode);
+		return false;
 	}
 	if(_write) {
-		seg_check_write(_seg, _offset, _len, _vector, _errcode);
+		return seg_test_write(_seg, _offset, _len, _vector, _errcode);
 	} else {
-		seg_check_read(_seg, _offset, _len, _vector, _errcode);
+		return seg_test_read(_seg, _offset, _len, _vector, _errcode);
 	}
 }
 
-void CPUExecutor::io_check(uint16_t _port, unsigned _len)
+void CPUExecutor::seg_check(SegReg & _seg, uint32_t _offset, unsigned _len,
+		bool _write, uint8_t _vector, uint16_t _errcode)
+{
+	if(!seg_test(_seg, _offset, _len, _write, _vector, _errcode)) {
+		throw take_fault();
+	}
+}
+
+bool CPUExecutor::io_test(uint16_t _port, unsigned _len)
 {
 	if((IS_PMODE() && (CPL > FLAG_IOPL)) || IS_V8086()) {
 		if(CPU_FAMILY <= CPU_286) {
@@ -91,7 +108,8 @@ void CPUExecutor::io_check(uint16_t _port, unsigned _len)
 			 * than IOPL; which is the privilege level found in the flags register.
 			 */
 			PDEBUGF(LOG_V2, LOG_CPU, "I/O access not allowed\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return false;
 		}
 		if(!REG_TR.desc.valid || !REG_TR.desc.is_system_segment() || (
 			REG_TR.desc.type != DESC_TYPE_AVAIL_386_TSS &&
@@ -99,14 +117,24 @@ void CPUExecutor::io_check(uint16_t _port, unsigned _len)
 		))
 		{
 			PDEBUGF(LOG_V2, LOG_CPU, "TR doesn't point to a valid 32bit TSS\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return false;
 		}
 		uint32_t io_base = read_word(REG_TR, 102, CPU_GP_EXC, 0);
 		uint16_t permission = read_word(REG_TR, io_base + _port/8, CPU_GP_EXC, 0);
 		unsigned bit_index = _port & 0x7;
 		unsigned mask = (1 << _len) - 1;
 		if((permission >> bit_index) & mask) {
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return false;
 		}
 	}
+	return true;
+}
+
+void CPUExecutor::io_check(uint16_t _port, unsigned _len)
+{
+	if(!io_test(_port, _len)) {
+		throw take_fault();
+	}
 }
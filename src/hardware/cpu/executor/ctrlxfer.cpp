@@ -126,6 +126,7 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 		SegReg new_stack;
 		new_stack.sel     = ss_selector;
 		new_stack.desc    = ss_descriptor;
+		new_stack.update_window();
 		new_stack.sel.rpl = cs_descriptor.dpl;
 		// add cpl to the selector value
 		new_stack.sel.value = (new_stack.sel.value & SELECTOR_RPL_MASK) | new_stack.sel.rpl;
@@ -1082,6 +1083,7 @@ void CPUExecutor::stack_return_to_v86(Selector &cs_selector, uint32_t new_eip, u
 		SEG_REG(sreg).desc.page_granular  = false;
 		SEG_REG(sreg).desc.big  = false;
 		SEG_REG(sreg).sel.rpl = 3;
+		SEG_REG(sreg).update_window();
 	}
 
 	//trigger the mode change
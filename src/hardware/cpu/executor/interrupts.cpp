@@ -195,6 +195,7 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 	SegReg new_stack;
 	new_stack.sel = ss_selector;
 	new_stack.desc = ss_descriptor;
+	new_stack.update_window();
 	new_stack.sel.rpl = cs_descriptor.dpl;
 	// add cpl to the selector value
 	new_stack.sel.value =
@@ -233,6 +234,10 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 		REG_DS.sel.value = 0;
 		REG_ES.desc.valid = false;
 		REG_ES.sel.value = 0;
+		REG_GS.update_window();
+		REG_FS.update_window();
+		REG_DS.update_window();
+		REG_ES.update_window();
 	}
 }
 
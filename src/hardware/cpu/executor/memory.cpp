@@ -21,12 +21,21 @@
 #include "hardware/cpu/executor.h"
 #include "hardware/cpu/mmu.h"
 
-void CPUExecutor::mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write)
+bool CPUExecutor::mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write)
 {
+	if(UNLIKELY(fault_pending())) {
+		// the instruction has already faulted, nothing else must be accessed
+		return false;
+	}
 	if(IS_PAGING()) {
+		CPUException fault;
 		if(LIKELY((PAGE_OFFSET(_linear) + _len) <= 4096)) {
 			m_cached_phy.lin1 = _linear;
-			m_cached_phy.phy1 = g_cpummu.TLB_lookup(m_cached_phy.lin1, _len, _user, _write);
+			if(UNLIKELY(!g_cpummu.TLB_translate(m_cached_phy.lin1, _len, _user, _write,
+					m_cached_phy.phy1, fault))) {
+				abort_fault(fault);
+				return false;
+			}
 			m_cached_phy.len1 = _len;
 			m_cached_phy.pages = 1;
 		} else {
@@ -34,9 +43,15 @@ void CPUExecutor::mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _
 			m_cached_phy.len1 = 4096 - page_offset;
 			m_cached_phy.len2 = _len - m_cached_phy.len1;
 			m_cached_phy.lin1 = _linear;
-			m_cached_phy.phy1 = g_cpummu.TLB_lookup(m_cached_phy.lin1, m_cached_phy.len1, _user, _write);
 			m_cached_phy.lin2 = _linear + m_cached_phy.len1;
-			m_cached_phy.phy2 = g_cpummu.TLB_lookup(m_cached_phy.lin2, m_cached_phy.len2, _user, _write);
+			if(UNLIKELY(!g_cpummu.TLB_translate(m_cached_phy.lin1, m_cached_phy.len1, _user, _write,
+					m_cached_phy.phy1, fault) ||
+			   !g_cpummu.TLB_translate(m_cached_phy.lin2, m_cached_phy.len2, _user, _write,
+					m_cached_phy.phy2, fault)))
+			{
+				abort_fault(fault);
+				return false;
+			}
 			m_cached_phy.pages = 2;
 		}
 	} else {
@@ -45,6 +60,7 @@ void CPUExecutor::mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _
 		m_cached_phy.len1 = _len;
 		m_cached_phy.pages = 1;
 	}
+	return true;
 }
 
 
@@ -113,67 +129,87 @@ uint32_t CPUExecutor::read_dword()
 
 uint8_t CPUExecutor::read_byte(SegReg &_seg, uint32_t _offset, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 1, false, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 1, IS_USER_PL, false);
+	if(UNLIKELY(!_seg.can_read(_offset, 1))) {
+		seg_check(_seg, _offset, 1, false, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 1, IS_USER_PL, false))) {
+		return 0;
+	}
 	return read_byte();
 }
 
 uint16_t CPUExecutor::read_word(SegReg &_seg, uint32_t _offset, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 2, false, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, false);
+	if(UNLIKELY(!_seg.can_read(_offset, 2))) {
+		seg_check(_seg, _offset, 2, false, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, false))) {
+		return 0;
+	}
 	return read_word();
 }
 
 uint32_t CPUExecutor::read_dword(SegReg &_seg, uint32_t _offset, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 4, false, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, false);
+	if(UNLIKELY(!_seg.can_read(_offset, 4))) {
+		seg_check(_seg, _offset, 4, false, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, false))) {
+		return 0;
+	}
 	return read_dword();
 }
 
 uint16_t CPUExecutor::read_word_rmw(SegReg &_seg, uint32_t _offset, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 2, false, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, true);
+	if(UNLIKELY(!_seg.can_read(_offset, 2))) {
+		seg_check(_seg, _offset, 2, false, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, true))) {
+		return 0;
+	}
 	return read_word();
 }
 
 uint32_t CPUExecutor::read_dword_rmw(SegReg &_seg, uint32_t _offset, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 4, false, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, true);
+	if(UNLIKELY(!_seg.can_read(_offset, 4))) {
+		seg_check(_seg, _offset, 4, false, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, true))) {
+		return 0;
+	}
 	return read_dword();
 }
 
 uint8_t  CPUExecutor::read_byte(uint32_t _linear)
 {
-	mmu_lookup(_linear, 1, false, false);
+	if(UNLIKELY(!mmu_lookup(_linear, 1, false, false))) {
+		return 0;
+	}
 	return read_byte();
 }
 
 uint16_t CPUExecutor::read_word(uint32_t _linear)
 {
-	mmu_lookup(_linear, 2, false, false);
+	if(UNLIKELY(!mmu_lookup(_linear, 2, false, false))) {
+		return 0;
+	}
 	return read_word();
 }
 
 uint32_t CPUExecutor::read_dword(uint32_t _linear)
 {
-	mmu_lookup(_linear, 4, false, false);
+	if(UNLIKELY(!mmu_lookup(_linear, 4, false, false))) {
+		return 0;
+	}
 	return read_dword();
 }
 
 uint64_t CPUExecutor::read_qword(uint32_t _linear)
 {
-	uint64_t value;
-
-	mmu_lookup(_linear, 4, false, false);
-	value = read_dword();
-
-	mmu_lookup(_linear+4, 4, false, false);
-	value |= uint64_t(read_dword()) << 32;
-
+	uint64_t value = read_dword(_linear);
+	value |= uint64_t(read_dword(_linear + 4)) << 32;
 	return value;
 }
 
@@ -241,53 +277,79 @@ void CPUExecutor::write_dword(uint32_t _data)
 
 void CPUExecutor::write_byte(SegReg &_seg, uint32_t _offset, uint8_t _data, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 1, true, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 1, IS_USER_PL, true);
+	if(UNLIKELY(!_seg.can_write(_offset, 1))) {
+		seg_check(_seg, _offset, 1, true, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 1, IS_USER_PL, true))) {
+		return;
+	}
 	write_byte(_data);
 }
 
 void CPUExecutor::write_word(SegReg &_seg, uint32_t _offset, uint16_t _data, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 2, true, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, true);
+	if(UNLIKELY(!_seg.can_write(_offset, 2))) {
+		seg_check(_seg, _offset, 2, true, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 2, IS_USER_PL, true))) {
+		return;
+	}
 	write_word(_data);
 }
 
 void CPUExecutor::write_dword(SegReg &_seg, uint32_t _offset, uint32_t _data, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 4, true, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, true);
+	if(UNLIKELY(!_seg.can_write(_offset, 4))) {
+		seg_check(_seg, _offset, 4, true, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 4, IS_USER_PL, true))) {
+		return;
+	}
 	write_dword(_data);
 }
 
 void CPUExecutor::write_word(SegReg &_seg, uint32_t _offset, uint16_t _data, unsigned _pl, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 2, true, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 2, _pl==3, true);
+	if(UNLIKELY(!_seg.can_write(_offset, 2))) {
+		seg_check(_seg, _offset, 2, true, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 2, _pl==3, true))) {
+		return;
+	}
 	write_word(_data);
 }
 
 void CPUExecutor::write_dword(SegReg &_seg, uint32_t _offset, uint32_t _data, unsigned _pl, uint8_t _vector, uint16_t _errcode)
 {
-	seg_check(_seg, _offset, 4, true, _vector, _errcode);
-	mmu_lookup(_seg.desc.base + _offset, 4, _pl==3, true);
+	if(UNLIKELY(!_seg.can_write(_offset, 4))) {
+		seg_check(_seg, _offset, 4, true, _vector, _errcode);
+	}
+	if(UNLIKELY(!mmu_lookup(_seg.desc.base + _offset, 4, _pl==3, true))) {
+		return;
+	}
 	write_dword(_data);
 }
 
 void CPUExecutor::write_byte(uint32_t _linear, uint8_t _data)
 {
-	mmu_lookup(_linear, 1, false, true);
+	if(UNLIKELY(!mmu_lookup(_linear, 1, false, true))) {
+		return;
+	}
 	write_byte(_data);
 }
 
 void CPUExecutor::write_word(uint32_t _linear, uint16_t _data)
 {
-	mmu_lookup(_linear, 2, false, true);
+	if(UNLIKELY(!mmu_lookup(_linear, 2, false, true))) {
+		return;
+	}
 	write_word(_data);
 }
 
 void CPUExecutor::write_dword(uint32_t _linear, uint32_t _data)
 {
-	mmu_lookup(_linear, 4, false, true);
+	if(UNLIKELY(!mmu_lookup(_linear, 4, false, true))) {
+		return;
+	}
 	write_dword(_data);
 }
@@ -84,13 +84,14 @@ void CPUExecutor::check_CPL_privilege(bool _mode_cond, const char *_opstr)
  * AAA-ASCII Adjust AL After Addition
  */
 
+template<unsigned F>
 void CPUExecutor::AAA()
 {
 	/* According to the Intel's IA-32 manual, only AF and CF are modified,
 	 * but OF,SF,ZF,PF are also updated in a specific way that depends on the
 	 * CPU family.
 	 */
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		// TODO verify for 486/586
 		SET_FLAG(SF, ((REG_AL >= 0x7a) && (REG_AL <= 0xf9)));
 		if(((REG_AL & 0x0f) > 9)) {
@@ -138,6 +139,7 @@ void CPUExecutor::AAA()
  * AAD-ASCII Adjust AX Before Division
  */
 
+template<unsigned F>
 void CPUExecutor::AAD()
 {
 	// According to the Intel's 286/386 manuals, the immediate value is always
@@ -155,7 +157,7 @@ void CPUExecutor::AAD()
 	SET_FLAG(ZF, REG_AL == 0);
 	SET_FLAG(PF, PARITY(REG_AL));
 
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		// On the 386, undefined flags are the same as ADD byte.
 		// Validated against 386SX hardware.
 		// TODO verify for 486/586
@@ -170,6 +172,7 @@ void CPUExecutor::AAD()
  * AAM-ASCII Adjust AX After Multiply
  */
 
+template<unsigned F>
 void CPUExecutor::AAM()
 {
 	// According to the Intel's 286/386 manuals, the immediate value is always
@@ -189,7 +192,7 @@ void CPUExecutor::AAM()
 	SET_FLAG(ZF, REG_AL == 0);
 	SET_FLAG(PF, PARITY(REG_AL));
 
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		// On the 386 CF, OF, and AF are cleared.
 		// Validated against 386SX hardware.
 		// TODO verify for 486/586
@@ -204,10 +207,11 @@ void CPUExecutor::AAM()
  * AAS-ASCII Adjust AL After Subtraction
  */
 
+template<unsigned F>
 void CPUExecutor::AAS()
 {
 	// See comments for AAA.
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		if((REG_AL & 0x0f) > 9) {
 			SET_FLAG(SF, REG_AL > 0x85);
 			REG_AX -= 0x106;
@@ -258,12 +262,7 @@ uint8_t CPUExecutor::ADC_b(uint8_t op1, uint8_t op2)
 	uint8_t cf = FLAG_CF;
 	uint8_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80) & (res ^ op2)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	g_cpucore.set_lazy_flags<uint8_t>(cf ? LF_ADC : LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -273,12 +272,7 @@ uint16_t CPUExecutor::ADC_w(uint16_t op1, uint16_t op2)
 	uint16_t cf = FLAG_CF;
 	uint16_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x8000) & (res ^ op2)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	g_cpucore.set_lazy_flags<uint16_t>(cf ? LF_ADC : LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -288,12 +282,7 @@ uint32_t CPUExecutor::ADC_d(uint32_t op1, uint32_t op2)
 	uint32_t cf = FLAG_CF;
 	uint32_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80000000) & (res ^ op2)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	g_cpucore.set_lazy_flags<uint32_t>(cf ? LF_ADC : LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -317,12 +306,7 @@ uint8_t CPUExecutor::ADD_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80) & (res ^ op2)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	g_cpucore.set_lazy_flags<uint8_t>(LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -331,12 +315,7 @@ uint16_t CPUExecutor::ADD_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x8000) & (res ^ op2)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	g_cpucore.set_lazy_flags<uint16_t>(LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -345,12 +324,7 @@ uint32_t CPUExecutor::ADD_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80000000) & (res ^ op2)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	g_cpucore.set_lazy_flags<uint32_t>(LF_ADD, res, op1, op2);
 
 	return res;
 }
@@ -379,12 +353,7 @@ uint8_t CPUExecutor::AND_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint8_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -393,12 +362,7 @@ uint16_t CPUExecutor::AND_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint16_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -407,12 +371,7 @@ uint32_t CPUExecutor::AND_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint32_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -590,9 +549,10 @@ void CPUExecutor::BSR_rd_ed()
  * BT-Bit Test
  */
 
+template<unsigned F>
 void CPUExecutor::BT_w(uint32_t _op1, uint16_t _op2)
 {
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		//TODO should be the same for 486/586
 		// same as RCR with initial CF value of 0
 		uint16_t count = (_op2 & 0xf) + 1;
@@ -603,9 +563,10 @@ void CPUExecutor::BT_w(uint32_t _op1, uint16_t _op2)
 	SET_FLAG(CF, (_op1 >> (_op2 & 0xf)) & 1);
 }
 
+template<unsigned F>
 void CPUExecutor::BT_d(uint64_t _op1, uint32_t _op2)
 {
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		//TODO should be the same for 486/586
 		// same as RCR with initial CF value of 0
 		uint32_t count = (_op2 & 0x1f) + 1;
@@ -616,6 +577,7 @@ void CPUExecutor::BT_d(uint64_t _op1, uint32_t _op2)
 	SET_FLAG(CF, (_op1 >> (_op2 & 0x1f)) & 1);
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::BT_ew(uint16_t _op2, bool _rmw)
 {
 	uint16_t op1;
@@ -632,11 +594,12 @@ uint16_t CPUExecutor::BT_ew(uint16_t _op2, bool _rmw)
 		}
 	}
 
-	BT_w(op1, _op2);
+	BT_w<F>(op1, _op2);
 
 	return op1;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::BT_ed(uint32_t _op2, bool _rmw)
 {
 	uint32_t op1;
@@ -653,29 +616,33 @@ uint32_t CPUExecutor::BT_ed(uint32_t _op2, bool _rmw)
 		}
 	}
 
-	BT_d(op1, _op2);
+	BT_d<F>(op1, _op2);
 
 	return op1;
 }
 
+template<unsigned F>
 void CPUExecutor::BT_ew_rw()
 {
-	BT_ew(load_rw(), false);
+	BT_ew<F>(load_rw(), false);
 }
 
+template<unsigned F>
 void CPUExecutor::BT_ed_rd()
 {
-	BT_ed(load_rd(), false);
+	BT_ed<F>(load_rd(), false);
 }
 
+template<unsigned F>
 void CPUExecutor::BT_ew_ib()
 {
-	BT_w(load_ew(), m_instr->ib);
+	BT_w<F>(load_ew(), m_instr->ib);
 }
 
+template<unsigned F>
 void CPUExecutor::BT_ed_ib()
 {
-	BT_d(load_ed(), m_instr->ib);
+	BT_d<F>(load_ed(), m_instr->ib);
 }
 
 
@@ -683,43 +650,47 @@ void CPUExecutor::BT_ed_ib()
  * BTC-Bit Test and Complement
  */
 
+template<unsigned F>
 void CPUExecutor::BTC_ew_rw()
 {
 	uint16_t op2 = load_rw();
-	uint16_t op1 = BT_ew(op2, true);
+	uint16_t op1 = BT_ew<F>(op2, true);
 
 	op1 ^= (1 << (op2 & 0xf));
 
 	store_ew_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTC_ed_rd()
 {
 	uint32_t op2 = load_rd();
-	uint32_t op1 = BT_ed(op2, true);
+	uint32_t op1 = BT_ed<F>(op2, true);
 
 	op1 ^= (1 << (op2 & 0x1f));
 
 	store_ed_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTC_ew_ib()
 {
 	uint16_t op2 = m_instr->ib;
 	uint16_t op1 = load_ew();
 
-	BT_w(op1, op2);
+	BT_w<F>(op1, op2);
 	op1 ^= (1 << (op2 & 0xf));
 
 	store_ew(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTC_ed_ib()
 {
 	uint32_t op2 = m_instr->ib;
 	uint32_t op1 = load_ed();
 
-	BT_d(op1, op2);
+	BT_d<F>(op1, op2);
 	op1 ^= (1 << (op2 & 0x1f));
 
 	store_ed(op1);
@@ -730,43 +701,47 @@ void CPUExecutor::BTC_ed_ib()
  * BTR-Bit Test and Reset
  */
 
+template<unsigned F>
 void CPUExecutor::BTR_ew_rw()
 {
 	uint16_t op2 = load_rw();
-	uint16_t op1 = BT_ew(op2, true);
+	uint16_t op1 = BT_ew<F>(op2, true);
 
 	op1 &= ~(1 << (op2 & 0xf));
 
 	store_ew_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTR_ed_rd()
 {
 	uint32_t op2 = load_rd();
-	uint32_t op1 = BT_ed(op2, true);
+	uint32_t op1 = BT_ed<F>(op2, true);
 
 	op1 &= ~(1 << (op2 & 0x1f));
 
 	store_ed_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTR_ew_ib()
 {
 	uint16_t op2 = m_instr->ib;
 	uint16_t op1 = load_ew();
 
-	BT_w(op1, op2);
+	BT_w<F>(op1, op2);
 	op1 &= ~(1 << (op2 & 0xf));
 
 	store_ew(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTR_ed_ib()
 {
 	uint32_t op2 = m_instr->ib;
 	uint32_t op1 = load_ed();
 
-	BT_d(op1, op2);
+	BT_d<F>(op1, op2);
 	op1 &= ~(1 << (op2 & 0x1f));
 
 	store_ed(op1);
@@ -777,43 +752,47 @@ void CPUExecutor::BTR_ed_ib()
  * BTS-Bit Test and Set
  */
 
+template<unsigned F>
 void CPUExecutor::BTS_ew_rw()
 {
 	uint16_t op2 = load_rw();
-	uint16_t op1 = BT_ew(op2, true);
+	uint16_t op1 = BT_ew<F>(op2, true);
 
 	op1 |= (1 << (op2 & 0xf));
 
 	store_ew_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTS_ed_rd()
 {
 	uint32_t op2 = load_rd();
-	uint32_t op1 = BT_ed(op2, true);
+	uint32_t op1 = BT_ed<F>(op2, true);
 
 	op1 |= (1 << (op2 & 0x1f));
 
 	store_ed_rmw(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTS_ew_ib()
 {
 	uint16_t op2 = m_instr->ib;
 	uint16_t op1 = load_ew();
 
-	BT_w(op1, op2);
+	BT_w<F>(op1, op2);
 	op1 |= (1 << (op2 & 0xf));
 
 	store_ew(op1);
 }
 
+template<unsigned F>
 void CPUExecutor::BTS_ed_ib()
 {
 	uint32_t op2 = m_instr->ib;
 	uint32_t op1 = load_ed();
 
-	BT_d(op1, op2);
+	BT_d<F>(op1, op2);
 	op1 |= (1 << (op2 & 0x1f));
 
 	store_ed(op1);
@@ -921,10 +900,12 @@ void CPUExecutor::CLI()
 {
 	if(IS_PMODE() && (FLAG_IOPL < CPL)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CLI: IOPL < CPL in protected mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	} else if(IS_V8086() && (FLAG_IOPL != 3)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CLI: IOPL != 3 in V8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 
 	SET_FLAG(IF, false);
@@ -955,36 +936,21 @@ void CPUExecutor::CMP_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	g_cpucore.set_lazy_flags<uint8_t>(LF_SUB, res, op1, op2);
 }
 
 void CPUExecutor::CMP_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	g_cpucore.set_lazy_flags<uint16_t>(LF_SUB, res, op1, op2);
 }
 
 void CPUExecutor::CMP_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	g_cpucore.set_lazy_flags<uint32_t>(LF_SUB, res, op1, op2);
 }
 
 void CPUExecutor::CMP_eb_rb() { CMP_b(load_eb(), load_rb()); }
@@ -1108,6 +1074,7 @@ void CPUExecutor::CMPSD_a32()
  * DAA/DAS-Decimal Adjust AL after addition/subtraction
  */
 
+template<unsigned F>
 void CPUExecutor::DAA()
 {
 	// WARNING: Old Intel docs are wrong!
@@ -1138,7 +1105,7 @@ void CPUExecutor::DAA()
 	SET_FLAG(ZF, REG_AL == 0);
 	SET_FLAG(PF, PARITY(REG_AL));
 
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		// On the 386 OF is set according to result.
 		// Validated against 386SX hardware.
 		// TODO should be the same for 486/586
@@ -1149,6 +1116,7 @@ void CPUExecutor::DAA()
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::DAS()
 {
 	// WARNING: Old Intel docs are wrong!
@@ -1173,7 +1141,7 @@ void CPUExecutor::DAS()
 	SET_FLAG(ZF, REG_AL == 0);
 	SET_FLAG(PF, PARITY(REG_AL));
 
-	if(CPU_FAMILY <= CPU_386) {
+	if(F <= CPU_386) {
 		// On the 386 OF is set according to result.
 		// Validated against 386SX hardware.
 		// TODO should be the same for 486/586
@@ -1195,22 +1163,14 @@ void CPUExecutor::DEC_eb()
 	uint8_t res = op1 - 1;
 	store_eb(res);
 
-	SET_FLAG(OF, res == 0x7f);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint8_t>(LF_DEC, res, op1, 1);
 }
 
 uint16_t CPUExecutor::DEC_w(uint16_t _op1)
 {
 	uint16_t res = _op1 - 1;
 
-	SET_FLAG(OF, res == 0x7fff);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint16_t>(LF_DEC, res, _op1, 1);
 
 	return res;
 }
@@ -1219,11 +1179,7 @@ uint32_t CPUExecutor::DEC_d(uint32_t _op1)
 {
 	uint32_t res = _op1 - 1;
 
-	SET_FLAG(OF, res == 0x7fffffff);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint32_t>(LF_DEC, res, _op1, 1);
 
 	return res;
 }
@@ -1331,12 +1287,16 @@ void CPUExecutor::ENTER_o16()
 		REG_ESP -= alloc_size;
 
 		// ENTER finishes with memory write check on the final stack pointer
-		seg_check(REG_SS, REG_ESP, 2, true, CPU_SS_EXC, 0);
+		if(!seg_test(REG_SS, REG_ESP, 2, true, CPU_SS_EXC, 0)) {
+			return;
+		}
 		/* The ENTER instruction causes a page fault whenever a write using the
 		 * final value of the stack pointer (within the current stack segment)
 		 * would do so.
 		 */
-		mmu_lookup(REG_SS.desc.base + REG_ESP, 2, IS_USER_PL, true);
+		if(!mmu_lookup(REG_SS.desc.base + REG_ESP, 2, IS_USER_PL, true)) {
+			return;
+		}
 	} else {
 		uint16_t bp = REG_BP;
 		if(nesting_level > 0) {
@@ -1350,8 +1310,12 @@ void CPUExecutor::ENTER_o16()
 
 		REG_SP -= alloc_size;
 
-		seg_check(REG_SS, REG_SP, 2, true, CPU_SS_EXC, 0);
-		mmu_lookup(REG_SS.desc.base + REG_SP, 2, IS_USER_PL, true);
+		if(!seg_test(REG_SS, REG_SP, 2, true, CPU_SS_EXC, 0)) {
+			return;
+		}
+		if(!mmu_lookup(REG_SS.desc.base + REG_SP, 2, IS_USER_PL, true)) {
+			return;
+		}
 	}
 
 	REG_BP = frame_ptr;
@@ -1379,12 +1343,16 @@ void CPUExecutor::ENTER_o32()
 		REG_ESP -= alloc_size;
 
 		// ENTER finishes with memory write check on the final stack pointer
-		seg_check(REG_SS, REG_ESP, 4, true, CPU_SS_EXC, 0);
+		if(!seg_test(REG_SS, REG_ESP, 4, true, CPU_SS_EXC, 0)) {
+			return;
+		}
 		/* The ENTER instruction causes a page fault whenever a write using the
 		 * final value of the stack pointer (within the current stack segment)
 		 * would do so.
 		 */
-		mmu_lookup(REG_SS.desc.base + REG_ESP, 4, IS_USER_PL, true);
+		if(!mmu_lookup(REG_SS.desc.base + REG_ESP, 4, IS_USER_PL, true)) {
+			return;
+		}
 	} else {
 		uint16_t bp = REG_BP;
 		if(nesting_level > 0) {
@@ -1398,8 +1366,12 @@ void CPUExecutor::ENTER_o32()
 
 		REG_SP -= alloc_size;
 
-		seg_check(REG_SS, REG_SP, 4, true, CPU_SS_EXC, 0);
-		mmu_lookup(REG_SS.desc.base + REG_SP, 4, IS_USER_PL, true);
+		if(!seg_test(REG_SS, REG_SP, 4, true, CPU_SS_EXC, 0)) {
+			return;
+		}
+		if(!mmu_lookup(REG_SS.desc.base + REG_SP, 4, IS_USER_PL, true)) {
+			return;
+		}
 	}
 
 	REG_EBP = frame_ptr;
@@ -1551,6 +1523,7 @@ inline static int mul_cycles_386(int64_t _m)
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::IMUL_eb()
 {
 	int8_t op1 = int8_t(REG_AL);
@@ -1577,11 +1550,12 @@ void CPUExecutor::IMUL_eb()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_8));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2);
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::IMUL_ew()
 {
 	int16_t op1_16 = int16_t(REG_AX);
@@ -1610,11 +1584,12 @@ void CPUExecutor::IMUL_ew()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_16l));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2_16);
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::IMUL_ed()
 {
 	int32_t op1_32 = int32_t(REG_EAX);
@@ -1643,11 +1618,12 @@ void CPUExecutor::IMUL_ed()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_32l));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2_32);
 	}
 }
 
+template<unsigned F>
 int16_t CPUExecutor::IMUL_w(int16_t _op1, int16_t _op2)
 {
 	int32_t  product_32  = int32_t(_op1) * int32_t(_op2);
@@ -1666,13 +1642,14 @@ int16_t CPUExecutor::IMUL_w(int16_t _op1, int16_t _op2)
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_16));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(_op2);
 	}
 
 	return product_16;
 }
 
+template<unsigned F>
 int32_t CPUExecutor::IMUL_d(int32_t _op1, int32_t _op2)
 {
 	int64_t  product_64  = int64_t(_op1) * int64_t(_op2);
@@ -1691,19 +1668,19 @@ int32_t CPUExecutor::IMUL_d(int32_t _op1, int32_t _op2)
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_32));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(_op2);
 	}
 
 	return product_32;
 }
 
-void CPUExecutor::IMUL_rw_ew()    { store_rw(IMUL_w(load_rw(), load_ew())); }
-void CPUExecutor::IMUL_rd_ed()    { store_rd(IMUL_d(load_rd(), load_ed())); }
-void CPUExecutor::IMUL_rw_ew_ib() { store_rw(IMUL_w(load_ew(), int8_t(m_instr->ib))); }
-void CPUExecutor::IMUL_rd_ed_ib() { store_rd(IMUL_d(load_ed(), int8_t(m_instr->ib))); }
-void CPUExecutor::IMUL_rw_ew_iw() { store_rw(IMUL_w(load_ew(), m_instr->iw1)); }
-void CPUExecutor::IMUL_rd_ed_id() { store_rd(IMUL_d(load_ed(), m_instr->id1)); }
+template<unsigned F> void CPUExecutor::IMUL_rw_ew()    { store_rw(IMUL_w<F>(load_rw(), load_ew())); }
+template<unsigned F> void CPUExecutor::IMUL_rd_ed()    { store_rd(IMUL_d<F>(load_rd(), load_ed())); }
+template<unsigned F> void CPUExecutor::IMUL_rw_ew_ib() { store_rw(IMUL_w<F>(load_ew(), int8_t(m_instr->ib))); }
+template<unsigned F> void CPUExecutor::IMUL_rd_ed_ib() { store_rd(IMUL_d<F>(load_ed(), int8_t(m_instr->ib))); }
+template<unsigned F> void CPUExecutor::IMUL_rw_ew_iw() { store_rw(IMUL_w<F>(load_ew(), m_instr->iw1)); }
+template<unsigned F> void CPUExecutor::IMUL_rd_ed_id() { store_rd(IMUL_d<F>(load_ed(), m_instr->id1)); }
 
 
 /*******************************************************************************
@@ -1712,37 +1689,49 @@ void CPUExecutor::IMUL_rd_ed_id() { store_rd(IMUL_d(load_ed(), m_instr->id1)); }
 
 void CPUExecutor::IN_AL_ib()
 {
-	io_check(m_instr->ib, 1);
+	if(!io_test(m_instr->ib, 1)) {
+		return;
+	}
 	REG_AL = g_devices.read_byte(m_instr->ib);
 }
 
 void CPUExecutor::IN_AL_DX()
 {
-	io_check(REG_DX, 1);
+	if(!io_test(REG_DX, 1)) {
+		return;
+	}
 	REG_AL = g_devices.read_byte(REG_DX);
 }
 
 void CPUExecutor::IN_AX_ib()
 {
-	io_check(m_instr->ib, 2);
+	if(!io_test(m_instr->ib, 2)) {
+		return;
+	}
 	REG_AX = g_devices.read_word(m_instr->ib);
 }
 
 void CPUExecutor::IN_AX_DX()
 {
-	io_check(REG_DX, 2);
+	if(!io_test(REG_DX, 2)) {
+		return;
+	}
 	REG_AX = g_devices.read_word(REG_DX);
 }
 
 void CPUExecutor::IN_EAX_ib()
 {
-	io_check(m_instr->ib, 4);
+	if(!io_test(m_instr->ib, 4)) {
+		return;
+	}
 	REG_EAX = g_devices.read_dword(m_instr->ib);
 }
 
 void CPUExecutor::IN_EAX_DX()
 {
-	io_check(REG_DX, 4);
+	if(!io_test(REG_DX, 4)) {
+		return;
+	}
 	REG_EAX = g_devices.read_dword(REG_DX);
 }
 
@@ -1757,22 +1746,14 @@ void CPUExecutor::INC_eb()
 	uint8_t res = op1 + 1;
 	store_eb(res);
 
-	SET_FLAG(OF, res == 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint8_t>(LF_INC, res, op1, 1);
 }
 
 uint16_t CPUExecutor::INC_w(uint16_t _op1)
 {
 	uint16_t res = _op1 + 1;
 
-	SET_FLAG(OF, res == 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint16_t>(LF_INC, res, _op1, 1);
 
 	return res;
 }
@@ -1781,11 +1762,7 @@ uint32_t CPUExecutor::INC_d(uint32_t _op1)
 {
 	uint32_t res = _op1 + 1;
 
-	SET_FLAG(OF, res == 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	g_cpucore.set_lazy_flags<uint32_t>(LF_INC, res, _op1, 1);
 
 	return res;
 }
@@ -1810,7 +1787,9 @@ void CPUExecutor::INSB(uint32_t _offset)
 	 * override is possible.
 	 */
 	seg_check(REG_ES, _offset, 1, true);
-	mmu_lookup(REG_ES.desc.base + _offset, 1, IS_USER_PL, true);
+	if(!mmu_lookup(REG_ES.desc.base + _offset, 1, IS_USER_PL, true)) {
+		return;
+	}
 
 	uint8_t value = g_devices.read_byte(REG_DX);
 	write_byte(value);
@@ -1845,7 +1824,9 @@ void CPUExecutor::INSW(uint32_t _offset)
 	}
 
 	seg_check(REG_ES, _offset, 2, true);
-	mmu_lookup(REG_ES.desc.base + _offset, 2, IS_USER_PL, true);
+	if(!mmu_lookup(REG_ES.desc.base + _offset, 2, IS_USER_PL, true)) {
+		return;
+	}
 
 	uint16_t value = g_devices.read_word(REG_DX);
 	write_word(value);
@@ -1880,7 +1861,9 @@ void CPUExecutor::INSD(uint32_t _offset)
 	}
 
 	seg_check(REG_ES, _offset, 4, true);
-	mmu_lookup(REG_ES.desc.base + _offset, 4, IS_USER_PL, true);
+	if(!mmu_lookup(REG_ES.desc.base + _offset, 4, IS_USER_PL, true)) {
+		return;
+	}
 
 	uint32_t value = g_devices.read_dword(REG_DX);
 	write_dword(value);
@@ -2006,6 +1989,14 @@ void CPUExecutor::INT(uint8_t _vector, unsigned _type)
 		in_windows = false;
 	}
 
+	if(_type == CPU_SOFTWARE_INTERRUPT && IS_V8086() && (FLAG_IOPL < 3)) {
+		// V8086 monitors trap INT n with this #GP, raise it here instead of
+		// letting CPU::interrupt() throw it
+		PDEBUGF(LOG_V2, LOG_CPU, "INT 0x%02X in V8086 mode with IOPL:%d\n", _vector, FLAG_IOPL);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
+	}
+
 	g_cpu.interrupt(_vector, _type, false, 0);
 }
 
@@ -2027,6 +2018,7 @@ void CPUExecutor::INT1()
  * IRET-Interrupt Return
  */
 
+template<unsigned F>
 void CPUExecutor::IRET()
 {
 	g_cpu.unmask_event(CPU_EVENT_NMI);
@@ -2037,7 +2029,8 @@ void CPUExecutor::IRET()
 		// real and v8086 modes
 		if(IS_V8086() && (FLAG_IOPL < 3)) {
 			PDEBUGF(LOG_V2, LOG_CPU, "IRET: IOPL!=3 in v8086 mode\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return;
 		}
 
 		uint16_t ip     = stack_pop_word();
@@ -2054,7 +2047,7 @@ void CPUExecutor::IRET()
 		SET_CS(cs_raw);
 		SET_IP(ip);
 
-		if(CPU_FAMILY == CPU_286) {
+		if(F == CPU_286) {
 			// in real mode IOPL and NT are always clear
 			write_flags(flags,
 				false, // IOPL
@@ -2082,7 +2075,8 @@ void CPUExecutor::IRETD()
 		// real and v8086 modes
 		if(IS_V8086() && (FLAG_IOPL < 3)) {
 			PDEBUGF(LOG_V2, LOG_CPU, "IRETD: IOPL!=3 in v8086 mode\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			raise_fault(CPU_GP_EXC, 0);
+			return;
 		}
 
 		uint32_t eip    = stack_pop_dword();
@@ -2461,6 +2455,7 @@ void CPUExecutor::LLDT_ew()
 	if((selector.value & SELECTOR_RPL_MASK) == 0) {
 		REG_LDTR.sel = selector;
 		REG_LDTR.desc.valid = false;
+		REG_LDTR.update_window();
 		return;
 	}
 
@@ -2489,6 +2484,7 @@ void CPUExecutor::LLDT_ew()
 
 	REG_LDTR.sel = selector;
 	REG_LDTR.desc = descriptor;
+	REG_LDTR.update_window();
 }
 
 
@@ -2654,21 +2650,25 @@ void CPUExecutor::LOADALL_286()
 	desc_cache[1] = g_cpubus.mem_read<2>(0x838);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x83A);
 	REG_ES.desc.set_from_286_cache(desc_cache);
+	REG_ES.update_window();
 
 	desc_cache[0] = g_cpubus.mem_read<2>(0x83C);
 	desc_cache[1] = g_cpubus.mem_read<2>(0x83E);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x840);
 	REG_CS.desc.set_from_286_cache(desc_cache);
+	REG_CS.update_window();
 
 	desc_cache[0] = g_cpubus.mem_read<2>(0x842);
 	desc_cache[1] = g_cpubus.mem_read<2>(0x844);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x846);
 	REG_SS.desc.set_from_286_cache(desc_cache);
+	REG_SS.update_window();
 
 	desc_cache[0] = g_cpubus.mem_read<2>(0x848);
 	desc_cache[1] = g_cpubus.mem_read<2>(0x84A);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x84C);
 	REG_DS.desc.set_from_286_cache(desc_cache);
+	REG_DS.update_window();
 
 	base  = g_cpubus.mem_read<4>(0x84E);
 	limit = g_cpubus.mem_read<2>(0x852);
@@ -2678,6 +2678,7 @@ void CPUExecutor::LOADALL_286()
 	desc_cache[1] = g_cpubus.mem_read<2>(0x856);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x858);
 	REG_LDTR.desc.set_from_286_cache(desc_cache);
+	REG_LDTR.update_window();
 
 	base  = g_cpubus.mem_read<4>(0x85A);
 	limit = g_cpubus.mem_read<2>(0x85E);
@@ -2687,6 +2688,7 @@ void CPUExecutor::LOADALL_286()
 	desc_cache[1] = g_cpubus.mem_read<2>(0x862);
 	desc_cache[2] = g_cpubus.mem_read<2>(0x864);
 	REG_TR.desc.set_from_286_cache(desc_cache);
+	REG_TR.update_window();
 
 	g_cpubus.invalidate_pq();
 }
@@ -2934,6 +2936,7 @@ void CPUExecutor::LTR_ew()
 
 	/* mark as busy */
 	REG_TR.desc.type |= TSS_BUSY_BIT;
+	REG_TR.update_window();
 	write_byte(GET_BASE(GDTR) + selector.index*8 + 5, REG_TR.desc.get_AR());
 }
 
@@ -3196,6 +3199,7 @@ void CPUExecutor::MOV_rd_TR()
  * MUL-Unsigned Multiplication of AL / AX / EAX
  */
 
+template<unsigned F>
 void CPUExecutor::MUL_eb()
 {
 	uint8_t op1_8 = REG_AL;
@@ -3222,11 +3226,12 @@ void CPUExecutor::MUL_eb()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_8l));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2_8);
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::MUL_ew()
 {
 	uint16_t op1_16 = REG_AX;
@@ -3254,11 +3259,12 @@ void CPUExecutor::MUL_ew()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_16l));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2_16);
 	}
 }
 
+template<unsigned F>
 void CPUExecutor::MUL_ed()
 {
 	uint32_t op1_32 = REG_EAX;
@@ -3286,7 +3292,7 @@ void CPUExecutor::MUL_ed()
 	SET_FLAG(AF, false);
 	SET_FLAG(PF, PARITY(product_32l));
 
-	if(CPU_FAMILY == CPU_386) {
+	if(F == CPU_386) {
 		m_instr->cycles.extra = mul_cycles_386(op2_32);
 	}
 }
@@ -3380,12 +3386,7 @@ uint8_t CPUExecutor::OR_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint8_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -3394,12 +3395,7 @@ uint16_t CPUExecutor::OR_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint16_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -3408,12 +3404,7 @@ uint32_t CPUExecutor::OR_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint32_t>(LF_LOGIC, res, op1, op2);
 
 	return res;
 }
@@ -3440,19 +3431,25 @@ void CPUExecutor::OR_ed_ib() { store_ed(OR_d(load_ed(), int8_t(m_instr->ib))); }
 
 void CPUExecutor::OUT_b(uint16_t _port, uint8_t _value)
 {
-	io_check(_port, 1);
+	if(!io_test(_port, 1)) {
+		return;
+	}
 	g_devices.write_byte(_port, _value);
 }
 
 void CPUExecutor::OUT_w(uint16_t _port, uint16_t _value)
 {
-	io_check(_port, 2);
+	if(!io_test(_port, 2)) {
+		return;
+	}
 	g_devices.write_word(_port, _value);
 }
 
 void CPUExecutor::OUT_d(uint16_t _port, uint32_t _value)
 {
-	io_check(_port, 4);
+	if(!io_test(_port, 4)) {
+		return;
+	}
 	g_devices.write_dword(_port, _value);
 }
 
@@ -3473,6 +3470,10 @@ void CPUExecutor::OUTSB(uint8_t _value)
 	if(m_instr->rep && m_instr->rep_first) {
 		io_check(REG_DX, 1);
 	}
+	if(UNLIKELY(fault_pending())) {
+		// the memory operand faulted
+		return;
+	}
 	g_devices.write_byte(REG_DX, _value);
 }
 
@@ -3503,6 +3504,10 @@ void CPUExecutor::OUTSW(uint16_t _value)
 	if(m_instr->rep && m_instr->rep_first) {
 		io_check(REG_DX, 2);
 	}
+	if(UNLIKELY(fault_pending())) {
+		// the memory operand faulted
+		return;
+	}
 	g_devices.write_word(REG_DX, _value);
 }
 
@@ -3533,6 +3538,10 @@ void CPUExecutor::OUTSD(uint32_t _value)
 	if(m_instr->rep && m_instr->rep_first) {
 		io_check(REG_DX, 4);
 	}
+	if(UNLIKELY(fault_pending())) {
+		// the memory operand faulted
+		return;
+	}
 	g_devices.write_dword(REG_DX, _value);
 }
 
@@ -3658,7 +3667,8 @@ void CPUExecutor::POPF()
 {
 	if(IS_V8086() && (FLAG_IOPL < 3)) {
 		PDEBUGF(LOG_CPU, LOG_V2, "POPF: #GP(0) in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 
 	uint16_t flags = stack_pop_word();
@@ -3673,7 +3683,8 @@ void CPUExecutor::POPFD()
 	 */
 	if(IS_V8086() && (FLAG_IOPL < 3)) {
 		PDEBUGF(LOG_CPU, LOG_V2, "POPFD: #GP(0) in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 
 	uint16_t flags = uint16_t(stack_pop_dword());
@@ -3768,7 +3779,8 @@ void CPUExecutor::PUSHF()
 {
 	if(IS_V8086() && FLAG_IOPL < 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "Push Flags: general protection in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 	uint16_t flags = GET_FLAGS();
 	stack_push_word(flags);
@@ -3778,7 +3790,8 @@ void CPUExecutor::PUSHFD()
 {
 	if(IS_V8086() && FLAG_IOPL < 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "Push Flags: general protection in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
 	}
 	// VM & RF flags cleared when pushed onto stack
 	uint32_t eflags = GET_EFLAGS() & ~(FMASK_RF | FMASK_VM);
@@ -3790,6 +3803,7 @@ void CPUExecutor::PUSHFD()
  * RCL/RCR/ROL/ROR-Rotate Instructions
  */
 
+template<unsigned F>
 uint8_t CPUExecutor::ROL_b(uint8_t _op1, uint8_t _count)
 {
 	if(!(_count & 0x7)) { //if _count==0 || _count>=8
@@ -3806,13 +3820,14 @@ uint8_t CPUExecutor::ROL_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(CF, _op1 & 1);
 	SET_FLAG(OF, (_op1 & 1) ^ (_op1 >> 7));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return _op1;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::ROL_w(uint16_t _op1, uint8_t _count)
 {
 	if(!(_count & 0xF)) { //if _count==0 || _count>=15
@@ -3829,13 +3844,14 @@ uint16_t CPUExecutor::ROL_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(CF, _op1 & 1);
 	SET_FLAG(OF, (_op1 & 1) ^ (_op1 >> 15));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return _op1;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::ROL_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -3851,23 +3867,24 @@ uint32_t CPUExecutor::ROL_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(CF, bit0);
 	SET_FLAG(OF, bit0 ^ bit31);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		assert(false);
 	}
 
 	return _op1;
 }
 
-void CPUExecutor::ROL_eb_ib() { store_eb(ROL_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::ROL_ew_ib() { store_ew(ROL_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::ROL_ed_ib() { store_ed(ROL_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::ROL_eb_1()  { store_eb(ROL_b(load_eb(), 1)); }
-void CPUExecutor::ROL_ew_1()  { store_ew(ROL_w(load_ew(), 1)); }
-void CPUExecutor::ROL_ed_1()  { store_ed(ROL_d(load_ed(), 1)); }
-void CPUExecutor::ROL_eb_CL() { store_eb(ROL_b(load_eb(), REG_CL)); }
-void CPUExecutor::ROL_ew_CL() { store_ew(ROL_w(load_ew(), REG_CL)); }
-void CPUExecutor::ROL_ed_CL() { store_ed(ROL_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROL_eb_ib() { store_eb(ROL_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROL_ew_ib() { store_ew(ROL_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROL_ed_ib() { store_ed(ROL_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROL_eb_1()  { store_eb(ROL_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::ROL_ew_1()  { store_ew(ROL_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::ROL_ed_1()  { store_ed(ROL_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::ROL_eb_CL() { store_eb(ROL_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROL_ew_CL() { store_ew(ROL_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROL_ed_CL() { store_ed(ROL_d<F>(load_ed(), REG_CL)); }
 
+template<unsigned F>
 uint8_t CPUExecutor::ROR_b(uint8_t _op1, uint8_t _count)
 {
 	if(!(_count & 0x7)) { //if _count==0 || _count>=8
@@ -3884,13 +3901,14 @@ uint8_t CPUExecutor::ROR_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(CF, _op1 >> 7);
 	SET_FLAG(OF, (_op1 >> 7) ^ ((_op1 >> 6) & 1));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return _op1;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::ROR_w(uint16_t _op1, uint8_t _count)
 {
 	if(!(_count & 0xf)) { //if _count==0 || _count>=15
@@ -3907,13 +3925,14 @@ uint16_t CPUExecutor::ROR_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(CF, _op1 >> 15);
 	SET_FLAG(OF, (_op1 >> 15) ^ ((_op1 >> 14) & 1));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return _op1;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::ROR_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -3930,30 +3949,31 @@ uint32_t CPUExecutor::ROR_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(CF, bit31);
 	SET_FLAG(OF, bit30 ^ bit31);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		assert(false);
 	}
 
 	return _op1;
 }
 
-void CPUExecutor::ROR_eb_ib() { store_eb(ROR_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::ROR_ew_ib() { store_ew(ROR_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::ROR_ed_ib() { store_ed(ROR_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::ROR_eb_1()  { store_eb(ROR_b(load_eb(), 1)); }
-void CPUExecutor::ROR_ew_1()  { store_ew(ROR_w(load_ew(), 1)); }
-void CPUExecutor::ROR_ed_1()  { store_ed(ROR_d(load_ed(), 1)); }
-void CPUExecutor::ROR_eb_CL() { store_eb(ROR_b(load_eb(), REG_CL)); }
-void CPUExecutor::ROR_ew_CL() { store_ew(ROR_w(load_ew(), REG_CL)); }
-void CPUExecutor::ROR_ed_CL() { store_ed(ROR_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROR_eb_ib() { store_eb(ROR_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROR_ew_ib() { store_ew(ROR_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROR_ed_ib() { store_ed(ROR_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::ROR_eb_1()  { store_eb(ROR_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::ROR_ew_1()  { store_ew(ROR_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::ROR_ed_1()  { store_ed(ROR_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::ROR_eb_CL() { store_eb(ROR_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROR_ew_CL() { store_ew(ROR_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::ROR_ed_CL() { store_ed(ROR_d<F>(load_ed(), REG_CL)); }
 
+template<unsigned F>
 uint8_t CPUExecutor::RCL_b(uint8_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
 	uint8_t count = _count % 9;
 
 	if(count == 0) {
-		if(CPU_FAMILY <= CPU_386 && _count) {
+		if(F <= CPU_386 && _count) {
 			// if _count == 9 rotate happens and flags are set
 			//TODO should be the same for 486/586
 			SET_FLAG(OF, FLAG_CF ^ (_op1 >> 7));
@@ -3975,20 +3995,21 @@ uint8_t CPUExecutor::RCL_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, cf ^ (res >> 7));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::RCL_w(uint16_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
 	uint8_t count = _count % 17;
 
 	if(count == 0) {
-		if(CPU_FAMILY <= CPU_386 && _count) {
+		if(F <= CPU_386 && _count) {
 			// if _count == 17 rotate happens and flags are set
 			//TODO should be the same for 486/586
 			SET_FLAG(OF, FLAG_CF ^ (_op1 >> 15));
@@ -4011,13 +4032,14 @@ uint16_t CPUExecutor::RCL_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, cf ^ (res >> 15));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::RCL_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4039,30 +4061,31 @@ uint32_t CPUExecutor::RCL_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, cf ^ (res >> 31));
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		assert(false);
 	}
 
 	return res;
 }
 
-void CPUExecutor::RCL_eb_ib() { store_eb(RCL_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::RCL_ew_ib() { store_ew(RCL_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::RCL_ed_ib() { store_ed(RCL_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::RCL_eb_1()  { store_eb(RCL_b(load_eb(), 1)); }
-void CPUExecutor::RCL_ew_1()  { store_ew(RCL_w(load_ew(), 1)); }
-void CPUExecutor::RCL_ed_1()  { store_ed(RCL_d(load_ed(), 1)); }
-void CPUExecutor::RCL_eb_CL() { store_eb(RCL_b(load_eb(), REG_CL)); }
-void CPUExecutor::RCL_ew_CL() { store_ew(RCL_w(load_ew(), REG_CL)); }
-void CPUExecutor::RCL_ed_CL() { store_ed(RCL_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCL_eb_ib() { store_eb(RCL_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCL_ew_ib() { store_ew(RCL_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCL_ed_ib() { store_ed(RCL_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCL_eb_1()  { store_eb(RCL_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::RCL_ew_1()  { store_ew(RCL_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::RCL_ed_1()  { store_ed(RCL_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::RCL_eb_CL() { store_eb(RCL_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCL_ew_CL() { store_ew(RCL_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCL_ed_CL() { store_ed(RCL_d<F>(load_ed(), REG_CL)); }
 
+template<unsigned F>
 uint8_t CPUExecutor::RCR_b(uint8_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
 	uint8_t count = _count % 9;
 
 	if(count == 0) {
-		if(CPU_FAMILY <= CPU_386 && _count) {
+		if(F <= CPU_386 && _count) {
 			// if _count == 9 rotate happens and flags are set
 			//TODO should be the same for 486/586
 			SET_FLAG(OF, (_op1 ^ (_op1 << 1)) & 0x80);
@@ -4077,20 +4100,21 @@ uint8_t CPUExecutor::RCR_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, (res ^ (res << 1)) & 0x80);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::RCR_w(uint16_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
 	uint8_t count = _count % 17;
 
 	if(count == 0) {
-		if(CPU_FAMILY <= CPU_386 && _count) {
+		if(F <= CPU_386 && _count) {
 			// if _count == 17 rotate happens and flags are set
 			//TODO should be the same for 486/586
 			SET_FLAG(OF, (_op1 ^ (_op1 << 1)) & 0x8000);
@@ -4105,13 +4129,14 @@ uint16_t CPUExecutor::RCR_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, (res ^ (res << 1)) & 0x8000);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::RCR_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4133,22 +4158,22 @@ uint32_t CPUExecutor::RCR_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(CF, cf);
 	SET_FLAG(OF, ((res << 1) ^ res) >> 31);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		assert(false);
 	}
 
 	return res;
 }
 
-void CPUExecutor::RCR_eb_ib() { store_eb(RCR_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::RCR_ew_ib() { store_ew(RCR_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::RCR_ed_ib() { store_ed(RCR_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::RCR_eb_1()  { store_eb(RCR_b(load_eb(), 1)); }
-void CPUExecutor::RCR_ew_1()  { store_ew(RCR_w(load_ew(), 1)); }
-void CPUExecutor::RCR_ed_1()  { store_ed(RCR_d(load_ed(), 1)); }
-void CPUExecutor::RCR_eb_CL() { store_eb(RCR_b(load_eb(), REG_CL)); }
-void CPUExecutor::RCR_ew_CL() { store_ew(RCR_w(load_ew(), REG_CL)); }
-void CPUExecutor::RCR_ed_CL() { store_ed(RCR_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCR_eb_ib() { store_eb(RCR_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCR_ew_ib() { store_ew(RCR_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCR_ed_ib() { store_ed(RCR_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::RCR_eb_1()  { store_eb(RCR_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::RCR_ew_1()  { store_ew(RCR_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::RCR_ed_1()  { store_ed(RCR_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::RCR_eb_CL() { store_eb(RCR_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCR_ew_CL() { store_ew(RCR_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::RCR_ed_CL() { store_ed(RCR_d<F>(load_ed(), REG_CL)); }
 
 
 /*******************************************************************************
@@ -4225,6 +4250,7 @@ void CPUExecutor::SALC()
  * SAL/SAR/SHL/SHR-Shift Instructions
  */
 
+template<unsigned F>
 uint8_t CPUExecutor::SHL_b(uint8_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4241,7 +4267,7 @@ uint8_t CPUExecutor::SHL_b(uint8_t _op1, uint8_t _count)
 		cf = (_op1 >> (8 - _count)) & 0x1;
 		of = cf ^ (res >> 7);
 	} else {
-		if(CPU_FAMILY <= CPU_386 && (_count == 16 || _count == 24)) {
+		if(F <= CPU_386 && (_count == 16 || _count == 24)) {
 			//TODO should be the same for 486/586
 			cf = _op1 & 0x1;
 			of = cf;
@@ -4255,13 +4281,14 @@ uint8_t CPUExecutor::SHL_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x80);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::SHL_w(uint16_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4286,13 +4313,14 @@ uint16_t CPUExecutor::SHL_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x8000);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::SHL_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4313,23 +4341,24 @@ uint32_t CPUExecutor::SHL_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x80000000);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
-void CPUExecutor::SAL_eb_ib() { store_eb(SHL_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::SAL_ew_ib() { store_ew(SHL_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::SAL_ed_ib() { store_ed(SHL_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::SAL_eb_1()  { store_eb(SHL_b(load_eb(), 1)); }
-void CPUExecutor::SAL_ew_1()  { store_ew(SHL_w(load_ew(), 1)); }
-void CPUExecutor::SAL_ed_1()  { store_ed(SHL_d(load_ed(), 1)); }
-void CPUExecutor::SAL_eb_CL() { store_eb(SHL_b(load_eb(), REG_CL)); }
-void CPUExecutor::SAL_ew_CL() { store_ew(SHL_w(load_ew(), REG_CL)); }
-void CPUExecutor::SAL_ed_CL() { store_ed(SHL_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAL_eb_ib() { store_eb(SHL_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAL_ew_ib() { store_ew(SHL_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAL_ed_ib() { store_ed(SHL_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAL_eb_1()  { store_eb(SHL_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::SAL_ew_1()  { store_ew(SHL_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::SAL_ed_1()  { store_ed(SHL_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::SAL_eb_CL() { store_eb(SHL_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAL_ew_CL() { store_ew(SHL_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAL_ed_CL() { store_ed(SHL_d<F>(load_ed(), REG_CL)); }
 
+template<unsigned F>
 uint8_t CPUExecutor::SHR_b(uint8_t _op1, uint8_t _count)
 {
 	_count &= 0x1f;
@@ -4341,7 +4370,7 @@ uint8_t CPUExecutor::SHR_b(uint8_t _op1, uint8_t _count)
 	uint8_t res = _op1 >> _count;
 	bool cf = 0;
 
-	if(CPU_FAMILY <= CPU_386 && (_count == 16 || _count == 24)) {
+	if(F <= CPU_386 && (_count == 16 || _count == 24)) {
 		//TODO should be the same for 486/586
 		cf = _op1 & 0x80;
 	} else {
@@ -4355,13 +4384,14 @@ uint8_t CPUExecutor::SHR_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x80);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::SHR_w(uint16_t _op1, uint8_t _count)
 {
 	_count &= 0x1f;
@@ -4379,13 +4409,14 @@ uint16_t CPUExecutor::SHR_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x8000);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::SHR_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4408,23 +4439,24 @@ uint32_t CPUExecutor::SHR_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(SF, res & 0x80000000);
 	SET_FLAG(AF, true);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
-void CPUExecutor::SHR_eb_ib() { store_eb(SHR_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::SHR_ew_ib() { store_ew(SHR_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::SHR_ed_ib() { store_ed(SHR_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::SHR_eb_1()  { store_eb(SHR_b(load_eb(), 1)); }
-void CPUExecutor::SHR_ew_1()  { store_ew(SHR_w(load_ew(), 1)); }
-void CPUExecutor::SHR_ed_1()  { store_ed(SHR_d(load_ed(), 1)); }
-void CPUExecutor::SHR_eb_CL() { store_eb(SHR_b(load_eb(), REG_CL)); }
-void CPUExecutor::SHR_ew_CL() { store_ew(SHR_w(load_ew(), REG_CL)); }
-void CPUExecutor::SHR_ed_CL() { store_ed(SHR_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SHR_eb_ib() { store_eb(SHR_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SHR_ew_ib() { store_ew(SHR_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SHR_ed_ib() { store_ed(SHR_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SHR_eb_1()  { store_eb(SHR_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::SHR_ew_1()  { store_ew(SHR_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::SHR_ed_1()  { store_ed(SHR_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::SHR_eb_CL() { store_eb(SHR_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SHR_ew_CL() { store_ew(SHR_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SHR_ed_CL() { store_ed(SHR_d<F>(load_ed(), REG_CL)); }
 
+template<unsigned F>
 uint8_t CPUExecutor::SAR_b(uint8_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4442,13 +4474,14 @@ uint8_t CPUExecutor::SAR_b(uint8_t _op1, uint8_t _count)
 	SET_FLAG(PF, PARITY(res));
 	SET_FLAG(AF, false);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint16_t CPUExecutor::SAR_w(uint16_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4466,13 +4499,14 @@ uint16_t CPUExecutor::SAR_w(uint16_t _op1, uint8_t _count)
 	SET_FLAG(PF, PARITY(res));
 	SET_FLAG(AF, false);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
+template<unsigned F>
 uint32_t CPUExecutor::SAR_d(uint32_t _op1, uint8_t _count)
 {
 	_count &= 0x1F;
@@ -4490,22 +4524,22 @@ uint32_t CPUExecutor::SAR_d(uint32_t _op1, uint8_t _count)
 	SET_FLAG(PF, PARITY(res));
 	SET_FLAG(AF, false);
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		m_instr->cycles.extra = _count;
 	}
 
 	return res;
 }
 
-void CPUExecutor::SAR_eb_ib() { store_eb(SAR_b(load_eb(), m_instr->ib)); }
-void CPUExecutor::SAR_ew_ib() { store_ew(SAR_w(load_ew(), m_instr->ib)); }
-void CPUExecutor::SAR_ed_ib() { store_ed(SAR_d(load_ed(), m_instr->ib)); }
-void CPUExecutor::SAR_eb_1()  { store_eb(SAR_b(load_eb(), 1)); }
-void CPUExecutor::SAR_ew_1()  { store_ew(SAR_w(load_ew(), 1)); }
-void CPUExecutor::SAR_ed_1()  { store_ed(SAR_d(load_ed(), 1)); }
-void CPUExecutor::SAR_eb_CL() { store_eb(SAR_b(load_eb(), REG_CL)); }
-void CPUExecutor::SAR_ew_CL() { store_ew(SAR_w(load_ew(), REG_CL)); }
-void CPUExecutor::SAR_ed_CL() { store_ed(SAR_d(load_ed(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAR_eb_ib() { store_eb(SAR_b<F>(load_eb(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAR_ew_ib() { store_ew(SAR_w<F>(load_ew(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAR_ed_ib() { store_ed(SAR_d<F>(load_ed(), m_instr->ib)); }
+template<unsigned F> void CPUExecutor::SAR_eb_1()  { store_eb(SAR_b<F>(load_eb(), 1)); }
+template<unsigned F> void CPUExecutor::SAR_ew_1()  { store_ew(SAR_w<F>(load_ew(), 1)); }
+template<unsigned F> void CPUExecutor::SAR_ed_1()  { store_ed(SAR_d<F>(load_ed(), 1)); }
+template<unsigned F> void CPUExecutor::SAR_eb_CL() { store_eb(SAR_b<F>(load_eb(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAR_ew_CL() { store_ew(SAR_w<F>(load_ew(), REG_CL)); }
+template<unsigned F> void CPUExecutor::SAR_ed_CL() { store_ed(SAR_d<F>(load_ed(), REG_CL)); }
 
 
 /*******************************************************************************
@@ -4517,12 +4551,7 @@ uint8_t CPUExecutor::SBB_b(uint8_t _op1, uint8_t _op2)
 	uint8_t cf = FLAG_CF;
 	uint8_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xff)));
+	g_cpucore.set_lazy_flags<uint8_t>(cf ? LF_SBB : LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -4532,12 +4561,7 @@ uint16_t CPUExecutor::SBB_w(uint16_t _op1, uint16_t _op2)
 	uint16_t cf = FLAG_CF;
 	uint16_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xffff)));
+	g_cpucore.set_lazy_flags<uint16_t>(cf ? LF_SBB : LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -4547,12 +4571,7 @@ uint32_t CPUExecutor::SBB_d(uint32_t _op1, uint32_t _op2)
 	uint32_t cf = FLAG_CF;
 	uint32_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xffffffff)));
+	g_cpucore.set_lazy_flags<uint32_t>(cf ? LF_SBB : LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -4671,12 +4690,13 @@ void CPUExecutor::SETNLE_eb() /*0F9F*/ { store_eb(!(FLAG_ZF || FLAG_SF!=FLAG_OF)
  * SGDT/SIDT/SLDT-Store Global/Interrupt/Local Descriptor Table Register
  */
 
+template<unsigned F>
 void CPUExecutor::SDT(unsigned _reg)
 {
 	uint16_t limit_16 = SEG_REG(_reg).desc.limit;
 	uint32_t base_32  = SEG_REG(_reg).desc.base;
 
-	if(CPU_FAMILY <= CPU_286) {
+	if(F <= CPU_286) {
 		/* Unlike to what described in the iAPX 286 Programmer's Reference Manual,
 		 * the last byte is not undefined, it's always 0xFF. Windows 3.0 checks
 		 * this value to detect the 80286.
@@ -4695,8 +4715,8 @@ void CPUExecutor::SDT(unsigned _reg)
 	write_dword(sr, (off+2) & m_addr_mask, base_32);
 }
 
-void CPUExecutor::SGDT() { SDT(REGI_GDTR); }
-void CPUExecutor::SIDT() { SDT(REGI_IDTR); }
+template<unsigned F> void CPUExecutor::SGDT() { SDT<F>(REGI_GDTR); }
+template<unsigned F> void CPUExecutor::SIDT() { SDT<F>(REGI_IDTR); }
 
 void CPUExecutor::SLDT_ew()
 {
@@ -4889,10 +4909,12 @@ void CPUExecutor::STI()
 {
 	if(IS_PMODE() && (FLAG_IOPL < CPL)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "STI: IOPL < CPL  in protected mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
     } else if(IS_V8086() && (FLAG_IOPL != 3)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "STI: IOPL != 3 in V8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		raise_fault(CPU_GP_EXC, 0);
+		return;
     }
 
 	if(!FLAG_IF) {
@@ -5008,12 +5030,7 @@ uint8_t CPUExecutor::SUB_b(uint8_t _op1, uint8_t _op2)
 {
 	uint8_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	g_cpucore.set_lazy_flags<uint8_t>(LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -5022,12 +5039,7 @@ uint16_t CPUExecutor::SUB_w(uint16_t _op1, uint16_t _op2)
 {
 	uint16_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	g_cpucore.set_lazy_flags<uint16_t>(LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -5036,12 +5048,7 @@ uint32_t CPUExecutor::SUB_d(uint32_t _op1, uint32_t _op2)
 {
 	uint32_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	g_cpucore.set_lazy_flags<uint32_t>(LF_SUB, res, _op1, _op2);
 
 	return res;
 }
@@ -5070,36 +5077,21 @@ void CPUExecutor::TEST_b(uint8_t _value1, uint8_t _value2)
 {
 	uint8_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint8_t>(LF_LOGIC, res, _value1, _value2);
 }
 
 void CPUExecutor::TEST_w(uint16_t _value1, uint16_t _value2)
 {
 	uint16_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint16_t>(LF_LOGIC, res, _value1, _value2);
 }
 
 void CPUExecutor::TEST_d(uint32_t _value1, uint32_t _value2)
 {
 	uint32_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint32_t>(LF_LOGIC, res, _value1, _value2);
 }
 
 void CPUExecutor::TEST_eb_rb() { TEST_b(load_eb(), load_rb()); }
@@ -5335,12 +5327,7 @@ uint8_t CPUExecutor::XOR_b(uint8_t _op1, uint8_t _op2)
 {
 	uint8_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint8_t>(LF_LOGIC, res, _op1, _op2);
 
 	return res;
 }
@@ -5349,12 +5336,7 @@ uint16_t CPUExecutor::XOR_w(uint16_t _op1, uint16_t _op2)
 {
 	uint16_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint16_t>(LF_LOGIC, res, _op1, _op2);
 
 	return res;
 }
@@ -5363,12 +5345,7 @@ uint32_t CPUExecutor::XOR_d(uint32_t _op1, uint32_t _op2)
 {
 	uint32_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	g_cpucore.set_lazy_flags<uint32_t>(LF_LOGIC, res, _op1, _op2);
 
 	return res;
 }
@@ -5388,3 +5365,112 @@ void CPUExecutor::XOR_ed_id() { store_ed(XOR_d(load_ed(), m_instr->id1)); }
 void CPUExecutor::XOR_ew_ib() { store_ew(XOR_w(load_ew(), int8_t(m_instr->ib))); }
 void CPUExecutor::XOR_ed_ib() { store_ed(XOR_d(load_ed(), int8_t(m_instr->ib))); }
 
+
+/* Functions whose behaviour depends on the CPU family are instantiated for
+ * every family, with the family checks resolved at compile time.
+ * See CPUExecutor::ms_functions.
+ */
+#define CPU_FAMILY_INSTANCES(_fn_) \
+	template void CPUExecutor::_fn_<CPU_286>(); \
+	template void CPUExecutor::_fn_<CPU_386>();
+
+CPU_FAMILY_INSTANCES(AAA)
+CPU_FAMILY_INSTANCES(AAD)
+CPU_FAMILY_INSTANCES(AAM)
+CPU_FAMILY_INSTANCES(AAS)
+CPU_FAMILY_INSTANCES(BT_ew_rw)
+CPU_FAMILY_INSTANCES(BT_ed_rd)
+CPU_FAMILY_INSTANCES(BT_ew_ib)
+CPU_FAMILY_INSTANCES(BT_ed_ib)
+CPU_FAMILY_INSTANCES(BTC_ew_rw)
+CPU_FAMILY_INSTANCES(BTC_ed_rd)
+CPU_FAMILY_INSTANCES(BTC_ew_ib)
+CPU_FAMILY_INSTANCES(BTC_ed_ib)
+CPU_FAMILY_INSTANCES(BTR_ew_rw)
+CPU_FAMILY_INSTANCES(BTR_ed_rd)
+CPU_FAMILY_INSTANCES(BTR_ew_ib)
+CPU_FAMILY_INSTANCES(BTR_ed_ib)
+CPU_FAMILY_INSTANCES(BTS_ew_rw)
+CPU_FAMILY_INSTANCES(BTS_ed_rd)
+CPU_FAMILY_INSTANCES(BTS_ew_ib)
+CPU_FAMILY_INSTANCES(BTS_ed_ib)
+CPU_FAMILY_INSTANCES(DAA)
+CPU_FAMILY_INSTANCES(DAS)
+CPU_FAMILY_INSTANCES(IMUL_eb)
+CPU_FAMILY_INSTANCES(IMUL_ew)
+CPU_FAMILY_INSTANCES(IMUL_ed)
+CPU_FAMILY_INSTANCES(IMUL_rw_ew)
+CPU_FAMILY_INSTANCES(IMUL_rd_ed)
+CPU_FAMILY_INSTANCES(IMUL_rw_ew_ib)
+CPU_FAMILY_INSTANCES(IMUL_rd_ed_ib)
+CPU_FAMILY_INSTANCES(IMUL_rw_ew_iw)
+CPU_FAMILY_INSTANCES(IMUL_rd_ed_id)
+CPU_FAMILY_INSTANCES(IRET)
+CPU_FAMILY_INSTANCES(MUL_eb)
+CPU_FAMILY_INSTANCES(MUL_ew)
+CPU_FAMILY_INSTANCES(MUL_ed)
+CPU_FAMILY_INSTANCES(ROL_eb_ib)
+CPU_FAMILY_INSTANCES(ROL_ew_ib)
+CPU_FAMILY_INSTANCES(ROL_ed_ib)
+CPU_FAMILY_INSTANCES(ROL_eb_1)
+CPU_FAMILY_INSTANCES(ROL_ew_1)
+CPU_FAMILY_INSTANCES(ROL_ed_1)
+CPU_FAMILY_INSTANCES(ROL_eb_CL)
+CPU_FAMILY_INSTANCES(ROL_ew_CL)
+CPU_FAMILY_INSTANCES(ROL_ed_CL)
+CPU_FAMILY_INSTANCES(ROR_eb_ib)
+CPU_FAMILY_INSTANCES(ROR_ew_ib)
+CPU_FAMILY_INSTANCES(ROR_ed_ib)
+CPU_FAMILY_INSTANCES(ROR_eb_1)
+CPU_FAMILY_INSTANCES(ROR_ew_1)
+CPU_FAMILY_INSTANCES(ROR_ed_1)
+CPU_FAMILY_INSTANCES(ROR_eb_CL)
+CPU_FAMILY_INSTANCES(ROR_ew_CL)
+CPU_FAMILY_INSTANCES(ROR_ed_CL)
+CPU_FAMILY_INSTANCES(RCL_eb_ib)
+CPU_FAMILY_INSTANCES(RCL_ew_ib)
+CPU_FAMILY_INSTANCES(RCL_ed_ib)
+CPU_FAMILY_INSTANCES(RCL_eb_1)
+CPU_FAMILY_INSTANCES(RCL_ew_1)
+CPU_FAMILY_INSTANCES(RCL_ed_1)
+CPU_FAMILY_INSTANCES(RCL_eb_CL)
+CPU_FAMILY_INSTANCES(RCL_ew_CL)
+CPU_FAMILY_INSTANCES(RCL_ed_CL)
+CPU_FAMILY_INSTANCES(RCR_eb_ib)
+CPU_FAMILY_INSTANCES(RCR_ew_ib)
+CPU_FAMILY_INSTANCES(RCR_ed_ib)
+CPU_FAMILY_INSTANCES(RCR_eb_1)
+CPU_FAMILY_INSTANCES(RCR_ew_1)
+CPU_FAMILY_INSTANCES(RCR_ed_1)
+CPU_FAMILY_INSTANCES(RCR_eb_CL)
+CPU_FAMILY_INSTANCES(RCR_ew_CL)
+CPU_FAMILY_INSTANCES(RCR_ed_CL)
+CPU_FAMILY_INSTANCES(SAL_eb_ib)
+CPU_FAMILY_INSTANCES(SAL_ew_ib)
+CPU_FAMILY_INSTANCES(SAL_ed_ib)
+CPU_FAMILY_INSTANCES(SAL_eb_1)
+CPU_FAMILY_INSTANCES(SAL_ew_1)
+CPU_FAMILY_INSTANCES(SAL_ed_1)
+CPU_FAMILY_INSTANCES(SAL_eb_CL)
+CPU_FAMILY_INSTANCES(SAL_ew_CL)
+CPU_FAMILY_INSTANCES(SAL_ed_CL)
+CPU_FAMILY_INSTANCES(SHR_eb_ib)
+CPU_FAMILY_INSTANCES(SHR_ew_ib)
+CPU_FAMILY_INSTANCES(SHR_ed_ib)
+CPU_FAMILY_INSTANCES(SHR_eb_1)
+CPU_FAMILY_INSTANCES(SHR_ew_1)
+CPU_FAMILY_INSTANCES(SHR_ed_1)
+CPU_FAMILY_INSTANCES(SHR_eb_CL)
+CPU_FAMILY_INSTANCES(SHR_ew_CL)
+CPU_FAMILY_INSTANCES(SHR_ed_CL)
+CPU_FAMILY_INSTANCES(SAR_eb_ib)
+CPU_FAMILY_INSTANCES(SAR_ew_ib)
+CPU_FAMILY_INSTANCES(SAR_ed_ib)
+CPU_FAMILY_INSTANCES(SAR_eb_1)
+CPU_FAMILY_INSTANCES(SAR_ew_1)
+CPU_FAMILY_INSTANCES(SAR_ed_1)
+CPU_FAMILY_INSTANCES(SAR_eb_CL)
+CPU_FAMILY_INSTANCES(SAR_ew_CL)
+CPU_FAMILY_INSTANCES(SAR_ed_CL)
+CPU_FAMILY_INSTANCES(SGDT)
+CPU_FAMILY_INSTANCES(SIDT)
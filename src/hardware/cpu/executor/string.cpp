@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2024  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "hardware/cpu/executor.h"
+#include "hardware/cpu/mmu.h"
+#include "hardware/memory.h"
+#include "hardware/devices.h"
+#include <cstring>
+
+/* Bulk execution of REP string operations.
+ * When the remaining iterations of a MOVS/STOS/LODS/SCAS/CMPS access only
+ * plain system RAM, inside the segment limits and without crossing a page
+ * boundary, they are executed directly on the RAM buffer. INS/OUTS are
+ * executed in bulk if the I/O device supports block transfers. Anything else
+ * (expand-down segments, TLB misses, MMIO, memory traps, debug traps) is left
+ * to the normal one iteration per step path.
+ * The number of iterations is bounded by m_rep_bulk_max, which the CPU sets
+ * so that the next timer event is not overshot. The CPU is also responsible
+ * for the cycles accounting.
+ */
+
+uint32_t CPUExecutor::rep_bulk(uint32_t _count)
+{
+	if(UNLIKELY(DR7_ENABLED_ANY) || FLAG_TF) {
+		// debug exceptions must be checked on every iteration
+		return 0;
+	}
+
+	_count = std::min(_count, m_rep_bulk_max);
+
+	uint32_t count;
+	switch(m_instr->fn) {
+		case CPUExecutorFn::MOVSB_a16: case CPUExecutorFn::MOVSB_a32: count = rep_bulk_movs<uint8_t>(_count); break;
+		case CPUExecutorFn::MOVSW_a16: case CPUExecutorFn::MOVSW_a32: count = rep_bulk_movs<uint16_t>(_count); break;
+		case CPUExecutorFn::MOVSD_a16: case CPUExecutorFn::MOVSD_a32: count = rep_bulk_movs<uint32_t>(_count); break;
+		case CPUExecutorFn::STOSB_a16: case CPUExecutorFn::STOSB_a32: count = rep_bulk_stos<uint8_t>(_count); break;
+		case CPUExecutorFn::STOSW_a16: case CPUExecutorFn::STOSW_a32: count = rep_bulk_stos<uint16_t>(_count); break;
+		case CPUExecutorFn::STOSD_a16: case CPUExecutorFn::STOSD_a32: count = rep_bulk_stos<uint32_t>(_count); break;
+		case CPUExecutorFn::LODSB_a16: case CPUExecutorFn::LODSB_a32: count = rep_bulk_lods<uint8_t>(_count); break;
+		case CPUExecutorFn::LODSW_a16: case CPUExecutorFn::LODSW_a32: count = rep_bulk_lods<uint16_t>(_count); break;
+		case CPUExecutorFn::LODSD_a16: case CPUExecutorFn::LODSD_a32: count = rep_bulk_lods<uint32_t>(_count); break;
+		case CPUExecutorFn::SCASB_a16: case CPUExecutorFn::SCASB_a32: count = rep_bulk_scas<uint8_t>(_count); break;
+		case CPUExecutorFn::SCASW_a16: case CPUExecutorFn::SCASW_a32: count = rep_bulk_scas<uint16_t>(_count); break;
+		case CPUExecutorFn::SCASD_a16: case CPUExecutorFn::SCASD_a32: count = rep_bulk_scas<uint32_t>(_count); break;
+		case CPUExecutorFn::CMPSB_a16: case CPUExecutorFn::CMPSB_a32: count = rep_bulk_cmps<uint8_t>(_count); break;
+		case CPUExecutorFn::CMPSW_a16: case CPUExecutorFn::CMPSW_a32: count = rep_bulk_cmps<uint16_t>(_count); break;
+		case CPUExecutorFn::CMPSD_a16: case CPUExecutorFn::CMPSD_a32: count = rep_bulk_cmps<uint32_t>(_count); break;
+		case CPUExecutorFn::INSB_a16:  case CPUExecutorFn::INSB_a32:  count = rep_bulk_ins<uint8_t>(_count); break;
+		case CPUExecutorFn::INSW_a16:  case CPUExecutorFn::INSW_a32:  count = rep_bulk_ins<uint16_t>(_count); break;
+		case CPUExecutorFn::OUTSB_a16: case CPUExecutorFn::OUTSB_a32: count = rep_bulk_outs<uint8_t>(_count); break;
+		case CPUExecutorFn::OUTSW_a16: case CPUExecutorFn::OUTSW_a32: count = rep_bulk_outs<uint16_t>(_count); break;
+		default:
+			return 0;
+	}
+
+	m_rep_bulk_count = count;
+	return count;
+}
+
+/* Returns the host pointer to the string element at _seg:_offset, or nullptr
+ * if the bulk path cannot be used.
+ * _count is reduced to the number of elements that can be accessed in the
+ * current direction without leaving the segment, the address space, the page
+ * or the RAM block. _phy is the physical address of the element.
+ */
+uint8_t * CPUExecutor::rep_bulk_ptr(SegReg &_seg, uint32_t _offset, unsigned _size, bool _write,
+		uint32_t &_count, uint32_t &_phy)
+{
+	if(!_seg.desc.valid || _seg.desc.is_expand_down()) {
+		return nullptr;
+	}
+	if(_write) {
+		if(!_seg.desc.is_writeable()) {
+			return nullptr;
+		}
+	} else if(_seg.desc.is_code_segment() && !_seg.desc.is_readable()) {
+		return nullptr;
+	}
+	uint32_t limit = _seg.desc.limit;
+	if(_offset > limit || (limit - _offset) < (_size - 1)) {
+		return nullptr;
+	}
+
+	uint32_t linear = _seg.desc.base + _offset;
+	uint32_t page_offset = PAGE_OFFSET(linear);
+	if(page_offset + _size > 4096) {
+		return nullptr;
+	}
+	uint32_t count;
+	if(FLAG_DF) {
+		count = std::min(_offset, page_offset) / _size + 1;
+	} else {
+		uint64_t last = std::min(limit, m_addr_mask);
+		count = std::min(last - _offset + 1, uint64_t(4096 - page_offset)) / _size;
+	}
+
+	_phy = linear;
+	if(IS_PAGING() && !g_cpummu.TLB_probe(linear, IS_USER_PL, _phy, _write)) {
+		return nullptr;
+	}
+
+	_count = std::min(_count, count);
+	uint32_t lowest = _phy;
+	if(FLAG_DF) {
+		lowest -= (_count - 1) * _size;
+	}
+	uint8_t *ptr = g_memory.get_ram_ptr(lowest, _count * _size, _write);
+	if(!ptr) {
+		return nullptr;
+	}
+	return ptr + (_phy - lowest);
+}
+
+void CPUExecutor::rep_bulk_advance(unsigned _reg, uint32_t _bytes)
+{
+	if(FLAG_DF) {
+		_bytes = -_bytes;
+	}
+	if(m_addr_mask == 0xFFFF) {
+		GEN_REG(_reg).word[0] += _bytes;
+	} else {
+		GEN_REG(_reg).dword[0] += _bytes;
+	}
+}
+
+template<typename T>
+void CPUExecutor::rep_bulk_cmp(T _op1, T _op2)
+{
+	if(sizeof(T) == 1) {
+		CMP_b(_op1, _op2);
+	} else if(sizeof(T) == 2) {
+		CMP_w(_op1, _op2);
+	} else {
+		CMP_d(_op1, _op2);
+	}
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_movs(uint32_t _count)
+{
+	uint32_t src_phy, dst_phy;
+	uint8_t *src = rep_bulk_ptr(SEG_REG(m_base_ds), REG_ESI & m_addr_mask, sizeof(T), false, _count, src_phy);
+	if(!src) {
+		return 0;
+	}
+	uint8_t *dst = rep_bulk_ptr(REG_ES, REG_EDI & m_addr_mask, sizeof(T), true, _count, dst_phy);
+	if(!dst) {
+		return 0;
+	}
+
+	uint32_t bytes = _count * sizeof(T);
+	if(FLAG_DF) {
+		// point to the lowest elements
+		src -= bytes - sizeof(T);
+		dst -= bytes - sizeof(T);
+		dst_phy -= bytes - sizeof(T);
+	}
+	if(src + bytes <= dst || dst + bytes <= src) {
+		memcpy(dst, src, bytes);
+	} else if(FLAG_DF) {
+		// overlapping strings are copied one element at a time like the CPU does
+		for(uint32_t i = _count; i-- > 0;) {
+			*(T*)(&dst[i * sizeof(T)]) = *(T*)(&src[i * sizeof(T)]);
+		}
+	} else {
+		for(uint32_t i = 0; i < _count; i++) {
+			*(T*)(&dst[i * sizeof(T)]) = *(T*)(&src[i * sizeof(T)]);
+		}
+	}
+	g_memory.ram_written(dst_phy, bytes);
+
+	rep_bulk_advance(REGI_ESI, bytes);
+	rep_bulk_advance(REGI_EDI, bytes);
+
+	return _count;
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_stos(uint32_t _count)
+{
+	uint32_t dst_phy;
+	uint8_t *dst = rep_bulk_ptr(REG_ES, REG_EDI & m_addr_mask, sizeof(T), true, _count, dst_phy);
+	if(!dst) {
+		return 0;
+	}
+
+	uint32_t bytes = _count * sizeof(T);
+	if(FLAG_DF) {
+		dst -= bytes - sizeof(T);
+		dst_phy -= bytes - sizeof(T);
+	}
+	T value = T(REG_EAX);
+	if(sizeof(T) == 1) {
+		memset(dst, value, bytes);
+	} else {
+		for(uint32_t i = 0; i < _count; i++) {
+			*(T*)(&dst[i * sizeof(T)]) = value;
+		}
+	}
+	g_memory.ram_written(dst_phy, bytes);
+
+	rep_bulk_advance(REGI_EDI, bytes);
+
+	return _count;
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_lods(uint32_t _count)
+{
+	uint32_t src_phy;
+	uint8_t *src = rep_bulk_ptr(SEG_REG(m_base_ds), REG_ESI & m_addr_mask, sizeof(T), false, _count, src_phy);
+	if(!src) {
+		return 0;
+	}
+
+	// only the last element survives in the accumulator
+	uint32_t bytes = _count * sizeof(T);
+	if(FLAG_DF) {
+		src -= bytes - sizeof(T);
+	} else {
+		src += bytes - sizeof(T);
+	}
+	T value = *(T*)src;
+	if(sizeof(T) == 1) {
+		REG_AL = value;
+	} else if(sizeof(T) == 2) {
+		REG_AX = value;
+	} else {
+		REG_EAX = value;
+	}
+
+	rep_bulk_advance(REGI_ESI, bytes);
+
+	return _count;
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_scas(uint32_t _count)
+{
+	uint32_t dst_phy;
+	uint8_t *dst = rep_bulk_ptr(REG_ES, REG_EDI & m_addr_mask, sizeof(T), false, _count, dst_phy);
+	if(!dst) {
+		return 0;
+	}
+
+	// iterate up to and including the element that ends the repetition
+	T acc = T(REG_EAX);
+	T value;
+	uint32_t count = 0;
+	if(sizeof(T) == 1 && !FLAG_DF && !m_instr->rep_equal) {
+		uint8_t *found = (uint8_t*)memchr(dst, acc, _count);
+		if(found) {
+			count = found - dst + 1;
+			value = acc;
+		} else {
+			count = _count;
+			value = dst[_count - 1];
+		}
+	} else {
+		int step = FLAG_DF ? -int(sizeof(T)) : int(sizeof(T));
+		do {
+			value = *(T*)dst;
+			dst += step;
+			count++;
+		} while(count < _count && ((value == acc) == m_instr->rep_equal));
+	}
+	rep_bulk_cmp<T>(acc, value);
+
+	rep_bulk_advance(REGI_EDI, count * sizeof(T));
+
+	return count;
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_cmps(uint32_t _count)
+{
+	uint32_t src_phy, dst_phy;
+	uint8_t *src = rep_bulk_ptr(SEG_REG(m_base_ds), REG_ESI & m_addr_mask, sizeof(T), false, _count, src_phy);
+	if(!src) {
+		return 0;
+	}
+	uint8_t *dst = rep_bulk_ptr(REG_ES, REG_EDI & m_addr_mask, sizeof(T), false, _count, dst_phy);
+	if(!dst) {
+		return 0;
+	}
+
+	T op1, op2;
+	uint32_t count = 0;
+	if(!FLAG_DF && m_instr->rep_equal && memcmp(src, dst, _count * sizeof(T)) == 0) {
+		count = _count;
+		op1 = op2 = *(T*)(&src[(_count - 1) * sizeof(T)]);
+	} else {
+		int step = FLAG_DF ? -int(sizeof(T)) : int(sizeof(T));
+		do {
+			op1 = *(T*)src;
+			op2 = *(T*)dst;
+			src += step;
+			dst += step;
+			count++;
+		} while(count < _count && ((op1 == op2) == m_instr->rep_equal));
+	}
+	rep_bulk_cmp<T>(op1, op2);
+
+	rep_bulk_advance(REGI_ESI, count * sizeof(T));
+	rep_bulk_advance(REGI_EDI, count * sizeof(T));
+
+	return count;
+}
+
+/* I/O permissions are checked by the first iteration. Devices deliver data in
+ * port order, so only forward transfers are supported.
+ */
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_ins(uint32_t _count)
+{
+	if(FLAG_DF) {
+		return 0;
+	}
+	uint32_t dst_phy;
+	uint8_t *dst = rep_bulk_ptr(REG_ES, REG_EDI & m_addr_mask, sizeof(T), true, _count, dst_phy);
+	if(!dst) {
+		return 0;
+	}
+
+	uint32_t count = g_devices.read_block(REG_DX, dst, _count, sizeof(T));
+	if(count) {
+		g_memory.ram_written(dst_phy, count * sizeof(T));
+		rep_bulk_advance(REGI_EDI, count * sizeof(T));
+	}
+
+	return count;
+}
+
+template<typename T>
+uint32_t CPUExecutor::rep_bulk_outs(uint32_t _count)
+{
+	if(FLAG_DF) {
+		return 0;
+	}
+	uint32_t src_phy;
+	uint8_t *src = rep_bulk_ptr(SEG_REG(m_base_ds), REG_ESI & m_addr_mask, sizeof(T), false, _count, src_phy);
+	if(!src) {
+		return 0;
+	}
+
+	uint32_t count = g_devices.write_block(REG_DX, src, _count, sizeof(T));
+	if(count) {
+		rep_bulk_advance(REGI_ESI, count * sizeof(T));
+	}
+
+	return count;
+}
@@ -85,6 +85,7 @@ void CPUExecutor::switch_tasks_load_selector(SegReg &_seg, uint8_t _cs_rpl)
 
 		// All checks pass, fill in shadow cache
 		_seg.desc = descriptor;
+		_seg.update_window();
 	}
 }
 
@@ -331,6 +332,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 	REG_TR.sel  = selector;
 	REG_TR.desc = descriptor;
 	REG_TR.desc.type |= TSS_BUSY_BIT; // mark TSS in TR as busy
+	REG_TR.update_window();
 
 	// Step 9: Set TS flag
 
@@ -388,6 +390,10 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 	REG_ES.desc.valid   = false;
 	REG_FS.desc.valid   = false;
 	REG_GS.desc.valid   = false;
+	REG_LDTR.update_window();
+	for(unsigned sreg = REGI_ES; sreg <= REGI_GS; sreg++) {
+		SEG_REG(sreg).update_window();
+	}
 
 	if(descriptor.is_386_system() && IS_PAGING()) {
 		// change CR3 only if it actually modified
@@ -436,6 +442,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 
 		// All checks pass, fill in LDTR shadow cache
 		REG_LDTR.desc = ldt_descriptor;
+		REG_LDTR.update_window();
 
 	} else {
 		// NULL LDT selector is OK, leave cache invalid
@@ -492,6 +499,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 
 			// All checks pass, fill in cache
 			REG_SS.desc = ss_descriptor;
+			REG_SS.update_window();
 		} else {
 			// SS selector is valid, else #TS(new stack segment)
 			PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS NULL\n");
@@ -551,6 +559,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 
 			// All checks pass, fill in shadow cache
 			REG_CS.desc = cs_descriptor;
+			REG_CS.update_window();
 
 		} else {
 			// If new cs selector is null #TS(CS)
@@ -21,6 +21,7 @@
 #include "hardware/cpu.h"
 #include "mmu.h"
 #include "bus.h"
+#include "decoder.h"
 
 CPUMMU g_cpummu;
 
@@ -33,7 +34,7 @@ enum PageProtection {
 #define PAGE_ACCESSED 0x20
 #define PAGE_DIRTY    0x40
 
-void CPUMMU::page_fault(unsigned _prot, uint32_t _linear, bool _user, bool _write)
+CPUException CPUMMU::page_fault(unsigned _prot, uint32_t _linear, bool _user, bool _write)
 {
 	uint32_t error_code = _prot | (uint32_t(_user) << 2) | (uint32_t(_write) << 1);
 	SET_CR2(_linear);
@@ -45,10 +46,10 @@ void CPUMMU::page_fault(unsigned _prot, uint32_t _linear, bool _user, bool _writ
 		PDEBUGF(LOG_V2, LOG_MMU, "#PF at %08X, not present, %s, %s\n", _linear,
 			(_user)?"user":"supervisor", (_write)?"write":"read");
 	}
-	throw CPUException(CPU_PF_EXC, error_code);
+	return CPUException(CPU_PF_EXC, error_code);
 }
 
-void CPUMMU::protection_check(unsigned _prot, uint32_t _linear, bool _write)
+bool CPUMMU::protection_check(unsigned _prot, uint32_t _linear, bool _write, CPUException &_fault)
 {
 	static const unsigned combined_protection[16] = {
 		PAGE_SUPER, // super r  super r
@@ -70,11 +71,14 @@ void CPUMMU::protection_check(unsigned _prot, uint32_t _linear, bool _write)
 	};
 	if(combined_protection[_prot] == PAGE_SUPER ||
 	  (_write && (combined_protection[_prot] == PAGE_READ))) {
-		page_fault(PF_PROTECTION, _linear, true, _write);
+		_fault = page_fault(PF_PROTECTION, _linear, true, _write);
+		return false;
 	}
+	return true;
 }
 
-void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _write)
+bool CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _write,
+		CPUException &_fault)
 {
 	uint32_t ppf = PDBR;
 	unsigned prot = 0;
@@ -127,15 +131,16 @@ void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _wri
 		entry[table] = g_cpubus.mem_read<4>(entry_addr[table]);
 		if(!(entry[table] & 0x1)) {
 			// Raise not-present #PF
-			page_fault(PF_NOT_PRESENT, _linear, _user, _write);
+			_fault = page_fault(PF_NOT_PRESENT, _linear, _user, _write);
+			return false;
 		}
 		prot |= ((entry[table] & 0x6) >> 1) << table*2;
 		ppf = entry[table] & 0xFFFFF000;
 	}
 
-	if(_user) {
+	if(_user && !protection_check(prot, _linear, _write, _fault)) {
 		// Raise protection #PF
-		protection_check(prot, _linear, _write);
+		return false;
 	}
 
 	// Update TLB entry
@@ -161,9 +166,11 @@ void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _wri
 				PAGE_TBL_ENTRY(_linear), _write?"A/D bits":"A bit",
 				_tlbent->ppf, entry_addr[PTBL], entry[PTBL]);
 	}
+	return true;
 }
 
-uint32_t CPUMMU::TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write)
+bool CPUMMU::TLB_translate(uint32_t _linear, unsigned _len, bool _user, bool _write,
+		uint32_t &_phy, CPUException &_fault)
 {
 	TLBEntry *tlbent = &m_TLB[TLB_index(_linear, _len-1)];
 
@@ -185,15 +192,29 @@ uint32_t CPUMMU::TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _w
 		//            there was previous successful write access
 		if((!_user || (tlbent->access & 2)) &&
 		   (!_write || (tlbent->access & 1))) {
-			return tlbent->ppf | PAGE_OFFSET(_linear);
+			_phy = tlbent->ppf | PAGE_OFFSET(_linear);
+			return true;
 		}
 	} else {
 		tlbent->access = 0;
 	}
 	// re-walk page tables and raise faults if necessary
-	TLB_miss(_linear, tlbent, _user, _write);
+	if(!TLB_miss(_linear, tlbent, _user, _write, _fault)) {
+		return false;
+	}
 	// if no faults are raised then return the physical address
-	return tlbent->ppf | PAGE_OFFSET(_linear);
+	_phy = tlbent->ppf | PAGE_OFFSET(_linear);
+	return true;
+}
+
+uint32_t CPUMMU::TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write)
+{
+	uint32_t phy;
+	CPUException fault;
+	if(UNLIKELY(!TLB_translate(_linear, _len, _user, _write, phy, fault))) {
+		throw fault;
+	}
+	return phy;
 }
 
 void CPUMMU::TLB_check(uint32_t _linear, bool _user, bool _write)
@@ -207,6 +228,11 @@ void CPUMMU::TLB_flush()
 	for(unsigned n=0; n<TLB_SIZE; n++) {
 		m_TLB[n].lpf = -1;
 	}
+	// bytes in the prefetch queue could have been fetched with a different
+	// address translation
+	g_cpubus.pq_mark_stale();
+	// and the next instruction could be in a different physical page
+	g_cpudecoder.break_block();
 }
 
 uint32_t CPUMMU::dbg_translate_linear(uint32_t _linear_addr, uint32_t _pdbr, Memory *_memory)
@@ -20,6 +20,8 @@
 #ifndef IBMULATOR_CPU_MMU_H
 #define IBMULATOR_CPU_MMU_H
 
+#include "exception.h"
+
 class Memory;
 class CPUMMU;
 extern CPUMMU g_cpummu;
@@ -46,9 +48,24 @@ private:
 	TLBEntry m_TLB[TLB_SIZE];
 
 public:
+	// Throws the #PF if the page tables walk fails.
 	uint32_t TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write);
+	// Returns false and the #PF in _fault instead of throwing it.
+	bool TLB_translate(uint32_t _linear, unsigned _len, bool _user, bool _write,
+			uint32_t &_phy, CPUException &_fault);
 	void TLB_check(uint32_t _linear, bool _user, bool _write);
 	void TLB_flush();
+
+	// Lookup without page tables walking and faults.
+	inline bool TLB_probe(uint32_t _linear, bool _user, uint32_t &_phy, bool _write=false) const {
+		const TLBEntry *tlbent = &m_TLB[TLB_index(_linear, 0)];
+		if(tlbent->lpf == LPF_OF(_linear) && (!_user || (tlbent->access & 2)) &&
+		   (!_write || (tlbent->access & 1))) {
+			_phy = tlbent->ppf | PAGE_OFFSET(_linear);
+			return true;
+		}
+		return false;
+	}
 	static uint32_t dbg_translate_linear(uint32_t _linear_addr, uint32_t _pdbr, Memory *_memory);
 
 private:
@@ -56,9 +73,11 @@ private:
 		return (((_lpf + _len) & ((TLB_SIZE-1) << 12)) >> 12);
 	}
 
-	void TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _write);
-	void protection_check(unsigned _protection, uint32_t _linear, bool _write);
-	void page_fault(unsigned _fault, uint32_t _linear, bool _user, bool _write);
+	bool TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _write,
+			CPUException &_fault);
+	bool protection_check(unsigned _protection, uint32_t _linear, bool _write,
+			CPUException &_fault);
+	CPUException page_fault(unsigned _fault, uint32_t _linear, bool _user, bool _write);
 };
 
 #endif
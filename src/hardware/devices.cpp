@@ -486,6 +486,40 @@ void Devices::write_dword(uint16_t _port, uint32_t _value)
 	}
 }
 
+static inline uint io_len_mask(uint16_t _port, unsigned _io_len)
+{
+	switch(_io_len) {
+		case 1: return PORT_8BIT;
+		// odd ports are accessed one byte at a time
+		case 2: return (_port & 1) ? 0 : PORT_16BIT;
+		default: return 0;
+	}
+}
+
+unsigned Devices::read_block(uint16_t _port, uint8_t *_dst, unsigned _count, unsigned _io_len)
+{
+	io_handler_t &iohdl = m_read_handlers[_port];
+
+	m_last_io_time = 0;
+	uint mask = io_len_mask(_port, _io_len);
+	if(!mask || !(iohdl.mask & mask)) {
+		return 0;
+	}
+	return iohdl.device->read_block(_port, _dst, _count, _io_len);
+}
+
+unsigned Devices::write_block(uint16_t _port, const uint8_t *_src, unsigned _count, unsigned _io_len)
+{
+	io_handler_t &iohdl = m_write_handlers[_port];
+
+	m_last_io_time = 0;
+	uint mask = io_len_mask(_port, _io_len);
+	if(!mask || !(iohdl.mask & mask)) {
+		return 0;
+	}
+	return iohdl.device->write_block(_port, _src, _count, _io_len);
+}
+
 void Devices::remove(const char *_name)
 {
 	PDEBUGF(LOG_V1, LOG_MACHINE, "Removing device: %s\n", _name);
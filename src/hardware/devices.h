@@ -122,6 +122,8 @@ public:
 	void write_byte(uint16_t _port, uint8_t _value);
 	void write_word(uint16_t _port, uint16_t _value);
 	void write_dword(uint16_t _port, uint32_t _value);
+	unsigned read_block(uint16_t _port, uint8_t *_dst, unsigned _count, unsigned _io_len);
+	unsigned write_block(uint16_t _port, const uint8_t *_src, unsigned _count, unsigned _io_len);
 
 	inline void set_io_time(unsigned _io_time) {
 		m_last_io_time = _io_time;
@@ -189,7 +189,7 @@ void FloppyDrive::save_state(StateBuf &_state)
 {
 	_state.write(&m_s, {sizeof(m_s), str_format("FDD%u",m_drive_index).c_str()});
 
-	if(m_image) {
+	if(m_image && !_state.in_memory()) {
 		std::string imgfile = str_format("%s-floppy%u.bin", _state.get_basename().c_str(), m_drive_index);
 		try {
 			m_image->save_state(imgfile);
@@ -207,7 +207,9 @@ void FloppyDrive::restore_state(StateBuf &_state)
 
 	PINFOF(LOG_V1, LOG_FDC, "DRV%u: restoring state\n", m_drive_index);
 
-	if(g_program.config().get_bool(m_drive_config, DISK_INSERTED)) {
+	if(_state.in_memory()) {
+		// the current disk stays inserted
+	} else if(g_program.config().get_bool(m_drive_config, DISK_INSERTED)) {
 		std::string binpath = str_format("%s-floppy%u.bin", _state.get_basename().c_str(), m_drive_index);
 		std::string imgpath = g_program.config().get_string(m_drive_config, DISK_PATH);
 		if(!FileSys::file_exists(binpath.c_str())) {
@@ -281,6 +283,7 @@ void FloppyDrive::write_sector(uint8_t _s, const uint8_t *buffer, uint32_t bytes
 	}
 	m_image->write_sector(cyl, head, _s, buffer, bytes);
 	m_image->set_dirty();
+	g_machine.media_written();
 }
 
 bool FloppyDrive::insert_floppy(FloppyDisk *_disk)
@@ -778,6 +781,7 @@ void FloppyDrive::write_flux(uint64_t start, uint64_t end, unsigned transition_c
 	}
 
 	m_image->set_dirty();
+	g_machine.media_written();
 
 	cache_clear();
 
@@ -949,6 +953,7 @@ void FloppyDrive::set_write_splice(uint64_t when)
 {
 	if(m_image && is_motor_on()) {
 		m_image->set_dirty();
+		g_machine.media_written();
 		uint64_t base;
 		int splice_pos = find_position(base, when);
 		m_image->set_write_splice_position(m_s.cyl, m_s.ss, splice_pos);
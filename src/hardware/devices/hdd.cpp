@@ -406,8 +406,11 @@ void HardDiskDrive::save_state(StateBuf &_state)
 
 	_state.write(&m_s, {sizeof(m_s), str_format("HDD%u", m_drive_index).c_str()});
 
-	if(m_disk) {
+	if(m_disk && !_state.in_memory()) {
 		std::string path = _state.get_basename() + "-" + m_ini_section + ".img";
+		if(m_io) {
+			m_io->flush();
+		}
 		m_disk->save_state(path.c_str());
 	}
 }
@@ -420,7 +423,9 @@ void HardDiskDrive::restore_state(StateBuf &_state)
 		m_fx.clear_seek_events();
 	}
 
-	if(m_type > 0) {
+	if(_state.in_memory()) {
+		// the current image stays mounted
+	} else if(m_type > 0) {
 		assert(m_disk != nullptr);
 		std::string imgfile = _state.get_basename() + "-" + m_ini_section + ".img";
 		if(!FileSys::file_exists(imgfile.c_str())) {
@@ -529,7 +534,12 @@ void HardDiskDrive::mount(std::string _imgpath, MediaGeometry _geom, bool _tmp_i
 		throw std::exception();
 	}
 
-	m_disk = std::unique_ptr<FlatMediaImage>(new FlatMediaImage());
+	bool mapped = g_program.config().get_bool(DRIVES_SECTION, DRIVES_HDD_MMAP, true);
+	if(mapped) {
+		m_disk = std::unique_ptr<MappedMediaImage>(new MappedMediaImage());
+	} else {
+		m_disk = std::unique_ptr<FlatMediaImage>(new FlatMediaImage());
+	}
 	m_disk->geometry() = _geom;
 
 	if(!FileSys::file_exists(_imgpath.c_str())) {
@@ -561,7 +571,7 @@ void HardDiskDrive::mount(std::string _imgpath, MediaGeometry _geom, bool _tmp_i
 	}
 
 	if(_tmp_img || !FileSys::is_file_writeable(_imgpath.c_str())) {
-		PINFOF(LOG_V1, LOG_HDD, "The image file is read-only, using a replica\n");
+		PINFOF(LOG_V1, LOG_HDD, "The image file is read-only, using an overlay\n");
 
 		std::string dir, base, ext;
 		if(!FileSys::get_path_parts(_imgpath.c_str(), dir, base, ext)) {
@@ -571,13 +581,11 @@ void HardDiskDrive::mount(std::string _imgpath, MediaGeometry _geom, bool _tmp_i
 		std::string tpl = g_program.config().get_cfg_home()
 		                + FS_SEP + base + "-XXXXXX";
 
-		// opening a temp image
-		FlatMediaImage *image = dynamic_cast<FlatMediaImage*>(m_disk.get());
-		if(!image) {
-			assert(false);
-			throw std::exception();
-		}
-		if(image->open_temp(_imgpath.c_str(), tpl) < 0) {
+		// writes go to a temporary overlay file, the image is left untouched
+		OverlayMediaImage *image = new OverlayMediaImage(mapped);
+		m_disk = std::unique_ptr<OverlayMediaImage>(image);
+		m_disk->geometry() = _geom;
+		if(image->open_overlay(_imgpath.c_str(), tpl) < 0) {
 			PERRF(LOG_HDD, "Can't open the image file\n");
 			throw std::exception();
 		}
@@ -588,6 +596,10 @@ void HardDiskDrive::mount(std::string _imgpath, MediaGeometry _geom, bool _tmp_i
 			throw std::exception();
 		}
 	}
+
+	unsigned cache_kb = g_program.config().get_int(DRIVES_SECTION, DRIVES_HDD_CACHE, 2048);
+	unsigned read_ahead = g_program.config().get_int(DRIVES_SECTION, DRIVES_HDD_READAHEAD, 64);
+	m_io = std::unique_ptr<StorageIO>(new StorageIO(m_disk.get(), 512, cache_kb * 2, read_ahead));
 }
 
 void HardDiskDrive::commit() const
@@ -604,7 +616,12 @@ void HardDiskDrive::commit() const
 		path = FileSys::get_next_filename_time(m_path.c_str());
 	}
 	PINFOF(LOG_V0, LOG_HDD, "Saving %s image to '%s'\n", name(), path.c_str());
-	m_disk->save_state(path.c_str());
+	if(m_io && !m_io->flush()) {
+		PERRF(LOG_HDD, "%s: some sectors could not be written to the image\n", name());
+	}
+	if(!m_disk->save_state(path.c_str())) {
+		PERRF(LOG_HDD, "%s: error saving the image to '%s'\n", name(), path.c_str());
+	}
 }
 
 void HardDiskDrive::unmount()
@@ -613,6 +630,8 @@ void HardDiskDrive::unmount()
 		return;
 	}
 
+	// pending writes are completed before the I/O thread stops
+	m_io.reset(nullptr);
 	m_disk->close();
 
 	if(m_tmp_disk) {
@@ -633,19 +652,13 @@ bool HardDiskDrive::read_sector(int64_t _lba, uint8_t *_buffer, unsigned _len)
 	assert(_lba < m_sectors);
 	assert(_buffer != nullptr);
 	assert(_len == 512);
+	UNUSED(_len);
 
-	int64_t offset = _lba * _len;
-	int64_t pos = m_disk->lseek(offset, SEEK_SET);
-	if(pos != offset) {
-		PERRF(LOG_HDD, "%s: could not seek image file at byte %lu\n",
-				name(), offset);
-		throw std::exception();
-	}
-	ssize_t res = m_disk->read(_buffer, _len);
-	if(res != _len) {
-		PERRF(LOG_HDD, "%s: could not read image file at byte %lu\n",
-				name(), offset);
-		throw std::exception();
+	try {
+		m_io->read(_lba, _buffer);
+	} catch(std::exception &) {
+		PERRF(LOG_HDD, "%s: error reading sector %lld\n", name(), (long long)_lba);
+		throw;
 	}
 	return true;
 }
@@ -655,22 +668,17 @@ bool HardDiskDrive::write_sector(int64_t _lba, uint8_t *_buffer, unsigned _len)
 	assert(_lba < m_sectors);
 	assert(_buffer != nullptr);
 	assert(_len == 512);
+	UNUSED(_len);
 
-	int64_t offset = _lba * _len;
-	int64_t pos = m_disk->lseek(offset, SEEK_SET);
-	if(pos != offset) {
-		PERRF(LOG_HDD, "%s: could not seek image file at byte %lu\n",
-				name(), offset);
-		throw std::exception();
-	}
-	ssize_t res = m_disk->write(_buffer, _len);
-	if(res != _len) {
-		PERRF(LOG_HDD, "%s: could not write image file at byte %lu\n",
-				name(), offset);
-		throw std::exception();
+	try {
+		m_io->write(_lba, _buffer);
+	} catch(std::exception &) {
+		PERRF(LOG_HDD, "%s: error writing sector %lld\n", name(), (long long)_lba);
+		throw;
 	}
 
 	set_dirty();
+	g_machine.media_written();
 
 	return true;
 }
@@ -22,6 +22,7 @@
 
 #include "storagedev.h"
 #include "harddrvfx.h"
+#include "storageio.h"
 #include <memory>
 
 #define HDD_DRIVES_TABLE_SIZE 45
@@ -44,6 +45,7 @@ protected:
 	int m_type;
 	uint64_t m_spin_up_duration;
 	std::unique_ptr<MediaImage> m_disk;
+	std::unique_ptr<StorageIO> m_io;
 	bool m_tmp_disk;
 
 	struct {
@@ -451,3 +451,336 @@ bool FlatMediaImage::is_valid()
 
 	return true;
 }
+
+
+/*******************************************************************************
+ * MappedMediaImage
+ */
+
+MappedMediaImage::MappedMediaImage()
+:
+m_map(nullptr),
+m_pos(0)
+{
+}
+
+MappedMediaImage::~MappedMediaImage()
+{
+	MappedMediaImage::close();
+}
+
+int MappedMediaImage::open(const char* _pathname, int _flags)
+{
+	if(FlatMediaImage::open(_pathname, _flags) < 0) {
+		return -1;
+	}
+	m_pos = 0;
+#if HAVE_SYS_MMAN_H
+	int prot = PROT_READ;
+	if((_flags & O_ACCMODE) != O_RDONLY) {
+		prot |= PROT_WRITE;
+	}
+	void *map = mmap(nullptr, m_size, prot, MAP_SHARED, m_fd, 0);
+	if(map == MAP_FAILED) {
+		PWARNF(LOG_V0, LOG_HDD, "Cannot map '%s' in memory, using regular file access\n", _pathname);
+		m_map = nullptr;
+	} else {
+		PINFOF(LOG_V2, LOG_HDD, "Image file '%s' mapped in memory\n", _pathname);
+		m_map = (uint8_t*)map;
+	}
+#endif
+	return m_fd;
+}
+
+void MappedMediaImage::close()
+{
+#if HAVE_SYS_MMAN_H
+	if(m_map) {
+		sync();
+		munmap(m_map, m_size);
+		m_map = nullptr;
+	}
+#endif
+	FlatMediaImage::close();
+}
+
+int64_t MappedMediaImage::lseek(int64_t _offset, int _whence)
+{
+	if(!m_map) {
+		return FlatMediaImage::lseek(_offset, _whence);
+	}
+	int64_t pos;
+	switch(_whence) {
+		case SEEK_SET: pos = _offset; break;
+		case SEEK_CUR: pos = m_pos + _offset; break;
+		case SEEK_END: pos = int64_t(m_size) + _offset; break;
+		default: return -1;
+	}
+	if(pos < 0) {
+		return -1;
+	}
+	m_pos = pos;
+	return m_pos;
+}
+
+ssize_t MappedMediaImage::read(void *_buf, size_t _count)
+{
+	if(!m_map) {
+		return FlatMediaImage::read(_buf, _count);
+	}
+	if(uint64_t(m_pos) >= m_size) {
+		return 0;
+	}
+	size_t len = std::min(uint64_t(_count), m_size - m_pos);
+	memcpy(_buf, m_map + m_pos, len);
+	m_pos += len;
+	return len;
+}
+
+ssize_t MappedMediaImage::write(const void *_buf, size_t _count)
+{
+	if(!m_map) {
+		return FlatMediaImage::write(_buf, _count);
+	}
+	// the image size is fixed
+	if(uint64_t(m_pos) >= m_size) {
+		return 0;
+	}
+	size_t len = std::min(uint64_t(_count), m_size - m_pos);
+	memcpy(m_map + m_pos, _buf, len);
+	m_pos += len;
+	return len;
+}
+
+bool MappedMediaImage::sync()
+{
+#if HAVE_SYS_MMAN_H
+	if(m_map && msync(m_map, m_size, MS_SYNC) != 0) {
+		PERRF(LOG_HDD, "Error writing the mapped data of '%s'\n", m_pathname.c_str());
+		return false;
+	}
+#endif
+	return true;
+}
+
+bool MappedMediaImage::save_state(const char *_backup_fname)
+{
+	// the backup is read through the file descriptor
+	if(!sync()) {
+		return false;
+	}
+	return FlatMediaImage::save_state(_backup_fname);
+}
+
+
+/*******************************************************************************
+ * OverlayMediaImage
+ */
+
+OverlayMediaImage::OverlayMediaImage(bool _mapped_base)
+:
+m_base(_mapped_base ? new MappedMediaImage() : new FlatMediaImage()),
+m_fd(-1),
+m_used_blocks(0),
+m_pos(0)
+{
+	m_geometry = {0,0,0,0,0};
+}
+
+OverlayMediaImage::~OverlayMediaImage()
+{
+	OverlayMediaImage::close();
+}
+
+int OverlayMediaImage::open(const char *_pathname, int)
+{
+	if(m_template.empty()) {
+		PERRF(LOG_HDD, "Overlay file template not specified\n");
+		return -1;
+	}
+
+	// the base image is only read from
+	m_base->geometry() = m_geometry;
+	if(m_base->open(_pathname, O_RDONLY) < 0) {
+		return -1;
+	}
+
+	std::string path = m_template;
+	m_fd = FileSys::mkostemp(path, O_RDWR
+#ifdef O_BINARY
+			| O_BINARY
+#endif
+	);
+	if(m_fd < 0) {
+		PERRF(LOG_HDD, "Cannot create the overlay file '%s'\n", path.c_str());
+		m_base->close();
+		return -1;
+	}
+	PINFOF(LOG_V2, LOG_HDD, "Using overlay file '%s'\n", path.c_str());
+
+	m_pathname = path;
+	m_size = m_base->size();
+	m_blocks.assign((m_size + OVERLAY_BLOCK_SIZE - 1) / OVERLAY_BLOCK_SIZE, 0);
+	m_used_blocks = 0;
+	m_pos = 0;
+
+	return m_fd;
+}
+
+int OverlayMediaImage::open_overlay(const char *_pathname, const std::string &_template)
+{
+	m_template = _template;
+	return open(_pathname, O_RDONLY);
+}
+
+void OverlayMediaImage::close()
+{
+	if(m_fd > -1) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+	m_base->close();
+	m_blocks.clear();
+	m_used_blocks = 0;
+	m_size = 0;
+}
+
+int64_t OverlayMediaImage::lseek(int64_t _offset, int _whence)
+{
+	int64_t pos;
+	switch(_whence) {
+		case SEEK_SET: pos = _offset; break;
+		case SEEK_CUR: pos = m_pos + _offset; break;
+		case SEEK_END: pos = int64_t(m_size) + _offset; break;
+		default: return -1;
+	}
+	if(pos < 0) {
+		return -1;
+	}
+	m_pos = pos;
+	return m_pos;
+}
+
+ssize_t OverlayMediaImage::read_block(uint64_t _block, unsigned _offset, void *_buf, unsigned _len)
+{
+	uint32_t slot = m_blocks[_block];
+	if(slot) {
+		return read_image(m_fd, int64_t(slot - 1) * OVERLAY_BLOCK_SIZE + _offset, _buf, _len);
+	}
+	int64_t offset = int64_t(_block) * OVERLAY_BLOCK_SIZE + _offset;
+	if(m_base->lseek(offset, SEEK_SET) != offset) {
+		return -1;
+	}
+	return m_base->read(_buf, _len);
+}
+
+ssize_t OverlayMediaImage::read(void *_buf, size_t _count)
+{
+	uint8_t *buf = (uint8_t*)_buf;
+	size_t total = 0;
+	while(total < _count && uint64_t(m_pos) < m_size) {
+		uint64_t block = m_pos / OVERLAY_BLOCK_SIZE;
+		unsigned offset = m_pos % OVERLAY_BLOCK_SIZE;
+		unsigned len = std::min(uint64_t(OVERLAY_BLOCK_SIZE - offset),
+				std::min(uint64_t(_count - total), m_size - m_pos));
+		ssize_t res = read_block(block, offset, buf + total, len);
+		if(res < 0) {
+			return -1;
+		}
+		total += res;
+		m_pos += res;
+		if(unsigned(res) < len) {
+			break;
+		}
+	}
+	return total;
+}
+
+ssize_t OverlayMediaImage::write(const void *_buf, size_t _count)
+{
+	const uint8_t *buf = (const uint8_t*)_buf;
+	size_t total = 0;
+	uint8_t block_buf[OVERLAY_BLOCK_SIZE];
+	while(total < _count && uint64_t(m_pos) < m_size) {
+		uint64_t block = m_pos / OVERLAY_BLOCK_SIZE;
+		unsigned offset = m_pos % OVERLAY_BLOCK_SIZE;
+		unsigned len = std::min(uint64_t(OVERLAY_BLOCK_SIZE - offset),
+				std::min(uint64_t(_count - total), m_size - m_pos));
+		if(m_blocks[block]) {
+			int64_t pos = int64_t(m_blocks[block] - 1) * OVERLAY_BLOCK_SIZE + offset;
+			if(write_image(m_fd, pos, (void*)(buf + total), len) != int(len)) {
+				return -1;
+			}
+		} else {
+			// first write to this block: copy it from the base image
+			unsigned block_len = std::min(uint64_t(OVERLAY_BLOCK_SIZE),
+					m_size - block * OVERLAY_BLOCK_SIZE);
+			if(read_block(block, 0, block_buf, block_len) != ssize_t(block_len)) {
+				return -1;
+			}
+			memcpy(block_buf + offset, buf + total, len);
+			int64_t pos = int64_t(m_used_blocks) * OVERLAY_BLOCK_SIZE;
+			if(write_image(m_fd, pos, block_buf, block_len) != int(block_len)) {
+				return -1;
+			}
+			m_blocks[block] = ++m_used_blocks;
+		}
+		total += len;
+		m_pos += len;
+	}
+	return total;
+}
+
+bool OverlayMediaImage::write_dirty_blocks(int _fd)
+{
+	uint8_t block_buf[OVERLAY_BLOCK_SIZE];
+	for(uint64_t block = 0; block < m_blocks.size(); block++) {
+		if(!m_blocks[block]) {
+			continue;
+		}
+		unsigned block_len = std::min(uint64_t(OVERLAY_BLOCK_SIZE),
+				m_size - block * OVERLAY_BLOCK_SIZE);
+		if(read_block(block, 0, block_buf, block_len) != ssize_t(block_len)) {
+			return false;
+		}
+		if(write_image(_fd, int64_t(block) * OVERLAY_BLOCK_SIZE, block_buf, block_len) != int(block_len)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool OverlayMediaImage::save_state(const char *_backup_fname)
+{
+	bool merge = (m_base->get_name() == _backup_fname);
+	if(!merge && !hdimage_copy_file(m_base->get_name().c_str(), _backup_fname)) {
+		PERRF(LOG_HDD, "Cannot copy the base image to '%s'\n", _backup_fname);
+		return false;
+	}
+	int fd = FileSys::open(_backup_fname, O_RDWR
+#ifdef O_BINARY
+			| O_BINARY
+#endif
+	);
+	if(fd < 0) {
+		PERRF(LOG_HDD, "Cannot open '%s' for writing\n", _backup_fname);
+		return false;
+	}
+	PDEBUGF(LOG_V1, LOG_HDD, "Writing %u modified blocks to '%s'\n", m_used_blocks, _backup_fname);
+	bool ret = write_dirty_blocks(fd);
+	::close(fd);
+	return ret;
+}
+
+void OverlayMediaImage::restore_state(const char *_backup_fname)
+{
+	std::string overlay = m_pathname;
+	close();
+	if(!overlay.empty() && FileSys::remove(overlay.c_str()) < 0) {
+		PWARNF(LOG_V0, LOG_HDD, "Cannot remove '%s'!\n", overlay.c_str());
+	}
+	if(open(_backup_fname, O_RDONLY) < 0) {
+		PERRF(LOG_HDD, "Failed to open restored image '%s'\n", _backup_fname);
+		throw std::exception();
+	}
+}
@@ -22,6 +22,8 @@
 #define IBMULATOR_HW_HDIMAGE_H
 
 #include "filesys.h"
+#include <vector>
+#include <memory>
 
 #ifdef _WIN32
 #include "wincompat.h"
@@ -156,7 +158,7 @@ public:
  */
 class FlatMediaImage : public MediaImage
 {
-private:
+protected:
 
 	int m_fd;
 	std::string m_pathname;
@@ -205,4 +207,98 @@ public:
 	bool is_open() { return (m_fd > -1); }
 };
 
+
+/*******************************************************************************
+ * Flat image accessed through a shared memory mapping of the file.
+ * Read-only opens use a read-only mapping, so the host's page cache is shared
+ * between all the processes using the same image. If the image cannot be
+ * mapped the regular file access is used.
+ */
+class MappedMediaImage : public FlatMediaImage
+{
+private:
+
+	uint8_t *m_map;
+	int64_t m_pos;
+
+public:
+
+	MappedMediaImage();
+	~MappedMediaImage();
+
+	int open(const char* _pathname, int _flags);
+	void close();
+	int64_t lseek(int64_t _offset, int _whence);
+	ssize_t read(void* _buf, size_t _count);
+	ssize_t write(const void* _buf, size_t _count);
+
+	// Write the mapped data to the file
+	bool sync();
+
+	bool save_state(const char *_backup_fname);
+
+	bool is_mapped() const { return m_map != nullptr; }
+};
+
+
+/*******************************************************************************
+ * Copy-on-write overlay on top of a read-only flat image.
+ * Modified blocks are appended to a temporary overlay file, the base image is
+ * never written to, except when explicitly merged with save_state().
+ */
+#define OVERLAY_BLOCK_SIZE 4096
+
+class OverlayMediaImage : public MediaImage
+{
+private:
+
+	std::unique_ptr<FlatMediaImage> m_base;
+	int m_fd;
+	std::string m_pathname;
+	std::string m_template;
+	// block index -> overlay file slot + 1, 0 if the block is unmodified
+	std::vector<uint32_t> m_blocks;
+	uint32_t m_used_blocks;
+	int64_t m_pos;
+
+	ssize_t read_block(uint64_t _block, unsigned _offset, void *_buf, unsigned _len);
+	bool write_dirty_blocks(int _fd);
+
+public:
+
+	OverlayMediaImage(bool _mapped_base = false);
+	~OverlayMediaImage();
+
+	// Open _pathname as the read-only base image. The overlay file is created
+	// from the template given to open_overlay().
+	int open(const char *_pathname, int _flags);
+
+	// Open _pathname with a new overlay file created from _template.
+	int open_overlay(const char *_pathname, const std::string &_template);
+
+	// Close the image. The overlay file is not removed.
+	void close();
+
+	int64_t lseek(int64_t _offset, int _whence);
+	ssize_t read(void *_buf, size_t _count);
+	ssize_t write(const void *_buf, size_t _count);
+
+	uint32_t get_timestamp() { return m_base->get_timestamp(); }
+
+	// Write the merged image to _backup_fname. If _backup_fname is the base
+	// image only the modified blocks are written.
+	bool save_state(const char *_backup_fname);
+	// Use _backup_fname as the new base, discarding all the modifications.
+	void restore_state(const char *_backup_fname);
+
+	void create(const char *_pathname, unsigned _sectors) { m_base->create(_pathname, _sectors); }
+
+	// Get the overlay file name
+	std::string get_name() { return m_pathname; }
+	std::string get_base_name() { return m_base->get_name(); }
+	unsigned dirty_blocks() const { return m_used_blocks; }
+
+	bool is_open() { return (m_fd > -1); }
+};
+
 #endif
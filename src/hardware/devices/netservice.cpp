@@ -74,17 +74,17 @@ size_t NetService::TXFifo::read(uint8_t *_data, size_t _len, uint64_t _max_wait_
 {
 	// consumer (the tx thread use this and awaits on threshold)
 	if(get_read_avail() < m_threshold) {
-		std::unique_lock<std::mutex> lock(m_mutex);
+		std::unique_lock<std::mutex> lock(m_data_mtx);
 		m_data_cond.wait_for(lock, std::chrono::nanoseconds(_max_wait_ns));
 	}
-	return RingBuffer::read(_data, _len);
+	return SPSCRingBuffer::read(_data, _len);
 }
 
 
 size_t NetService::TXFifo::write(uint8_t *_data, size_t _len)
 {
 	// producer (the machine use this, the tx thread awaits on threshold)
-	size_t len = RingBuffer::write(_data, _len);
+	size_t len = SPSCRingBuffer::write(_data, _len);
 	if(get_read_avail() >= m_threshold) {
 		m_data_cond.notify_one();
 	}
@@ -45,12 +45,13 @@ public:
 		Client, ClientAsync, Server
 	};
 
-	class TXFifo : public RingBuffer {
+	class TXFifo : public SPSCRingBuffer {
 	protected:
 		std::atomic<unsigned> m_threshold = 1;
+		std::mutex m_data_mtx;
 		std::condition_variable m_data_cond;
 	public:
-		using RingBuffer::read;
+		using SPSCRingBuffer::read;
 		size_t read(uint8_t *_data, size_t _len, uint64_t _max_wait_ns);
 		size_t write(uint8_t *_data, size_t _len) override;
 		static unsigned ms_to_bytes(double _ms, unsigned _bps) {
@@ -222,12 +222,14 @@ void Parallel::send_byte()
 		if(m_tts_enabled) {
 			if(m_s.data == 0x0D) {
 				if(!m_tts_buf.empty()) {
-					GUI::instance()->tts().enqueue(m_tts_buf,
-						TTS::Priority::Normal,
-						TTS::BREAK_LINES | TTS::NOT_UTF8,
-						m_tts_buf.size() == 1,
-						TTSChannel::ID::Guest
-					);
+					if(GUI::instance()) {
+						GUI::instance()->tts().enqueue(m_tts_buf,
+							TTS::Priority::Normal,
+							TTS::BREAK_LINES | TTS::NOT_UTF8,
+							m_tts_buf.size() == 1,
+							TTSChannel::ID::Guest
+						);
+					}
 					m_tts_buf.clear();
 				}
 			} else if(m_s.data >= 0x20 && m_s.data != 0x7f && m_tts_buf.size() < 120) {
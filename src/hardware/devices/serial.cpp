@@ -92,7 +92,9 @@ void Serial::install()
 		m_host[p].tty_id = -1;
 		m_host[p].network.set_log_name(m_host[p].name());
 		m_host[p].network.set_mex_callback([](std::string _mex){
-			GUI::instance()->show_message(_mex.c_str());
+			if(GUI::instance()) {
+				GUI::instance()->show_message(_mex.c_str());
+			}
 		});
 		m_host[p].modem.set_MSR_callback(std::bind(&Serial::set_MSR, this, p, _1));
 		m_host[p].output = nullptr;
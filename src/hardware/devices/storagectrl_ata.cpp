@@ -856,6 +856,65 @@ uint16_t StorageCtrl_ATA::read(uint16_t _address, unsigned _len)
 	return value;
 }
 
+int StorageCtrl_ATA::data_port_channel(uint16_t _address)
+{
+	for(int channel=0; channel<ATA_MAX_CHANNEL; channel++) {
+		if(_address == m_channels[channel].ioaddr1) {
+			return channel;
+		}
+	}
+	return -1;
+}
+
+unsigned StorageCtrl_ATA::read_block(uint16_t _address, uint8_t *_dst, unsigned _count, unsigned _io_len)
+{
+	int channel = data_port_channel(_address);
+	if(channel < 0 || _io_len != 2) {
+		return 0;
+	}
+	Controller *controller = &selected_ctrl(channel);
+	if(!controller->status.drq || controller->buffer_index >= controller->buffer_size) {
+		return 0;
+	}
+
+	// the last word of the buffer / DRQ block is left to read()
+	unsigned words = (controller->buffer_size - controller->buffer_index) / 2;
+	switch(controller->current_command) {
+		case 0x20: // READ SECTORS, with retries
+		case 0x21: // READ SECTORS, without retries
+		case 0xC4: // READ MULTIPLE SECTORS
+		case 0x24: // READ SECTORS EXT
+		case 0x29: // READ MULTIPLE EXT
+			break;
+		case 0xa0: // SEND PACKET (atapi)
+			if(controller->drq_index >= controller->byte_count) {
+				return 0;
+			}
+			words = std::min(words, unsigned(controller->byte_count - controller->drq_index) / 2);
+			break;
+		default:
+			return 0;
+	}
+	if(words <= 1) {
+		return 0;
+	}
+	words = std::min(words - 1, _count);
+
+	unsigned bytes = words * 2;
+	memcpy(_dst, &controller->buffer[controller->buffer_index], bytes);
+
+	PDEBUGF(LOG_V3, LOG_HDD, "READ block %04d/%04d, %u words\n",
+			controller->buffer_index, (controller->buffer_size-1), words);
+
+	controller->buffer_index += bytes;
+	if(controller->current_command == 0xa0) {
+		controller->drq_index += bytes;
+		selected_drive(channel).atapi.bytes_remaining -= bytes;
+	}
+
+	return words;
+}
+
 void StorageCtrl_ATA::write(uint16_t _address, uint16_t _value, unsigned _len)
 {
 	bool prev_control_reset;
@@ -1267,6 +1326,45 @@ void StorageCtrl_ATA::write(uint16_t _address, uint16_t _value, unsigned _len)
 	update_busy_status();
 }
 
+unsigned StorageCtrl_ATA::write_block(uint16_t _address, const uint8_t *_src, unsigned _count, unsigned _io_len)
+{
+	int channel = data_port_channel(_address);
+	if(channel < 0 || _io_len != 2) {
+		return 0;
+	}
+	Controller *controller = &selected_ctrl(channel);
+	switch(controller->current_command) {
+		case 0x30: // WRITE SECTORS
+		case 0x31: // WRITE SECTORS NO RETRY
+		case 0xC5: // WRITE MULTIPLE SECTORS
+		case 0x34: // WRITE SECTORS EXT
+		case 0x39: // WRITE MULTIPLE EXT
+			break;
+		default:
+			return 0;
+	}
+	if(controller->buffer_index >= controller->buffer_size) {
+		return 0;
+	}
+
+	// the last word of the buffer is left to write(), it starts the sectors write
+	unsigned words = (controller->buffer_size - controller->buffer_index) / 2;
+	if(words <= 1) {
+		return 0;
+	}
+	words = std::min(words - 1, _count);
+
+	unsigned bytes = words * 2;
+	memcpy(&controller->buffer[controller->buffer_index], _src, bytes);
+
+	PDEBUGF(LOG_V3, LOG_HDD, "WRITE block %04d/%04d, %u words\n",
+			controller->buffer_index, (controller->buffer_size-1), words);
+
+	controller->buffer_index += bytes;
+
+	return words;
+}
+
 void StorageCtrl_ATA::update_busy_status()
 {
 	bool busy = false;
@@ -160,6 +160,8 @@ public:
 	void power_off();
 	uint16_t read(uint16_t _address, unsigned _len);
 	void write(uint16_t _address, uint16_t _value, unsigned _len);
+	unsigned read_block(uint16_t _address, uint8_t *_dst, unsigned _count, unsigned _io_len);
+	unsigned write_block(uint16_t _address, const uint8_t *_src, unsigned _count, unsigned _io_len);
 
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
@@ -195,6 +197,7 @@ private:
 	void command_timer(int _ch, int _device, uint64_t _time);
 
 	void update_busy_status();
+	int data_port_channel(uint16_t _address);
 
 	uint32_t ata_cmd_calibrate_drive(int _ch, uint8_t _cmd);
 	uint32_t ata_cmd_read_sectors(int _ch, uint8_t _cmd);
@@ -451,6 +451,62 @@ void StorageCtrl_PS1::write(uint16_t _address, uint16_t _value, unsigned)
 
 }
 
+unsigned StorageCtrl_PS1::read_block(uint16_t _address, uint8_t *_dst, unsigned _count, unsigned)
+{
+	if(m_disk.type() == 0 || _address != 0x320) {
+		return 0;
+	}
+	if((m_s.attch_status_reg & (ASR_DATA_REQ|ASR_DIR)) != (ASR_DATA_REQ|ASR_DIR)) {
+		return 0;
+	}
+	DataBuffer *databuf = get_read_data_buffer();
+	if(!databuf || databuf->ptr + 1 >= databuf->size) {
+		return 0;
+	}
+
+	// the last byte of the buffer is left to read(), it raises the interrupt
+	unsigned len = std::min(databuf->size - databuf->ptr - 1, _count);
+
+	m_devices->sysboard()->set_feedback();
+	m_s.attch_status_reg |= ASR_TX_EN;
+
+	PDEBUGF(LOG_V2, LOG_HDD, "read  0x%04X data %02d/%02d, %u bytes\n",
+			_address, databuf->ptr, (databuf->size-1), len);
+
+	memcpy(_dst, &databuf->stack[databuf->ptr], len);
+	databuf->ptr += len;
+
+	return len;
+}
+
+unsigned StorageCtrl_PS1::write_block(uint16_t _address, const uint8_t *_src, unsigned _count, unsigned)
+{
+	if(m_disk.type() == 0 || _address != 0x320) {
+		return 0;
+	}
+	if((m_s.attch_status_reg & (ASR_DATA_REQ|ASR_DIR)) != ASR_DATA_REQ) {
+		return 0;
+	}
+	DataBuffer *databuf = &m_s.sect_buffer[0];
+	if(databuf->ptr + 1 >= databuf->size) {
+		return 0;
+	}
+
+	// the last byte of the buffer is left to write(), it ends the transfer
+	unsigned len = std::min(databuf->size - databuf->ptr - 1, _count);
+
+	m_devices->sysboard()->set_feedback();
+	m_s.attch_status_reg |= ASR_TX_EN;
+
+	PDEBUGF(LOG_V2, LOG_HDD, "write 0x%04X data %02d/%02d, %u bytes\n",
+			_address, databuf->ptr, (databuf->size-1), len);
+
+	memcpy(&databuf->stack[databuf->ptr], _src, len);
+	databuf->ptr += len;
+
+	return len;
+}
+
 void StorageCtrl_PS1::exec_command()
 {
 	uint64_t cur_time_us = g_machine.get_virt_time_us();
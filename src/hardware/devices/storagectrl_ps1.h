@@ -153,6 +153,8 @@ public:
 	void power_off();
 	uint16_t read(uint16_t address, unsigned io_len);
 	void write(uint16_t address, uint16_t value, unsigned io_len);
+	unsigned read_block(uint16_t _address, uint8_t *_dst, unsigned _count, unsigned _io_len);
+	unsigned write_block(uint16_t _address, const uint8_t *_src, unsigned _count, unsigned _io_len);
 
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
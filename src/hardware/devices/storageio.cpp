@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2024  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "storageio.h"
+#include <future>
+#include <cstring>
+
+
+StorageIO::StorageIO(MediaImage *_media, unsigned _sector_size, unsigned _cache_sectors, unsigned _read_ahead)
+:
+m_media(_media),
+m_sector_size(_sector_size),
+m_cache_sectors(_cache_sectors),
+m_read_ahead(std::min(_read_ahead, _cache_sectors / 2)),
+m_write_error(false)
+{
+	assert(m_media && m_media->is_open());
+	m_sectors = m_media->size() / m_sector_size;
+
+	if(m_cache_sectors) {
+		m_thread = std::thread(&StorageIO::thread_start, this);
+	}
+}
+
+StorageIO::~StorageIO()
+{
+	if(m_thread.joinable()) {
+		m_cmd_queue.push([this] () {
+			m_quit = true;
+		});
+		m_thread.join();
+	}
+}
+
+void StorageIO::thread_start()
+{
+	PDEBUGF(LOG_V1, LOG_HDD, "StorageIO: thread started\n");
+
+	while(true) {
+		std::function<void()> fn;
+		m_cmd_queue.wait_and_pop(fn);
+		fn();
+		if(m_quit) {
+			break;
+		}
+	}
+
+	PDEBUGF(LOG_V1, LOG_HDD, "StorageIO: thread stopped\n");
+}
+
+void StorageIO::read(int64_t _lba, uint8_t *_buffer)
+{
+	assert(_lba < m_sectors);
+
+	if(!m_cache_sectors) {
+		if(!media_read(_lba, _buffer, 1)) {
+			throw std::exception();
+		}
+		return;
+	}
+
+	int64_t ahead_lba = 0, ahead_end = 0;
+	bool hit;
+	{
+		std::unique_lock<std::mutex> lock(m_cache_mtx);
+
+		// don't read again what the I/O thread is already reading
+		while(_lba >= m_inflight_lba && _lba < m_inflight_end) {
+			m_inflight_cv.wait(lock);
+		}
+		hit = cache_get(_lba, _buffer);
+
+		if(_lba != m_next_lba) {
+			// random access, restart the read-ahead
+			m_ahead_end = _lba + 1;
+		}
+		m_next_lba = _lba + 1;
+		if(m_read_ahead && _lba + m_read_ahead / 2 >= m_ahead_end && m_ahead_end < m_sectors) {
+			ahead_lba = std::max(m_ahead_end, _lba + 1);
+			ahead_end = std::min(_lba + 1 + m_read_ahead, m_sectors);
+			m_ahead_end = ahead_end;
+		}
+	}
+
+	if(!hit) {
+		if(!media_read(_lba, _buffer, 1)) {
+			throw std::exception();
+		}
+		std::lock_guard<std::mutex> lock(m_cache_mtx);
+		cache_put(_lba, _buffer, false);
+	}
+
+	if(ahead_end > ahead_lba) {
+		cmd_read_ahead(ahead_lba, ahead_end - ahead_lba);
+	}
+}
+
+void StorageIO::write(int64_t _lba, const uint8_t *_buffer)
+{
+	assert(_lba < m_sectors);
+
+	if(!m_cache_sectors) {
+		if(!media_write(_lba, _buffer, 1)) {
+			throw std::exception();
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_cache_mtx);
+		Sector &sector = cache_put(_lba, _buffer, true);
+		sector.pending_writes++;
+	}
+	cmd_write(_lba);
+}
+
+bool StorageIO::flush()
+{
+	if(m_thread.joinable()) {
+		std::promise<void> done;
+		m_cmd_queue.push([&done] () {
+			done.set_value();
+		});
+		done.get_future().wait();
+	}
+	return !m_write_error.exchange(false);
+}
+
+void StorageIO::cmd_read_ahead(int64_t _lba, unsigned _count)
+{
+	m_cmd_queue.push([=] () {
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mtx);
+			m_inflight_lba = _lba;
+			m_inflight_end = _lba + _count;
+		}
+		std::vector<uint8_t> buffer(_count * m_sector_size);
+		bool result = media_read(_lba, buffer.data(), _count);
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mtx);
+			if(result) {
+				PDEBUGF(LOG_V2, LOG_HDD, "StorageIO: read-ahead %lld-%lld\n",
+						(long long)_lba, (long long)(_lba + _count - 1));
+				// sectors written in the meantime are more recent than the media
+				for(unsigned s = 0; s < _count; s++) {
+					cache_put(_lba + s, &buffer[s * m_sector_size], false);
+				}
+			}
+			m_inflight_lba = m_inflight_end = 0;
+		}
+		m_inflight_cv.notify_all();
+	});
+}
+
+void StorageIO::cmd_write(int64_t _lba)
+{
+	m_cmd_queue.push([=] () {
+		std::vector<uint8_t> buffer;
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mtx);
+			auto it = m_index.find(_lba);
+			assert(it != m_index.end());
+			buffer = it->second->data;
+		}
+		if(!media_write(_lba, buffer.data(), 1)) {
+			m_write_error = true;
+		}
+		std::lock_guard<std::mutex> lock(m_cache_mtx);
+		auto it = m_index.find(_lba);
+		assert(it != m_index.end() && it->second->pending_writes);
+		it->second->pending_writes--;
+		cache_evict();
+	});
+}
+
+bool StorageIO::media_read(int64_t _lba, uint8_t *_buffer, unsigned _count)
+{
+	std::lock_guard<std::mutex> lock(m_media_mtx);
+
+	int64_t offset = _lba * m_sector_size;
+	int64_t pos = m_media->lseek(offset, SEEK_SET);
+	if(pos != offset) {
+		PERRF(LOG_HDD, "could not seek image file at byte %lld\n", (long long)offset);
+		return false;
+	}
+	ssize_t len = ssize_t(_count) * m_sector_size;
+	ssize_t res = m_media->read(_buffer, len);
+	if(res != len) {
+		PERRF(LOG_HDD, "could not read image file at byte %lld\n", (long long)offset);
+		return false;
+	}
+	return true;
+}
+
+bool StorageIO::media_write(int64_t _lba, const uint8_t *_buffer, unsigned _count)
+{
+	std::lock_guard<std::mutex> lock(m_media_mtx);
+
+	int64_t offset = _lba * m_sector_size;
+	int64_t pos = m_media->lseek(offset, SEEK_SET);
+	if(pos != offset) {
+		PERRF(LOG_HDD, "could not seek image file at byte %lld\n", (long long)offset);
+		return false;
+	}
+	ssize_t len = ssize_t(_count) * m_sector_size;
+	ssize_t res = m_media->write(_buffer, len);
+	if(res != len) {
+		PERRF(LOG_HDD, "could not write image file at byte %lld\n", (long long)offset);
+		return false;
+	}
+	return true;
+}
+
+bool StorageIO::cache_get(int64_t _lba, uint8_t *_buffer)
+{
+	auto it = m_index.find(_lba);
+	if(it == m_index.end()) {
+		return false;
+	}
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+	memcpy(_buffer, it->second->data.data(), m_sector_size);
+	return true;
+}
+
+StorageIO::Sector & StorageIO::cache_put(int64_t _lba, const uint8_t *_buffer, bool _replace)
+{
+	auto it = m_index.find(_lba);
+	if(it != m_index.end()) {
+		if(_replace) {
+			memcpy(it->second->data.data(), _buffer, m_sector_size);
+		}
+		return *it->second;
+	}
+	m_lru.push_front({_lba, std::vector<uint8_t>(_buffer, _buffer + m_sector_size), 0});
+	m_index[_lba] = m_lru.begin();
+	cache_evict();
+	return m_lru.front();
+}
+
+void StorageIO::cache_evict()
+{
+	// sectors waiting to be written are skipped, the cache can temporarily
+	// grow beyond its size if the I/O thread is behind
+	auto it = m_lru.end();
+	while(m_index.size() > m_cache_sectors && it != m_lru.begin()) {
+		--it;
+		if(it->pending_writes || it == m_lru.begin()) {
+			continue;
+		}
+		m_index.erase(it->lba);
+		it = m_lru.erase(it);
+	}
+}
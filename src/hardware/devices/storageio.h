@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_HW_STORAGEIO_H
+#define IBMULATOR_HW_STORAGEIO_H
+
+#include "shared_queue.h"
+#include "mediaimage.h"
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+
+/* Host side I/O for storage devices.
+ * Sectors are served from a LRU cache which is filled by a background thread
+ * with sequential read-ahead. Writes update the cache and are written to the
+ * media image by the same thread, in order.
+ * This only hides the host's I/O latency: when data becomes visible to the
+ * guest is still decided by the emulated drive.
+ */
+class StorageIO
+{
+private:
+	struct Sector {
+		int64_t lba;
+		std::vector<uint8_t> data;
+		unsigned pending_writes; // a sector with pending writes can't be evicted
+	};
+
+	MediaImage *m_media;
+	unsigned m_sector_size;
+	int64_t m_sectors;
+	unsigned m_cache_sectors;
+	unsigned m_read_ahead;
+
+	// lseek() + read()/write() pairs
+	std::mutex m_media_mtx;
+
+	// the cache, the read-ahead state and the in-flight range are protected
+	// by the cache mutex
+	std::mutex m_cache_mtx;
+	std::condition_variable m_inflight_cv;
+	std::list<Sector> m_lru; // most recently used first
+	std::unordered_map<int64_t, std::list<Sector>::iterator> m_index;
+	int64_t m_next_lba = -1;
+	int64_t m_ahead_end = 0;
+	int64_t m_inflight_lba = 0;
+	int64_t m_inflight_end = 0;
+
+	std::thread m_thread;
+	bool m_quit = false;
+	shared_queue<std::function<void()>> m_cmd_queue;
+	std::atomic<bool> m_write_error;
+
+public:
+	StorageIO(MediaImage *_media, unsigned _sector_size, unsigned _cache_sectors, unsigned _read_ahead);
+	~StorageIO();
+
+	// Throw std::exception on media errors.
+	void read(int64_t _lba, uint8_t *_buffer);
+	void write(int64_t _lba, const uint8_t *_buffer);
+
+	// Wait for all the pending writes. Returns false if any of them failed.
+	bool flush();
+
+private:
+	void thread_start();
+	void cmd_read_ahead(int64_t _lba, unsigned _count);
+	void cmd_write(int64_t _lba);
+
+	bool media_read(int64_t _lba, uint8_t *_buffer, unsigned _count);
+	bool media_write(int64_t _lba, const uint8_t *_buffer, unsigned _count);
+
+	bool cache_get(int64_t _lba, uint8_t *_buffer);
+	Sector & cache_put(int64_t _lba, const uint8_t *_buffer, bool _replace);
+	void cache_evict();
+};
+
+#endif
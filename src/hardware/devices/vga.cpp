@@ -72,8 +72,9 @@ enum VGATimerFunctionNames {
 VGA::VGA(Devices *_dev)
 : IODevice(_dev)
 {
-	m_line_data_buf[0].reserve(VGA_MAX_XRES);
-	m_line_data_buf[1].reserve(VGA_MAX_XRES);
+	for(auto &buf : m_line_data_buf) {
+		buf.reserve(VGA_MAX_XRES);
+	}
 
 	unsigned max_x_tiles = VGA_MAX_XRES / VGA_X_TILESIZE + ((VGA_MAX_XRES % VGA_X_TILESIZE) > 0);
 	m_tile_dirty.reserve(max_x_tiles * VGA_MAX_YRES);
@@ -84,6 +85,7 @@ VGA::VGA(Devices *_dev)
 
 VGA::~VGA()
 {
+	stop_render_workers();
 	if(m_memory != nullptr) {
 		delete[] m_memory;
 	}
@@ -99,6 +101,7 @@ void VGA::install()
 	m_memory = new uint8_t[m_memsize];
 	m_rom = new uint8_t[0x10000];
 	m_timer_id = g_machine.register_timer(nullptr, name());
+	m_prof_render = g_profiler.zone("VGA render", "vga");
 	/*
 	g_memory.register_trap(0xA0000, 0xBFFFF, MEM_TRAP_READ|MEM_TRAP_WRITE,
 	[this] (uint32_t addr, uint8_t rw, uint16_t value, uint8_t len) {
@@ -110,7 +113,7 @@ void VGA::install()
 	});
 	*/
 	m_mem_mapping = g_memory.add_mapping(0xA0000, 0x20000, MEM_MAPPING_EXTERNAL);
-	m_rom_mapping = g_memory.add_mapping(0xC0000, 0x10000, MEM_MAPPING_EXTERNAL,
+	m_rom_mapping = g_memory.add_mapping(0xC0000, 0x10000, MEM_MAPPING_EXTERNAL|MEM_MAPPING_STATIC,
 		VGA::s_rom_read<uint8_t>, VGA::s_rom_read<uint16_t>, VGA::s_rom_read<uint32_t>, this);
 }
 
@@ -150,6 +153,65 @@ void VGA::config_changed()
 	}
 	
 	m_bugs.ps_bit = g_program.config().get_bool(VGA_SECTION, VGA_PS_BIT_BUG);
+
+	unsigned threads;
+	std::string threads_str = g_program.config().get_string(VGA_SECTION, VGA_RENDER_THREADS);
+	if(threads_str == "auto") {
+		threads = std::max(2u, std::thread::hardware_concurrency() / 2);
+	} else {
+		threads = g_program.config().get_int(VGA_SECTION, VGA_RENDER_THREADS, 2);
+	}
+	threads = std::clamp(threads, 1u, unsigned(VGA_MAX_RENDER_THREADS));
+	if(threads != m_render.count) {
+		stop_render_workers();
+		start_render_workers(threads);
+	}
+	PINFOF(LOG_V1, LOG_VGA, "Render threads: %u\n", m_render.count);
+}
+
+void VGA::start_render_workers(unsigned _count)
+{
+	m_render.count = _count;
+	m_render.quit = false;
+	for(unsigned id = 1; id < _count; id++) {
+		m_render.threads.emplace_back(&VGA::render_worker, this, id, m_render.job);
+	}
+}
+
+void VGA::stop_render_workers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_render.mutex);
+		m_render.quit = true;
+	}
+	m_render.start.notify_all();
+	for(auto &thread : m_render.threads) {
+		thread.join();
+	}
+	m_render.threads.clear();
+	m_render.count = 1;
+}
+
+void VGA::render_worker(unsigned _id, unsigned _job)
+{
+	unsigned job = _job;
+	while(true) {
+		std::unique_lock<std::mutex> lock(m_render.mutex);
+		m_render.start.wait(lock, [&]{ return m_render.quit || m_render.job != job; });
+		if(m_render.quit) {
+			return;
+		}
+		job = m_render.job;
+		lock.unlock();
+
+		unsigned pix = gfx_update_thread(_id, m_render.line_compare[_id]);
+
+		lock.lock();
+		m_render.pix += pix;
+		if(--m_render.pending == 0) {
+			m_render.done.notify_one();
+		}
+	}
 }
 
 void VGA::remove()
@@ -158,6 +220,8 @@ void VGA::remove()
 	g_machine.unregister_irq(VGA_IRQ, name());
 	g_machine.unregister_timer(m_timer_id);
 
+	stop_render_workers();
+
 	if(m_memory != nullptr) {
 		delete[] m_memory;
 		m_memory = nullptr;
@@ -170,12 +234,24 @@ void VGA::remove()
 	g_memory.remove_mapping(m_mem_mapping);
 }
 
+void VGA::attach_display()
+{
+	if(m_display) {
+		return;
+	}
+	if(GUI::instance()) {
+		m_display = GUI::instance()->vga_display();
+	} else {
+		// headless mode, nobody will look at the frames but they're still rendered
+		m_own_display = std::make_unique<VGADisplay>();
+		m_display = m_own_display.get();
+	}
+}
+
 void VGA::reset(unsigned _type)
 {
 	if(_type == MACHINE_POWER_ON || _type == MACHINE_HARD_RESET) {
-		if(!m_display) {
-			m_display = GUI::instance()->vga_display();
-		}
+		attach_display();
 
 		m_s = {};
 
@@ -258,9 +334,7 @@ void VGA::restore_state(StateBuf &_state)
 	_state.read(m_memory, h);
 
 	// display
-	if(!m_display) {
-		m_display = GUI::instance()->vga_display();
-	}
+	attach_display();
 	m_display->restore_state(_state);
 
 	reset_tiles();
@@ -304,8 +378,9 @@ void VGA::restore_state(StateBuf &_state)
 			throw std::exception();
 	};
 
-	m_line_data_buf[0].resize(m_s.vmode.imgw);
-	m_line_data_buf[1].resize(m_s.vmode.imgw);
+	for(auto &buf : m_line_data_buf) {
+		buf.resize(m_s.vmode.imgw);
+	}
 
 	PDEBUGF(LOG_V1, LOG_VGA, "vtotal=%u\n", m_s.timings_ns.vtotal);
 	g_machine.set_heartbeat(m_s.timings_ns.vtotal);
@@ -683,8 +758,9 @@ void VGA::update_video_mode()
 		m_display->set_mode(m_s.vmode);
 		m_display->unlock();
 		
-		m_line_data_buf[0].resize(m_s.vmode.imgw);
-		m_line_data_buf[1].resize(m_s.vmode.imgw);
+		for(auto &buf : m_line_data_buf) {
+			buf.resize(m_s.vmode.imgw);
+		}
 	}
 }
 
@@ -1609,12 +1685,12 @@ unsigned VGA::gfx_update_thread(int _thread_id, uint16_t _thread_lc)
 			pix_updated += (this->*m_renderer)(scanline, scanline_addr, m_line_data_buf[_thread_id]);
 		}
 
-		scanline += VGA_THREAD_POOL_SIZE;
+		scanline += m_render.count;
 
 		if(scanline == _thread_lc) {
 			scanline_addr = (_thread_lc - m_s.CRTC.latches.line_compare) * m_s.CRTC.latches.line_offset;
 		} else {
-			scanline_addr += m_s.CRTC.latches.line_offset * VGA_THREAD_POOL_SIZE;
+			scanline_addr += m_s.CRTC.latches.line_offset * m_render.count;
 		}
 		
 	}
@@ -1622,6 +1698,38 @@ unsigned VGA::gfx_update_thread(int _thread_id, uint16_t _thread_lc)
 	return pix_updated;
 }
 
+unsigned VGA::gfx_update_frame()
+{
+	// Scanlines are interleaved between the workers: worker N renders lines
+	// vblank_skip+N, vblank_skip+N+count, ...
+	// Every worker needs the first line >= line_compare of its own set.
+	unsigned count = m_render.count;
+	unsigned i = m_s.CRTC.latches.line_compare % count;
+	for(unsigned j = 0; j < count; j++) {
+		m_render.line_compare[i] = m_s.CRTC.latches.line_compare + j;
+		i = (i + 1) % count;
+	}
+
+	if(count > 1) {
+		{
+			std::lock_guard<std::mutex> lock(m_render.mutex);
+			m_render.pix = 0;
+			m_render.pending = count - 1;
+			m_render.job++;
+		}
+		m_render.start.notify_all();
+	}
+
+	unsigned pix = gfx_update_thread(0, m_render.line_compare[0]);
+
+	if(count > 1) {
+		std::unique_lock<std::mutex> lock(m_render.mutex);
+		m_render.done.wait(lock, [this]{ return m_render.pending == 0; });
+		pix += m_render.pix;
+	}
+	return pix;
+}
+
 void VGA::text_update()
 {
 	// this version works only if called at frame_end
@@ -1697,6 +1805,7 @@ void VGA::horiz_disp_end(uint64_t _time)
 	
 	// skip top blank area
 	if(m_renderer && m_s.scanline >= m_s.timings.vblank_skip) {
+		ProfileScope prof(m_prof_render);
 		m_cur_upd_pix += (this->*m_renderer)(m_s.scanline, m_s.mem_addr_counter, m_line_data_buf[0]);
 		if(g_machine.cycles_factor() < 1.0 || g_machine.is_paused()) {
 			m_display->set_fb_updated();
@@ -1800,27 +1909,14 @@ void VGA::frame_end(uint64_t _time)
 		((m_s.vmode.mode==VGA_M_EGA || m_s.vmode.mode==VGA_M_TEXT) && m_s.blink_toggle))
 	)
 	{
+		ProfileScope prof(m_prof_render);
 		m_display->lock();
 		if(m_s.vmode.mode == VGA_M_TEXT) {
 			text_update();
 		} else if(m_s.render_mode == VGA_RENDER_FRAME) {
 			// This frame's rendering happens only if rendering mode did not change
 			// since the last frame_start.
-			int lc_first_thread = m_s.CRTC.latches.line_compare % VGA_THREAD_POOL_SIZE;
-			uint16_t lc_w[VGA_THREAD_POOL_SIZE];
-			int i=lc_first_thread, j=0;
-			do {
-				lc_w[i] = m_s.CRTC.latches.line_compare + j;
-				i = (i+1) % VGA_THREAD_POOL_SIZE;
-				j++;
-			} while(j<VGA_THREAD_POOL_SIZE);
-			
-			std::future<uint32_t> w0 = std::async(std::launch::async, [&]() {
-				return gfx_update_thread(0, lc_w[0]);
-			});
-			uint32_t w1 = gfx_update_thread(1, lc_w[1]);
-			w0.wait();
-			m_stats.updated_pix = (w0.get() + w1);
+			m_stats.updated_pix = gfx_update_frame();
 		} else {
 			m_stats.updated_pix = 0;
 		}
@@ -2109,9 +2205,7 @@ void VGA::print_text(std::vector<uint16_t> _text)
 	}
 	std::vector<uint16_t> oldtxt(80*25,0);
 	
-	if(!m_display) {
-		m_display = GUI::instance()->vga_display();
-	}
+	attach_display();
 	m_display->lock();
 	m_display->text_update(
 		(uint8_t*)(oldtxt.data()),
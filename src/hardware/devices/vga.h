@@ -30,6 +30,10 @@
 #include "vga_dac.h"
 #include "hardware/iodevice.h"
 #include "machine.h"
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 enum VGATimings {
 	VGA_8BIT_SLOW,
@@ -151,7 +155,7 @@ typedef unsigned (VGA::*VGADrawFn)(unsigned _scanline, uint16_t _scanaddr, std::
 
 #include "vgadisplay.h"
 
-#define VGA_THREAD_POOL_SIZE 2
+#define VGA_MAX_RENDER_THREADS 16
 
 class VGA : public IODevice
 {
@@ -210,9 +214,24 @@ protected:
 	VGATimings m_vga_timing = VGA_8BIT_SLOW;
 	double m_bus_timing = 1.0;
 	TimerID m_timer_id = NULL_TIMER_ID;
+	Profiler::ZoneID m_prof_render = PROFILER_NULL_ZONE;
 	VGADisplay *m_display = nullptr;
+	std::unique_ptr<VGADisplay> m_own_display; // used when there's no GUI
 	VGADrawFn m_renderer = nullptr;
-	std::vector<uint8_t> m_line_data_buf[VGA_THREAD_POOL_SIZE];
+	std::vector<uint8_t> m_line_data_buf[VGA_MAX_RENDER_THREADS];
+	// frame rendering worker pool, the machine thread is worker 0
+	struct {
+		unsigned count = 1;   // number of workers, machine thread included
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable start;
+		std::condition_variable done;
+		unsigned job = 0;     // incremented for every frame to render
+		unsigned pending = 0; // pool threads still rendering
+		unsigned pix = 0;     // pixels updated by the pool threads
+		bool quit = false;
+		uint16_t line_compare[VGA_MAX_RENDER_THREADS];
+	} m_render;
 	// tiling system
 	uint16_t m_num_x_tiles = 0;
 	std::vector<uint8_t> m_tile_dirty; // don't use bool, it's not thread safe
@@ -273,6 +292,7 @@ protected:
 	void frame_end(uint64_t _time);
 	void vertical_retrace(uint64_t _time);
 	
+	void attach_display();
 	void reset_tiles();
 	void calculate_timings();
 	bool is_video_disabled();
@@ -287,6 +307,10 @@ protected:
 
 	void text_update();
 	unsigned gfx_update_thread(int _thread_id, uint16_t _line_compare);
+	unsigned gfx_update_frame();
+	void start_render_workers(unsigned _count);
+	void stop_render_workers();
+	void render_worker(unsigned _id, unsigned _job);
 	
 	//unsigned draw_gfx_cga2(unsigned _scanline, uint16_t _scanaddr, std::vector<uint8_t> &line_data_);
 	unsigned draw_gfx_cga(unsigned _scanline, uint16_t _scanaddr, std::vector<uint8_t> &line_data_);
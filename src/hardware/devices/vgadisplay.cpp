@@ -28,6 +28,68 @@
 #include "gui/gui.h"
 #include <cstring>
 #include <sstream>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PALETTE_EXPAND_AVX2 1
+#else
+#define PALETTE_EXPAND_AVX2 0
+#endif
+
+// Converts _count 8-bit palette indices into 32-bit colors.
+// With double-dot (_dc) every color is written twice.
+static void palette_expand_scalar(uint32_t *_dst, const uint8_t *_src, unsigned _count,
+		const uint32_t *_palette, bool _dc)
+{
+	for(unsigned i = 0; i < _count; i++) {
+		uint32_t color = _palette[_src[i]];
+		if(_dc) {
+			_dst[i*2] = color;
+			_dst[i*2+1] = color;
+		} else {
+			_dst[i] = color;
+		}
+	}
+}
+
+#if PALETTE_EXPAND_AVX2
+// Gathers 8 colors at once and doubles them with a permute. Compiled for AVX2
+// regardless of the build flags, called only if the host CPU supports it.
+__attribute__((target("avx2")))
+static void palette_expand_avx2(uint32_t *_dst, const uint8_t *_src, unsigned _count,
+		const uint32_t *_palette, bool _dc)
+{
+	unsigned i = 0;
+	const __m256i dc_lo = _mm256_setr_epi32(0,0,1,1,2,2,3,3);
+	const __m256i dc_hi = _mm256_setr_epi32(4,4,5,5,6,6,7,7);
+	for(; i + 8 <= _count; i += 8) {
+		__m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&_src[i]));
+		__m256i col = _mm256_i32gather_epi32((const int*)_palette, idx, 4);
+		if(_dc) {
+			_mm256_storeu_si256((__m256i*)&_dst[i*2], _mm256_permutevar8x32_epi32(col, dc_lo));
+			_mm256_storeu_si256((__m256i*)&_dst[i*2+8], _mm256_permutevar8x32_epi32(col, dc_hi));
+		} else {
+			_mm256_storeu_si256((__m256i*)&_dst[i], col);
+		}
+	}
+	palette_expand_scalar(&_dst[i << _dc], &_src[i], _count - i, _palette, _dc);
+}
+#endif
+
+static inline void palette_expand(uint32_t *_dst, const uint8_t *_src, unsigned _count,
+		const uint32_t *_palette, bool _dc)
+{
+#if PALETTE_EXPAND_AVX2
+	static const bool avx2 = [](){
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	}();
+	if(avx2) {
+		palette_expand_avx2(_dst, _src, _count, _palette, _dc);
+		return;
+	}
+#endif
+	palette_expand_scalar(_dst, _src, _count, _palette, _dc);
+}
 
 FrameBuffer::FrameBuffer()
 :
@@ -178,7 +240,7 @@ void VGADisplay::notify_interface()
 	lock();
 	
 	// if double buffering is enabled do a full copy
-	if(GUI::instance()->vga_buffering_enabled() || m_buffering) {
+	if(m_buffering || (GUI::instance() && GUI::instance()->vga_buffering_enabled())) {
 		// we must lock the display because another thread could be reading
 		// the internal buffer
 		m_last_fb = m_fb;
@@ -232,7 +294,7 @@ void VGADisplay::unregister_sink(int _id)
 void VGADisplay::clear_screen()
 {
 	m_fb.clear();
-	if(GUI::instance()->vga_buffering_enabled() || m_buffering) {
+	if(m_buffering || (GUI::instance() && GUI::instance()->vga_buffering_enabled())) {
 		// TODO is this necessary?
 		m_last_fb.clear();
 	}
@@ -345,25 +407,19 @@ void VGADisplay::gfx_screen_line_update(
 
 	uint32_t *fb_line_ptr = &m_fb[0] + _fbline * m_fb.width();
 	bool dc = (m_s.mode.ndots == 2);
+	const uint32_t *palette = m_s.palette[m_color_mode];
 	
 	for(uint16_t tile_id=0; tile_id<_tiles_count; tile_id++, _tiles++) {
 		if(*_tiles == VGA_TILE_CLEAN) {
 			continue;
 		}
 		unsigned pixel_x = tile_id * VGA_X_TILESIZE;
-		for(int tile_x=0; tile_x<VGA_X_TILESIZE; tile_x++,pixel_x++) {
-			if(pixel_x >= m_s.mode.imgw) {
-				// the last tile could be wider than needed
-				break;
-			}
-			assert(pixel_x < _linedata.size());
-			uint32_t color = m_s.palette[m_color_mode][_linedata[pixel_x]];
-			uint32_t *fb_point_ptr = &fb_line_ptr[pixel_x << dc];
-			*fb_point_ptr = color;
-			if(dc) {
-				*(fb_point_ptr+1) = color;
-			}
-		};
+		if(pixel_x < m_s.mode.imgw) {
+			// the last tile could be wider than needed
+			unsigned count = std::min(unsigned(VGA_X_TILESIZE), m_s.mode.imgw - pixel_x);
+			assert(pixel_x + count <= _linedata.size());
+			palette_expand(&fb_line_ptr[pixel_x << dc], &_linedata[pixel_x], count, palette, dc);
+		}
 		*_tiles = VGA_TILE_CLEAN;
 	}
 }
@@ -384,15 +440,8 @@ void VGADisplay::gfx_screen_line_update(unsigned _fbline,
 
 	uint32_t *fb_line_ptr = &m_fb[0] + _fbline * m_fb.width();
 	bool dc = (m_s.mode.ndots == 2);
-	
-	for(unsigned pixel_x=0; pixel_x<m_s.mode.imgw; pixel_x++) {
-		uint32_t color = m_s.palette[m_color_mode][_linedata[pixel_x]];
-		uint32_t *fb_point_ptr = &fb_line_ptr[pixel_x << dc];
-		*fb_point_ptr = color;
-		if(dc) {
-			*(fb_point_ptr+1) = color;
-		}
-	}
+
+	palette_expand(fb_line_ptr, &_linedata[0], m_s.mode.imgw, m_s.palette[m_color_mode], dc);
 }
 
 // text_update()
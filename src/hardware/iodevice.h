@@ -64,6 +64,12 @@ public:
 	virtual void config_changed() {}
 	virtual uint16_t read(uint16_t /*_address*/, unsigned /*_io_len*/) { return ~0; }
 	virtual void write(uint16_t /*_address*/, uint16_t /*_value*/, unsigned /*_io_len*/) {}
+	// Block transfers for REP INS/OUTS: move up to _count elements of _io_len
+	// bytes and return how many were moved. A device must serve only the
+	// elements whose read()/write() would have no effect other than moving data
+	// (the element completing a transfer must go through read()/write()).
+	virtual unsigned read_block(uint16_t /*_address*/, uint8_t * /*_dst*/, unsigned /*_count*/, unsigned /*_io_len*/) { return 0; }
+	virtual unsigned write_block(uint16_t /*_address*/, const uint8_t * /*_src*/, unsigned /*_count*/, unsigned /*_io_len*/) { return 0; }
 	virtual void save_state(StateBuf &) {}
 	virtual void restore_state(StateBuf &) {}
 	virtual void cycles_adjust(double) {}
@@ -29,6 +29,7 @@
 #include <cstring>
 #include <algorithm>
 #include <cmath>
+#include <random>
 
 #define DRAM_TIME_NS 120.0
 
@@ -47,6 +48,8 @@ Memory::Memory()
 	m_s.mask = 0x00FFFFFF;
 	m_s.A20_enabled = true;
 	memset(m_s.mapstate, MEM_ANY, sizeof(m_s.mapstate));
+	memset(m_traps_pages, 0, sizeof(m_traps_pages));
+	memset(m_code_pages, 0, sizeof(m_code_pages));
 
 	remap(0, 0xFFFFFFFF);
 }
@@ -67,10 +70,10 @@ void Memory::init()
 	*/
 
 	// sizes and cycles are finalized in config_changed()
-	m_ram.low_mapping = add_mapping(0x000000, 0xA0000, MEM_MAPPING_INTERNAL,
+	m_ram.low_mapping = add_mapping(0x000000, 0xA0000, MEM_MAPPING_INTERNAL|MEM_MAPPING_STATIC,
 			Memory::s_read<uint8_t>, Memory::s_read<uint16_t>, Memory::s_read<uint32_t>, this,
 			Memory::s_write<uint8_t>, Memory::s_write<uint16_t>, Memory::s_write<uint32_t>, this);
-	m_ram.high_mapping = add_mapping(0x100000, 0x00000, MEM_MAPPING_INTERNAL,
+	m_ram.high_mapping = add_mapping(0x100000, 0x00000, MEM_MAPPING_INTERNAL|MEM_MAPPING_STATIC,
 			Memory::s_read<uint8_t>, Memory::s_read<uint16_t>, Memory::s_read<uint32_t>, this,
 			Memory::s_write<uint8_t>, Memory::s_write<uint16_t>, Memory::s_write<uint32_t>, this);
 }
@@ -79,6 +82,7 @@ void Memory::reset(unsigned _signal)
 {
 	if(_signal == MACHINE_POWER_ON || _signal == MACHINE_HARD_RESET) {
 		memset(m_ram.buffer, 0, m_ram.buffer_size);
+		invalidate_pages(0, MAX_MEM_SIZE);
 	}
 }
 
@@ -144,22 +148,184 @@ void Memory::config_changed()
 		m_ram.cycles, m_ram.cycles, (g_cpubus.width()==16)?m_ram.cycles*2:m_ram.cycles);
 
 	memset(m_s.mapstate, MEM_ANY, sizeof(m_s.mapstate));
+
+	// the buffer has been reallocated, the next state will be a full one
+	m_snapshot.id = 0;
+	m_snapshot.chain.clear();
+	m_snapshot.max_chain = g_program.config().get_int(CAPTURE_SECTION, CAPTURE_STATE_CHAIN, 0);
+}
+
+// State basenames are in the form <capture dir>/<state name>/<file name>
+static std::string state_name(const std::string &_basename)
+{
+	size_t file = _basename.rfind(FS_SEP);
+	if(file == std::string::npos || file == 0) {
+		return "";
+	}
+	size_t dir = _basename.rfind(FS_SEP, file - 1);
+	dir = (dir == std::string::npos) ? 0 : dir + 1;
+	return _basename.substr(dir, file - dir);
+}
+
+static std::string state_sibling(const std::string &_basename, const std::string &_name)
+{
+	size_t file = _basename.rfind(FS_SEP);
+	std::string name = state_name(_basename);
+	size_t dir = file - name.size();
+	return _basename.substr(0, dir) + _name + _basename.substr(file);
+}
+
+std::vector<uint32_t> Memory::dirty_pages(uint64_t _since_seq) const
+{
+	std::vector<uint32_t> pages;
+	uint32_t count = (m_ram.buffer_size + MEM_PAGE_SIZE - 1) >> MEM_PAGE_SHIFT;
+	for(uint32_t page=0; page<count; page++) {
+		if(m_page_seq[page] > _since_seq) {
+			pages.push_back(page);
+		}
+	}
+	return pages;
 }
 
 void Memory::save_state(StateBuf &_state)
 {
 	_state.write(&m_s, {sizeof(m_s), "Memory state"});
-	_state.write(m_ram.buffer, {m_ram.buffer_size, "Memory buffer"});
+
+	static std::mt19937_64 rng(std::random_device{}());
+	Snapshot snap{0, 0, m_ram.buffer_size, 0};
+	do {
+		snap.id = rng();
+	} while(!snap.id);
+
+	std::string name = state_name(_state.get_basename());
+	std::string base;
+	if(m_snapshot.id && !m_snapshot.chain.empty() && !name.empty()
+		&& m_snapshot.chain.size() <= m_snapshot.max_chain
+		&& std::find(m_snapshot.chain.begin(), m_snapshot.chain.end(), name) == m_snapshot.chain.end())
+	{
+		base = m_snapshot.chain.front();
+		// Program::save_state() waits for the state writer, so the base is
+		// already on disk if it was saved successfully
+		if(!FileSys::file_exists((state_sibling(_state.get_basename(), base) + STATEBUF_FILE_EXT).c_str())) {
+			base.clear();
+		}
+	}
+
+	if(base.empty()) {
+		_state.write(&snap, {sizeof(snap), "Memory snapshot"});
+		_state.write(m_ram.buffer, {m_ram.buffer_size, "Memory buffer"});
+		if(name.empty()) {
+			// not a savestate on disk, it can't be used as a base
+			return;
+		}
+		m_snapshot.chain.clear();
+	} else {
+		std::vector<uint32_t> pages = dirty_pages(m_snapshot.seq);
+		std::vector<uint8_t> data(pages.size() * MEM_PAGE_SIZE);
+		size_t size = 0;
+		for(auto page : pages) {
+			uint32_t addr = page << MEM_PAGE_SHIFT;
+			uint32_t len = std::min(MEM_PAGE_SIZE, m_ram.buffer_size - addr);
+			memcpy(&data[size], &m_ram.buffer[addr], len);
+			size += len;
+		}
+		snap.base_id = m_snapshot.id;
+		snap.pages = pages.size();
+		_state.write(&snap, {sizeof(snap), "Memory snapshot"});
+		_state.write(base.c_str(), {base.size() + 1, "Memory base"});
+		_state.write(pages.data(), {pages.size() * sizeof(uint32_t), "Memory pages"});
+		_state.write(data.data(), {size, "Memory data"});
+		PDEBUGF(LOG_V1, LOG_MEM, "Saved %zu pages of %u, based on '%s'\n",
+				pages.size(), m_ram.buffer_size >> MEM_PAGE_SHIFT, base.c_str());
+	}
+
+	m_snapshot.id = snap.id;
+	m_snapshot.seq = m_write_seq;
+	m_snapshot.chain.insert(m_snapshot.chain.begin(), name);
 }
 
 void Memory::restore_state(StateBuf &_state)
 {
 	_state.read(&m_s, {sizeof(m_s), "Memory state"});
-	_state.read(m_ram.buffer, {m_ram.buffer_size, "Memory buffer"});
+
+	Snapshot snap;
+	_state.read(&snap, {sizeof(snap), "Memory snapshot"});
+	std::vector<std::string> chain;
+	restore_ram(_state, snap, chain);
 
 	// every device that modify mappings during execution (eg. SVGA) must
 	// restore its mappings state
 	remap(0, 0xFFFFFFFF);
+
+	if(chain.front().empty()) {
+		m_snapshot.id = 0;
+		m_snapshot.chain.clear();
+	} else {
+		m_snapshot.id = snap.id;
+		m_snapshot.seq = m_write_seq;
+		m_snapshot.chain = chain;
+	}
+}
+
+void Memory::restore_ram(StateBuf &_state, const Snapshot &_snap, std::vector<std::string> &_chain)
+{
+	if(_snap.buffer_size != m_ram.buffer_size) {
+		PERRF(LOG_MEM, "Memory size mismatch (%u != %u)\n", _snap.buffer_size, m_ram.buffer_size);
+		throw std::exception();
+	}
+	_chain.push_back(state_name(_state.get_basename()));
+
+	if(!_snap.base_id) {
+		_state.read(m_ram.buffer, {m_ram.buffer_size, "Memory buffer"});
+		return;
+	}
+
+	StateHeader h;
+	_state.get_next_lump_header(h);
+	std::vector<char> base(h.data_size + 1, 0);
+	_state.read(base.data(), {h.data_size, "Memory base"});
+	if(std::find(_chain.begin(), _chain.end(), base.data()) != _chain.end()) {
+		PERRF(LOG_MEM, "Invalid savestate chain\n");
+		throw std::exception();
+	}
+
+	// rebuild the base first, then apply the changed pages
+	StateBuf base_state(state_sibling(_state.get_basename(), base.data()));
+	Snapshot base_snap;
+	try {
+		base_state.load(base_state.get_basename() + STATEBUF_FILE_EXT);
+		if(!base_state.find("Memory snapshot")) {
+			throw std::exception();
+		}
+		base_state.read(&base_snap, {sizeof(base_snap), "Memory snapshot"});
+	} catch(std::exception &) {
+		PERRF(LOG_MEM, "Cannot load the base savestate '%s'\n", base.data());
+		throw;
+	}
+	if(base_snap.id != _snap.base_id) {
+		PERRF(LOG_MEM, "The base savestate '%s' has been overwritten\n", base.data());
+		throw std::exception();
+	}
+	restore_ram(base_state, base_snap, _chain);
+
+	std::vector<uint32_t> pages(_snap.pages);
+	_state.read(pages.data(), {pages.size() * sizeof(uint32_t), "Memory pages"});
+	_state.get_next_lump_header(h);
+	std::vector<uint8_t> data(h.data_size);
+	_state.read(data.data(), {h.data_size, "Memory data"});
+	size_t size = 0;
+	for(auto page : pages) {
+		uint32_t addr = page << MEM_PAGE_SHIFT;
+		if(addr >= m_ram.buffer_size) {
+			throw std::exception();
+		}
+		uint32_t len = std::min(MEM_PAGE_SIZE, m_ram.buffer_size - addr);
+		if(size + len > data.size()) {
+			throw std::exception();
+		}
+		memcpy(&m_ram.buffer[addr], &data[size], len);
+		size += len;
+	}
 }
 
 int Memory::add_mapping(uint32_t _base, uint32_t _size, unsigned _flags,
@@ -197,10 +363,12 @@ void Memory::resize_mapping(int _mapping, uint32_t _newbase, uint32_t _newsize)
 			remap(it->start(), it->end());
 			it->enabled = true;
 		}
+		uint32_t oldend = it->end();
 		it->base = _newbase;
 		it->size = _newsize;
 		assert(it->end() / MEM_MAP_GRANULARITY < MEM_MAP_SIZE);
-		remap(it->start(), it->end());
+		// blocks left by a shrunk mapping must be remapped too
+		remap(it->start(), std::max(it->end(), oldend));
 	} else {
 		PERRF(LOG_MEM, "Cannot find mapping %d\n", _mapping);
 	}
@@ -302,7 +470,12 @@ template<>
 uint32_t Memory::read_mapped<1>(uint32_t _addr, int &_cycles) const noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].read;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.read_ram)) {
+		_cycles += entry.read->cycles.byte;
+		return m_ram.buffer[_addr];
+	}
+	MemMapping *map = entry.read;
 	if(map->read.byte) {
 		_cycles += map->cycles.byte;
 		return map->read.byte(_addr, map->read.priv);
@@ -314,7 +487,12 @@ template<>
 uint32_t Memory::read_mapped<2>(uint32_t _addr, int &_cycles) const noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].read;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.read_ram)) {
+		_cycles += entry.read->cycles.word;
+		return *(uint16_t*)(&m_ram.buffer[_addr]);
+	}
+	MemMapping *map = entry.read;
 	if(map->read.word) {
 		if((_addr&0x1) && (map->flags&MEM_MAPPING_EXTERNAL)) {
 			/* 16bit external bus
@@ -340,7 +518,12 @@ template<>
 uint32_t Memory::read_mapped<4>(uint32_t _addr, int &_cycles) const noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].read;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.read_ram)) {
+		_cycles += entry.read->cycles.dword;
+		return *(uint32_t*)(&m_ram.buffer[_addr]);
+	}
+	MemMapping *map = entry.read;
 	if(map->read.dword) {
 		_cycles += map->cycles.dword;
 		return map->read.dword(_addr, map->read.priv);
@@ -355,9 +538,17 @@ template<>
 void Memory::write_mapped<1>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.write_ram)) {
+		_cycles += entry.write->cycles.byte;
+		page_written<1>(_addr);
+		m_ram.buffer[_addr] = _data;
+		return;
+	}
+	MemMapping *map = entry.write;
 	if(map->write.byte) {
 		_cycles += map->cycles.byte;
+		page_written<1>(_addr);
 		map->write.byte(_addr, _data, map->write.priv);
 	}
 }
@@ -366,7 +557,14 @@ template<>
 void Memory::write_mapped<2>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.write_ram)) {
+		_cycles += entry.write->cycles.word;
+		page_written<2>(_addr);
+		*(uint16_t*)(&m_ram.buffer[_addr]) = _data;
+		return;
+	}
+	MemMapping *map = entry.write;
 	if(map->write.word) {
 		if((_addr&0x1) && (map->flags&MEM_MAPPING_EXTERNAL)) {
 			/* 16bit external bus
@@ -379,6 +577,7 @@ void Memory::write_mapped<2>(uint32_t _addr, uint32_t _data, int &_cycles) noexc
 		}
 		// if odd address then it must be 32-bit internal bus
 		_cycles += map->cycles.word;
+		page_written<2>(_addr);
 		map->write.word(_addr, _data, map->write.priv);
 		return;
 	}
@@ -390,9 +589,17 @@ template<>
 void Memory::write_mapped<4>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
-	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	if(LIKELY(entry.write_ram)) {
+		_cycles += entry.write->cycles.dword;
+		page_written<4>(_addr);
+		*(uint32_t*)(&m_ram.buffer[_addr]) = _data;
+		return;
+	}
+	MemMapping *map = entry.write;
 	if(map->write.dword) {
 		_cycles += map->cycles.dword;
+		page_written<4>(_addr);
 		map->write.dword(_addr, _data, map->write.priv);
 		return;
 	}
@@ -400,6 +607,10 @@ void Memory::write_mapped<4>(uint32_t _addr, uint32_t _data, int &_cycles) noexc
 	write_mapped<2>(_addr+2, (_data>>16), _cycles);
 }
 
+/* Returns the RAM buffer pointer for the debugger. Writes done through the
+ * pointer must be signalled with ram_written(), so that written code pages are
+ * invalidated.
+ */
 uint8_t * Memory::get_buffer_ptr(uint32_t _addr)
 {
 	_addr &= m_s.mask;
@@ -409,6 +620,39 @@ uint8_t * Memory::get_buffer_ptr(uint32_t _addr)
 	return &m_ram.buffer[_addr];
 }
 
+/* Returns the RAM buffer pointer for direct accesses to the [_phy,_phy+_len)
+ * range, or nullptr if the range is not plain system RAM inside a single map
+ * block. Writes done through the pointer must be signalled with ram_written().
+ */
+uint8_t * Memory::get_ram_ptr(uint32_t _phy, uint32_t _len, bool _write)
+{
+	_phy &= m_s.mask;
+	if((_phy / MEM_MAP_GRANULARITY) != ((_phy + _len - 1) / MEM_MAP_GRANULARITY)) {
+		return nullptr;
+	}
+	if(has_traps(_phy, _len)) {
+		return nullptr;
+	}
+	const MapEntry &entry = m_map[_phy / MEM_MAP_GRANULARITY];
+	if(!(_write ? entry.write_ram : entry.read_ram)) {
+		return nullptr;
+	}
+	return &m_ram.buffer[_phy];
+}
+
+void Memory::ram_written(uint32_t _phy, uint32_t _len)
+{
+	_phy &= m_s.mask;
+	uint64_t seq = ++m_write_seq;
+	uint32_t last = (_phy + _len - 1) >> MEM_PAGE_SHIFT;
+	for(uint32_t page = _phy >> MEM_PAGE_SHIFT; page <= last; page++) {
+		m_page_seq[page] = seq;
+		if(m_code_pages[page]) {
+			code_page_written(page);
+		}
+	}
+}
+
 void Memory::DMA_read(uint32_t _addr, uint16_t _len, uint8_t *_buf)
 {
 	int c = 0;
@@ -419,6 +663,8 @@ void Memory::DMA_read(uint32_t _addr, uint16_t _len, uint8_t *_buf)
 
 void Memory::DMA_write(uint32_t _addr, uint16_t _len, uint8_t *_buf)
 {
+	// every byte goes through write_mapped(), code pages loaded by DMA are
+	// signalled like CPU writes
 	int c = 0;
 	for(uint16_t i=0; i<_len; i++) {
 		write<1>(_addr+i, _buf[i], c);
@@ -445,6 +691,8 @@ void Memory::remap(uint32_t _start, uint32_t _end)
 		assert(index < MEM_MAP_SIZE);
 		m_map[index].read = &nullmap;
 		m_map[index].write = &nullmap;
+		m_map[index].read_ram = false;
+		m_map[index].write_ram = false;
 	}
 	for(auto mapping=m_mappings.begin(); mapping != m_mappings.end(); mapping++) {
 		if(!mapping->enabled || mapping->size == 0) {
@@ -456,18 +704,54 @@ void Memory::remap(uint32_t _start, uint32_t _end)
 			for(uint64_t i=start; i<end; i+=MEM_MAP_GRANULARITY) {
 				int index = i / MEM_MAP_GRANULARITY;
 				assert(index < MEM_MAP_SIZE);
+				bool is_ram = (mapping->name == m_ram.low_mapping || mapping->name == m_ram.high_mapping);
 				if(mapping->read_is_allowed(m_s.mapstate[index])) {
 					m_map[index].read = &*mapping;
+					m_map[index].read_ram = is_ram;
 				}
 				if(mapping->write_is_allowed(m_s.mapstate[index])) {
 					m_map[index].write = &*mapping;
+					m_map[index].write_ram = is_ram;
 				}
 			}
 		}
 	}
+	invalidate_pages(_start, _end);
 	g_cpummu.TLB_flush();
 }
 
+void Memory::invalidate_pages(uint32_t _start, uint32_t _end)
+{
+	// the content of the pages could have been changed without writes
+	uint64_t end = std::min(uint64_t(_end), uint64_t(MAX_MEM_SIZE));
+	uint64_t seq = ++m_write_seq;
+	for(uint64_t page=(_start>>MEM_PAGE_SHIFT); page<((end+0xFFF)>>MEM_PAGE_SHIFT); page++) {
+		m_page_seq[page] = seq;
+		if(m_code_pages[page]) {
+			code_page_written(page);
+		}
+	}
+}
+
+void Memory::register_code_handler(codewrite_fun_t _fn)
+{
+	m_code_handlers.push_back(_fn);
+}
+
+void Memory::code_page_written(uint32_t _page) noexcept
+{
+	m_code_pages[_page] = 0;
+	for(auto &fn : m_code_handlers) {
+		fn(_page << MEM_PAGE_SHIFT);
+	}
+}
+
+bool Memory::is_static(uint32_t _phy) const
+{
+	_phy &= m_s.mask;
+	return (m_map[_phy / MEM_MAP_GRANULARITY].read->flags & MEM_MAPPING_STATIC);
+}
+
 bool Memory::MemMapping::read_is_allowed(unsigned _state)
 {
 	if(!read.byte && !read.word && !read.dword) {
@@ -577,27 +861,44 @@ void Memory::dump(const std::string &_filename, uint32_t _address, uint _len)
 	file.close();
 }
 
-void Memory::check_trap(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len)
+void Memory::call_traps(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len)
 const noexcept
 {
-	if(MEMORY_TRAPS) {
-		std::vector<memtrap_interval_t> results;
-		m_traps_tree.findOverlapping(_address, _address, results);
-		for(auto &t : results) {
-			if(t.value.mask & _mask) {
-				t.value.func(_address, _mask, _value, _len);
-				if(STOP_AT_MEM_TRAPS) {
-					g_machine.set_single_step(true);
-				}
+	std::vector<memtrap_interval_t> results;
+	m_traps_tree.findOverlapping(_address, _address, results);
+	for(auto &t : results) {
+		if(t.value.mask & _mask) {
+			t.value.func(_address, _mask, _value, _len);
+			if(STOP_AT_MEM_TRAPS) {
+				g_machine.set_single_step(true);
 			}
 		}
 	}
 }
 
+bool Memory::has_traps(uint32_t _address, uint32_t _len) const noexcept
+{
+	if(!MEMORY_TRAPS || !_len) {
+		return false;
+	}
+	uint32_t last = (_address + _len - 1) >> MEM_PAGE_SHIFT;
+	for(uint32_t page = _address >> MEM_PAGE_SHIFT; page <= last; page++) {
+		if(m_traps_pages[page & (MEM_PAGES-1)]) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void Memory::register_trap(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _fn)
 {
 	m_traps_intervals.push_back(memtrap_interval_t(_lo, _hi, memtrap_t(_mask, _fn)));
 	m_traps_tree = memtrap_intervalTree_t(m_traps_intervals);
+	// pages are wrapped at MEM_PAGES like check_trap() does
+	uint32_t last = std::min(_hi >> MEM_PAGE_SHIFT, (_lo >> MEM_PAGE_SHIFT) + MEM_PAGES - 1);
+	for(uint32_t page = _lo >> MEM_PAGE_SHIFT; page <= last; page++) {
+		m_traps_pages[page & (MEM_PAGES-1)] |= _mask;
+	}
 }
 
 void Memory::s_debug_trap(uint32_t _address,  // address
@@ -40,6 +40,11 @@
 
 #define MEM_MAPPING_EXTERNAL 1  // memory on external bus
 #define MEM_MAPPING_INTERNAL 2  // system RAM
+#define MEM_MAPPING_STATIC   4  // content changes only via the write functions (RAM, ROMs)
+
+#define MEM_PAGE_SHIFT      12
+#define MEM_PAGE_SIZE       (1u << MEM_PAGE_SHIFT)
+#define MEM_PAGES           (MAX_MEM_SIZE >> MEM_PAGE_SHIFT)
 
 #define MEM_READ_MASK       0x0F
 #define MEM_READ_DISABLED   0x00
@@ -83,6 +88,10 @@ struct memtrap_t {
 typedef Interval<memtrap_t> memtrap_interval_t;
 typedef IntervalTree<memtrap_t> memtrap_intervalTree_t;
 
+typedef std::function<void(
+		uint32_t   // physical address of the written code page
+	)> codewrite_fun_t;
+
 typedef uint32_t (*mem_read_fn_t)(uint32_t _address, void *_privdata);
 typedef void (*mem_write_fn_t)(uint32_t _address, uint32_t _value, void *_privdata);
 
@@ -109,6 +118,9 @@ protected:
 
 	memtrap_intervalTree_t m_traps_tree;
 	std::vector<memtrap_interval_t> m_traps_intervals;
+	// the MEM_TRAP_* bits of the traps on each 4KiB page, only accesses to
+	// pages with a trap query the interval tree
+	uint8_t m_traps_pages[MEM_PAGES];
 
 	struct MemMapping
 	{
@@ -144,9 +156,47 @@ protected:
 	struct MapEntry {
 		MemMapping *read;
 		MemMapping *write;
+		// the block is plain system RAM, accesses can go directly to m_ram.buffer
+		bool read_ram;
+		bool write_ram;
 	};
 	MapEntry m_map[MEM_MAP_SIZE];
 
+	/* Write tracking for the CPU decoded instructions cache.
+	 * Every write increments the sequence number, which is then stored in the
+	 * written 4KiB page slot. Cached code can be trusted if its page has not
+	 * been written after the instruction bytes were fetched.
+	 */
+	uint64_t m_write_seq = 0;
+	uint64_t m_page_seq[MEM_PAGES];
+
+	/* Code pages.
+	 * Pages holding bytes that have been fetched or cached as instructions.
+	 * The first write to a code page (CPU, DMA, bulk or remap) calls the
+	 * registered handlers and clears the flag, which must be set again by
+	 * the next fetch from the page.
+	 */
+	uint8_t m_code_pages[MEM_PAGES];
+	std::vector<codewrite_fun_t> m_code_handlers;
+
+	/* Differential save states.
+	 * A state can store only the pages written since the state the RAM was
+	 * last saved to or restored from (its base), using the write sequence
+	 * numbers above. Bases can be differential too, up to max_chain states.
+	 */
+	struct Snapshot {
+		uint64_t id;
+		uint64_t base_id; // 0 if the whole buffer is stored
+		uint32_t buffer_size;
+		uint32_t pages;
+	};
+	struct {
+		uint64_t id = 0;
+		uint64_t seq = 0;
+		std::vector<std::string> chain; // the last state's name, then its bases
+		unsigned max_chain = 0;
+	} m_snapshot;
+
 public:
 	Memory();
 	~Memory();
@@ -154,7 +204,12 @@ public:
 	void init();
 	void reset(unsigned _signal);
 	void config_changed();
-	void check_trap(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len) const noexcept;
+	inline void check_trap(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len) const noexcept {
+		if(MEMORY_TRAPS && UNLIKELY(m_traps_pages[(_address >> MEM_PAGE_SHIFT) & (MEM_PAGES-1)] & _mask)) {
+			call_traps(_address, _mask, _value, _len);
+		}
+	}
+	bool has_traps(uint32_t _address, uint32_t _len) const noexcept;
 
 	int add_mapping(uint32_t _base, uint32_t _size, unsigned _flags,
 			mem_read_fn_t _read_byte=nullptr,
@@ -178,8 +233,24 @@ public:
 
 	void set_A20_line(bool _enabled);
 	inline bool get_A20_line() const { return m_s.A20_enabled; }
+	inline uint32_t address_mask() const { return m_s.mask; }
+
+	inline uint64_t write_seq() const { return m_write_seq; }
+	inline uint64_t page_write_seq(uint32_t _phy) const {
+		return m_page_seq[(_phy & m_s.mask) >> MEM_PAGE_SHIFT];
+	}
+	bool is_static(uint32_t _phy) const;
+	void invalidate_pages(uint32_t _start, uint32_t _end);
+
+	inline void mark_code_page(uint32_t _phy) noexcept {
+		m_code_pages[(_phy & m_s.mask) >> MEM_PAGE_SHIFT] = 1;
+	}
+	// handlers are called from the write paths and must not throw
+	void register_code_handler(codewrite_fun_t _fn);
 
 	uint8_t *get_buffer_ptr(uint32_t _address);
+	uint8_t *get_ram_ptr(uint32_t _phy, uint32_t _len, bool _write);
+	void ram_written(uint32_t _phy, uint32_t _len);
 	uint32_t get_buffer_size() { return m_ram.buffer_size; }
 
 	inline int dram_cycles() const { return m_ram.cycles; }
@@ -191,6 +262,7 @@ public:
 
 	void save_state(StateBuf &);
 	void restore_state(StateBuf &);
+	std::vector<uint32_t> dirty_pages(uint64_t _since_seq) const;
 
 	uint8_t  dbg_read_byte (uint32_t _addr) const noexcept;
 	uint16_t dbg_read_word (uint32_t _addr) const noexcept;
@@ -204,6 +276,28 @@ public:
 
 private:
 	void remap(uint32_t _start, uint32_t _end);
+	void call_traps(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len) const noexcept;
+	void code_page_written(uint32_t _page) noexcept;
+	void restore_ram(StateBuf &_state, const Snapshot &_snap, std::vector<std::string> &_chain);
+
+	template<unsigned LEN> ALWAYS_INLINE
+	inline void page_written(uint32_t _addr) noexcept
+	{
+		// _addr must be already masked
+		uint64_t seq = ++m_write_seq;
+		uint32_t page = _addr >> MEM_PAGE_SHIFT;
+		m_page_seq[page] = seq;
+		if(UNLIKELY(m_code_pages[page])) {
+			code_page_written(page);
+		}
+		if(LEN > 1) {
+			uint32_t last = ((_addr + LEN - 1) & m_s.mask) >> MEM_PAGE_SHIFT;
+			m_page_seq[last] = seq;
+			if(UNLIKELY(m_code_pages[last])) {
+				code_page_written(last);
+			}
+		}
+	}
 
 	// read functions for CPUBus
 	template<unsigned LEN> inline
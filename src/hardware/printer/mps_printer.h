@@ -32,9 +32,11 @@
 #ifndef _MPS_PRINTER_H_
 #define _MPS_PRINTER_H_
 
-#include "shared_queue.h"
+#include "lockfree_queue.h"
 #include "lodepng/lodepng.h"
 #include <SDL.h>
+#include <queue>
+#include <deque>
 
 // defaults for US letter (11") paper:
 // page height in rows = 60
@@ -280,7 +282,7 @@ class MpsPrinter
 
 		// =======  Thread state
 		bool m_quit = false;
-		shared_queue<std::function<void()>> m_cmd_queue;
+		mpsc_queue<std::function<void()>, 4096> m_cmd_queue; // one command per byte
 		std::mutex m_preview_mtx; // GUI sync for the preview
 		std::atomic<bool> m_preview_upd = false;
 
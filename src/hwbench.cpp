@@ -34,11 +34,15 @@ m_icount(0),
 m_ccount(0),
 m_virt_start(0),
 m_virt_end(0),
+m_frame_icount(0),
+m_frame_ccount(0),
 avg_ips(.0),
 avg_cps(.0),
 virt_frame_time(0),
 vtime_ratio(1.0),
-cavg_vtime_ratio(1.0)
+cavg_vtime_ratio(1.0),
+tot_icount(0),
+tot_ccount(0)
 {
 }
 
@@ -61,6 +65,8 @@ void HWBench::frame_start(uint64_t _virt_ns)
 		m_icount = 0;
 		m_ccount = 0;
 	}
+	m_frame_icount = m_icount;
+	m_frame_ccount = m_ccount;
 	m_virt_start = _virt_ns;
 	
 	Bench::frame_start();
@@ -72,6 +78,9 @@ void HWBench::frame_end(uint64_t _virt_ns)
 	
 	m_virt_end = _virt_ns;
 	
+	tot_icount.fetch_add(m_icount - m_frame_icount, std::memory_order_relaxed);
+	tot_ccount.fetch_add(m_ccount - m_frame_ccount, std::memory_order_relaxed);
+
 	virt_frame_time = m_virt_end - m_virt_start;
 	vtime_ratio = double(virt_frame_time) / double(frame_time);
 	cavg_vtime_ratio = cavg_vtime_ratio + ( vtime_ratio - cavg_vtime_ratio ) / 60.0;
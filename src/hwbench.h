@@ -34,6 +34,8 @@ protected:
 	uint64_t m_ccount;
 	uint64_t m_virt_start;
 	uint64_t m_virt_end;
+	uint64_t m_frame_icount;
+	uint64_t m_frame_ccount;
 	
 public:
 	double avg_ips; // average CPU instructions per second
@@ -41,6 +43,8 @@ public:
 	uint64_t virt_frame_time;
 	std::atomic<double> vtime_ratio;      // virtual/real speed ratio
 	std::atomic<double> cavg_vtime_ratio; // cumulative average of virtual/real time ratio over the last 60 frames
+	std::atomic<uint64_t> tot_icount; // total CPU instructions, never reset
+	std::atomic<uint64_t> tot_ccount; // total CPU cycles, never reset
 	
 	HWBench();
 	virtual ~HWBench();
@@ -53,6 +57,7 @@ public:
 	void frame_end(uint64_t _virt_ns);
 	
 	void cpu_step() { m_icount++; }
+	void cpu_step(unsigned _count) { m_icount += _count; }
 	void cpu_cycles(unsigned _cycles) { m_ccount += _cycles; }
 	
 	bool is_stressed();
@@ -20,7 +20,7 @@
 #ifndef IBMULATOR_H
 #define IBMULATOR_H
 
-#define IBMULATOR_STATE_VERSION 5
+#define IBMULATOR_STATE_VERSION 7
 
 #define DEFAULT_HEARTBEAT    16683333
 #define CHRONO_RDTSC         false
@@ -48,6 +48,9 @@
 
 #define UNUSED(x) ((void)x)
 
+// to keep data written by different threads on separate cache lines
+#define CACHE_LINE_SIZE 64
+
 #ifndef NDEBUG
 	//DEBUG
 	#define CONFIG_PARSE      true   // enable ini file parsing
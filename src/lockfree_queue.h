@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2016-2025  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_LOCKFREE_QUEUE_H
+#define IBMULATOR_LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <type_traits>
+
+/** Bounded lock-free queue, single consumer, single or multiple producers.
+ * Every slot has a sequence number which tells whether it can be written by
+ * the producer of a given turn or read by the consumer (D. Vyukov's bounded
+ * queue). Producers never wait for the consumer, except when the queue is
+ * full, in which case push() yields until there's room: capacities must be
+ * chosen so that this doesn't happen in normal operation and a thread must
+ * never push into a full queue it consumes itself.
+ * The consumer can block waiting for data; the mutex is only taken when it's
+ * actually sleeping.
+ * Methods marked as "consumer" must be called only by the consumer thread, or
+ * by another thread that excludes the consumer by other means.
+ */
+template<typename T, size_t Capacity, bool MultiProducer>
+class lockfree_queue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+	static constexpr size_t MASK = Capacity - 1;
+
+	struct Cell {
+		std::atomic<size_t> seq;
+		T data;
+	};
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue_pos;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_dequeue_pos;
+	alignas(CACHE_LINE_SIZE) std::atomic<bool> m_waiting;
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	Cell *m_cells;
+
+	lockfree_queue& operator=(const lockfree_queue&) = delete;
+	lockfree_queue(const lockfree_queue& other) = delete;
+
+public:
+
+	lockfree_queue()
+	: m_enqueue_pos(0), m_dequeue_pos(0), m_waiting(false)
+	{
+		m_cells = new Cell[Capacity];
+		for(size_t i=0; i<Capacity; i++) {
+			m_cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~lockfree_queue()
+	{
+		delete[] m_cells;
+	}
+
+	// producer, returns false if the queue is full
+	bool try_push(T &&_item)
+	{
+		Cell *cell;
+		size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		while(true) {
+			cell = &m_cells[pos & MASK];
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			intptr_t diff = intptr_t(seq) - intptr_t(pos);
+			if(diff == 0) {
+				if constexpr(MultiProducer) {
+					if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else {
+					m_enqueue_pos.store(pos + 1, std::memory_order_relaxed);
+					break;
+				}
+			} else if(diff < 0) {
+				return false;
+			} else {
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = std::move(_item);
+		cell->seq.store(pos + 1, std::memory_order_release);
+		wake_consumer();
+		return true;
+	}
+
+	bool try_push(const T &_item)
+	{
+		T item(_item);
+		return try_push(std::move(item));
+	}
+
+	// producer, waits if the queue is full
+	void push(T &&_item)
+	{
+		while(!try_push(std::move(_item))) {
+			std::this_thread::yield();
+		}
+	}
+
+	void push(const T &_item)
+	{
+		T item(_item);
+		push(std::move(item));
+	}
+
+	// consumer, returns immediately, with true if successful retrieval
+	bool try_and_pop(T &_popped_item)
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		Cell &cell = m_cells[pos & MASK];
+		if(!is_ready(cell, pos)) {
+			return false;
+		}
+		_popped_item = std::move(cell.data);
+		release(cell, pos);
+		return true;
+	}
+
+	// consumer, removes the front item if any
+	void try_and_pop()
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		Cell &cell = m_cells[pos & MASK];
+		if(is_ready(cell, pos)) {
+			release(cell, pos);
+		}
+	}
+
+	// consumer, copies the front item without removing it
+	bool try_and_copy(T &_item)
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		Cell &cell = m_cells[pos & MASK];
+		if(!is_ready(cell, pos)) {
+			return false;
+		}
+		_item = cell.data;
+		return true;
+	}
+
+	// consumer, waits until an item is available
+	void wait_and_pop(T &_popped_item)
+	{
+		while(!try_and_pop(_popped_item)) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			set_waiting();
+			if(!front_ready()) {
+				m_cond.wait(lock);
+			}
+			m_waiting.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	// consumer, waits until an item is available or the timeout has expired.
+	// if return value is std::cv_status::timeout then no value was popped.
+	std::cv_status wait_for_and_pop(T &_popped_item, unsigned _max_wait_ns)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(_max_wait_ns);
+		while(!try_and_pop(_popped_item)) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			set_waiting();
+			std::cv_status status = std::cv_status::no_timeout;
+			if(!front_ready()) {
+				status = m_cond.wait_until(lock, deadline);
+			}
+			m_waiting.store(false, std::memory_order_relaxed);
+			if(status == std::cv_status::timeout) {
+				lock.unlock();
+				return try_and_pop(_popped_item) ? std::cv_status::no_timeout : std::cv_status::timeout;
+			}
+		}
+		return std::cv_status::no_timeout;
+	}
+
+	// consumer, calls _fn for every item from the front
+	template<typename F>
+	void for_each(F _fn)
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		while(is_ready(m_cells[pos & MASK], pos)) {
+			_fn(m_cells[pos & MASK].data);
+			pos++;
+		}
+	}
+
+	// consumer
+	void clear()
+	{
+		while(front_ready()) {
+			try_and_pop();
+		}
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	// approximate if called while the queue is being used
+	unsigned size() const
+	{
+		size_t deq = m_dequeue_pos.load(std::memory_order_relaxed);
+		size_t enq = m_enqueue_pos.load(std::memory_order_relaxed);
+		return (enq > deq) ? unsigned(enq - deq) : 0;
+	}
+
+private:
+
+	bool is_ready(const Cell &_cell, size_t _pos) const
+	{
+		return (intptr_t(_cell.seq.load(std::memory_order_acquire)) - intptr_t(_pos + 1)) >= 0;
+	}
+
+	bool front_ready() const
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		return is_ready(m_cells[pos & MASK], pos);
+	}
+
+	void release(Cell &_cell, size_t _pos)
+	{
+		if constexpr(!std::is_trivially_copyable<T>::value) {
+			// destroy what the moved-from item could still hold (eg. captures)
+			_cell.data = T();
+		}
+		_cell.seq.store(_pos + Capacity, std::memory_order_release);
+		m_dequeue_pos.store(_pos + 1, std::memory_order_relaxed);
+	}
+
+	void set_waiting()
+	{
+		// pairs with the fence in wake_consumer(): either the consumer sees
+		// the new item or the producer sees the consumer waiting
+		m_waiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	void wake_consumer()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(m_waiting.load(std::memory_order_relaxed)) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_cond.notify_one();
+		}
+	}
+};
+
+template<typename T, size_t Capacity = 1024>
+using mpsc_queue = lockfree_queue<T, Capacity, true>;
+
+template<typename T, size_t Capacity = 1024>
+using spsc_queue = lockfree_queue<T, Capacity, false>;
+
+#endif
@@ -77,7 +77,9 @@ void Machine::save_state(StateBuf &_state)
 	g_memory.save_state(_state);
 	g_devices.save_state(_state);
 
-	PINFOF(LOG_V0, LOG_MACHINE, "Machine state saved\n");
+	if(!_state.in_memory()) {
+		PINFOF(LOG_V0, LOG_MACHINE, "Machine state saved\n");
+	}
 }
 
 void Machine::restore_state(StateBuf &_state)
@@ -151,6 +153,7 @@ void Machine::init()
 
 	m_pacer.start();
 	m_bench.init(m_pacer.chrono(), 1000);
+	m_prof_cpu = g_profiler.zone("CPU", "machine");
 	m_s.curr_prgname[0] = 0;
 
 	m_timers.set_log_facility(LOG_MACHINE);
@@ -259,6 +262,7 @@ void Machine::reset(uint _signal)
 		m_timers.reset();
 		m_s.cycles_left = 0;
 		set_DOS_program_name("");
+		m_rewind.clear();
 	}
 
 	g_memory.reset(_signal);
@@ -286,6 +290,7 @@ void Machine::power_off()
 	m_on = false;
 	g_cpu.power_off();
 	g_devices.power_off();
+	m_rewind.clear();
 
 	set_DOS_program_name("");
 }
@@ -310,6 +315,12 @@ void Machine::config_changed(bool _startup)
 		if(m_hdd_commit == MEDIA_DISCARD) {
 			PWARN("WARNING: data written to the hard disk will be lost!\n");
 		}
+		if(g_program.is_headless()) {
+			// benchmarks must leave the images untouched to be repeatable,
+			// hard disks are mounted with a temporary overlay
+			m_floppy_commit = MEDIA_DISCARD;
+			m_hdd_commit = MEDIA_DISCARD;
+		}
 	} else {
 		m_config_id++;
 	}
@@ -342,6 +353,11 @@ void Machine::config_changed(bool _startup)
 	g_memory.config_changed();
 	g_devices.config_changed();
 
+	m_rewind.set_config(
+		g_program.config().get_int(CAPTURE_SECTION, CAPTURE_REWIND_INTERVAL, 0),
+		g_program.config().get_int(CAPTURE_SECTION, CAPTURE_REWIND_MEMORY, 0)
+	);
+
 	m_configured_model = model();
 	m_configured_model.cpu_model = g_cpu.model();
 	m_configured_model.cpu_freq = unsigned(g_cpu.frequency());
@@ -513,6 +529,10 @@ void Machine::run_loop()
 		// everything important happens here
 		core_step(cycles);
 
+		if(m_rewind.is_due(m_timers.get_time())) {
+			rewind_capture();
+		}
+
 		m_bench.cpu_cycles(cycles);
 
 		uint64_t vend = m_timers.get_time();
@@ -549,6 +569,28 @@ void Machine::core_step(int32_t _cpu_cycles)
 	uint32_t cycle_time = g_cpu.cycle_time_ns();
 	while(cycles_left>0) {
 
+		if(LIKELY(!m_cpu_single_step && !m_breakpoint_cs)) {
+			// run instructions in blocks up to the next timer event
+			unsigned icount = 0;
+			uint64_t cpu_time;
+			int32_t c;
+			{
+				ProfileScope prof(m_prof_cpu);
+				c = g_cpu.run(cycles_left, m_timers, cpu_time, icount);
+			}
+			m_bench.cpu_step(icount);
+			if(cpu_time >= m_timers.get_next_timer_time()) {
+				m_timers.update(cpu_time);
+			}
+			cycles_left -= c;
+			m_timers.set_time(cpu_time);
+			if(m_cpu_single_step && cycles_left>0) {
+				_cpu_cycles -= cycles_left;
+				cycles_left = 0;
+			}
+			continue;
+		}
+
 		int32_t c = g_cpu.step();
 		if(c>0) {
 			//c is 0 only if (REP && CX==0)
@@ -558,7 +600,7 @@ void Machine::core_step(int32_t _cpu_cycles)
 			uint64_t cpu_time = m_timers.get_time() + elapsed_ns;
 
 			if(cpu_time >= m_timers.get_next_timer_time()) {
-				while(!m_timers.update(cpu_time));
+				m_timers.update(cpu_time);
 			}
 
 			cycles_left -= c;
@@ -703,7 +745,7 @@ void Machine::cmd_power_on()
 			return;
 		}
 		if(!m_valid_state) {
-			GUI::instance()->show_message("Invalid state");
+			show_message("Invalid state");
 		} else {
 			reset(MACHINE_POWER_ON);
 		}
@@ -721,7 +763,7 @@ void Machine::cmd_cpu_step()
 {
 	m_cmd_queue.push([this] () {
 		if(!m_valid_state) {
-			GUI::instance()->show_message("Invalid state");
+			show_message("Invalid state");
 		} else {
 			core_step(0);
 		}
@@ -758,7 +800,7 @@ void Machine::cmd_switch_power()
 			power_off();
 		} else {
 			if(!m_valid_state) {
-				GUI::instance()->show_message("Invalid state");
+				show_message("Invalid state");
 			} else {
 				reset(MACHINE_POWER_ON);
 			}
@@ -773,7 +815,7 @@ void Machine::cmd_pause(bool _show_notice)
 			pause();
 			if(_show_notice) {
 				PINFOF(LOG_V0, LOG_MACHINE, "Emulation paused\n");
-				GUI::instance()->show_message("Emulation paused");
+				show_message("Emulation paused");
 			} else {
 				PDEBUGF(LOG_V0, LOG_MACHINE, "Emulation paused\n");
 			}
@@ -785,12 +827,12 @@ void Machine::cmd_resume(bool _show_notice)
 {
 	m_cmd_queue.push([=] () {
 		if(!m_valid_state) {
-			GUI::instance()->show_message("Invalid state");
+			show_message("Invalid state");
 		} else if(m_cpu_single_step) {
 			resume();
 			if(_show_notice) {
 				PINFOF(LOG_V0, LOG_MACHINE, "Emulation resumed\n");
-				GUI::instance()->show_message("Emulation resumed");
+				show_message("Emulation resumed");
 			} else {
 				PDEBUGF(LOG_V0, LOG_MACHINE, "Emulation resumed\n");
 			}
@@ -871,7 +913,7 @@ void Machine::cmd_cycles_adjust(double _factor)
 		ss << (_factor * 100.f) << "%";
 		PINFOF(LOG_V0, LOG_MACHINE, "%s\n", ss.str().c_str());
 		PDEBUGF(LOG_V0, LOG_MACHINE, "%f cycles per beat\n", m_cpu_cycles * m_cycles_factor);
-		GUI::instance()->show_message(ss.str().c_str());
+		show_message(ss.str().c_str());
 	});
 }
 
@@ -880,7 +922,7 @@ void Machine::cmd_save_state(StateBuf &_state, std::mutex &_mutex, std::conditio
 	m_cmd_queue.push([&] () {
 		std::unique_lock<std::mutex> lock(_mutex);
 		if(!m_valid_state) {
-			GUI::instance()->show_message("Invalid state");
+			show_message("Invalid state");
 			_state.m_last_save = false;
 		} else {
 			_state.m_last_save = true;
@@ -905,6 +947,7 @@ void Machine::cmd_restore_state(StateBuf &_state, std::mutex &_mutex, std::condi
 			_state.m_last_restore = true;
 			try {
 				m_on = false;
+				m_rewind.clear();
 				restore_state(_state);
 				m_bench.start();
 				m_on = true;
@@ -917,6 +960,103 @@ void Machine::cmd_restore_state(StateBuf &_state, std::mutex &_mutex, std::condi
 	});
 }
 
+void Machine::rewind_capture()
+{
+	if(!m_valid_state) {
+		return;
+	}
+	StateBuf state("");
+	try {
+		save_state(state);
+	} catch(std::exception &e) {
+		PERRF(LOG_MACHINE, "Error capturing the rewind snapshot, rewind disabled\n");
+		m_rewind.set_config(0, 0);
+		return;
+	}
+	state.seek(0);
+	m_rewind.capture(state.get_buf(), state.get_size(), m_timers.get_time(), m_media_writes);
+}
+
+void Machine::cmd_rewind(unsigned _steps)
+{
+	m_cmd_queue.push([=] () {
+		if(!m_on || !m_valid_state) {
+			return;
+		}
+		if(!m_rewind.is_enabled()) {
+			show_message("Rewind is disabled");
+			return;
+		}
+		if(!m_rewind.available()) {
+			show_message("Nothing to rewind");
+			return;
+		}
+		// the guest's file system caches would not match the disks anymore
+		unsigned steps = m_rewind.available(m_media_writes);
+		if(!steps) {
+			show_message("Cannot rewind past a disk write");
+			return;
+		}
+		if(_steps > steps) {
+			PWARNF(LOG_V0, LOG_MACHINE, "Rewind limited to %u steps by a disk write\n", steps);
+		}
+		uint64_t vtime = m_timers.get_time();
+
+		// the current state is kept in case the snapshot can't be restored
+		StateBuf current("");
+		try {
+			save_state(current);
+		} catch(std::exception &e) {
+			PERRF(LOG_MACHINE, "Error saving the current state, cannot rewind\n");
+			show_message("Rewind failed");
+			return;
+		}
+		current.seek(0);
+
+		StateBuf state("");
+		const std::vector<uint8_t> &snapshot = m_rewind.step_back(std::clamp(_steps, 1u, steps));
+		state.load(snapshot.data(), snapshot.size());
+
+		// same as a hard reset, the audio cards' virtual time restarts
+		std::mutex mtx;
+		std::unique_lock<std::mutex> lock(mtx);
+		std::condition_variable cv;
+		g_mixer.cmd_stop_audiocards_and_signal(mtx, cv);
+		cv.wait(lock);
+
+		try {
+			m_on = false;
+			restore_state(state);
+			m_bench.start();
+			m_on = true;
+		} catch(std::exception &e) {
+			PERRF(LOG_MACHINE, "Error restoring the rewind snapshot\n");
+			m_rewind.clear();
+			g_mixer.cmd_start_audiocards();
+			try {
+				restore_state(current);
+				m_valid_state = true;
+				m_bench.start();
+				m_on = true;
+				show_message("Rewind failed");
+			} catch(std::exception &) {
+				PERRF(LOG_MACHINE, "Error restoring the current state\n");
+				m_on = true;
+				power_off();
+				show_message("Rewind failed, the machine has been powered off");
+			}
+			return;
+		}
+		m_rewind.restored(m_timers.get_time());
+
+		g_mixer.cmd_start_audiocards();
+
+		std::string mex = str_format("Rewound %.1f seconds", NSEC_TO_SEC(vtime - m_timers.get_time()));
+		PINFOF(LOG_V0, LOG_MACHINE, "%s\n", mex.c_str());
+		show_message(mex.c_str());
+	});
+}
+
 void Machine::cmd_insert_floppy(uint8_t _drive, std::string _img_path, bool _wp,
 		std::function<void(bool)> _cb)
 {
@@ -955,6 +1095,8 @@ void Machine::cmd_insert_floppy(uint8_t _drive, FloppyDisk *_floppy,
 		bool result = g_devices.device<FloppyCtrl>()->insert_floppy(_drive, _floppy);
 		if(!result) {
 			delete _floppy;
+		} else {
+			media_written();
 		}
 		if(_cb) {
 			_cb(result);
@@ -975,6 +1117,7 @@ void Machine::cmd_eject_floppy(uint8_t _drive, std::function<void(bool)> _cb)
 			if(_cb) { _cb(true); }
 			return;
 		}
+		media_written();
 		if(floppy->is_dirty()) {
 			if(m_floppy_commit == MEDIA_DISCARD || 
 			   (m_config_id > 0 && m_floppy_commit == MEDIA_DISCARD_STATES))
@@ -1050,6 +1193,14 @@ void Machine::cmd_dispose_cdrom(CdRomDisc *_disc)
 	m_cdrom_loader->cmd_dispose_cdrom(_disc);
 }
 
+void Machine::show_message(const std::string &_mex)
+{
+	// there's no GUI in headless mode
+	if(GUI::instance()) {
+		GUI::instance()->show_message(_mex);
+	}
+}
+
 void Machine::commit_floppy(FloppyDisk *_floppy, uint8_t _drive, std::function<void(bool)> _cb)
 {
 	// if called from cmd_eject_floppy() this could be the Main thread,
@@ -1149,7 +1300,7 @@ void Machine::cmd_commit_media(std::function<void()> _cb)
 		}
 
 		if(last_dirty >= 0) {
-			GUI::instance()->show_message("Saving floppy disks...");
+			show_message("Saving floppy disks...");
 
 			for(int i=0; i<int(FloppyCtrl::MAX_DRIVES); i++) {
 				if(fdc->is_disk_dirty(i,true)) {
@@ -23,10 +23,11 @@
 #include <functional>
 #include <mutex>
 #include "timers.h"
-#include "shared_queue.h"
+#include "lockfree_queue.h"
 #include "pacer.h"
 #include "hwbench.h"
 #include "statebuf.h"
+#include "rewind.h"
 #include "hardware/cpu.h"
 #include "hardware/systemrom.h"
 #include "hardware/devices.h"
@@ -72,6 +73,7 @@ private:
 
 	Pacer m_pacer;
 	HWBench m_bench;
+	Profiler::ZoneID m_prof_cpu = PROFILER_NULL_ZONE;
 
 	int64_t m_heartbeat = 0;
 	bool m_quit = false;
@@ -110,7 +112,7 @@ private:
 	void power_off();
 	bool update_timers(uint64_t _vtime);
 
-	shared_queue<Machine_fun_t> m_cmd_queue;
+	mpsc_queue<Machine_fun_t> m_cmd_queue;
 
 	mouse_mfun_t m_mouse_mfun = nullptr;
 	mouse_bfun_t m_mouse_bfun = nullptr;
@@ -120,7 +122,15 @@ private:
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
 
+	Rewind m_rewind;
+	// number of writes to floppy and hard disks and floppy changes, rewind
+	// snapshots taken before the last one cannot be restored as media are not
+	// part of them
+	uint64_t m_media_writes = 0;
+	void rewind_capture();
+
 	void set_DOS_program_name(const char *_name);
+	void show_message(const std::string &_mex);
 
 	// the floppy loader thread is in the machine object instead of gui, devices,
 	// controller, or drive objects to be in a middle point between all the
@@ -167,6 +177,8 @@ public:
 	inline uint64_t get_virt_time_ns_mt() const { return m_timers.get_time_mt(); }
 	inline uint64_t get_virt_time_us_mt() const { return NSEC_TO_USEC(m_timers.get_time_mt()); }
 	inline HWBench & get_bench() { return m_bench; }
+	// to be called before the Machine thread is started
+	void set_unpaced(bool _unpaced) { m_pacer.set_external_sync(_unpaced); }
 
 	inline unsigned type() const { return model().type; }
 	inline std::string type_str() const { return g_machine_type_str.at(type()); }
@@ -207,6 +219,7 @@ public:
 	inline double vtime_ratio() const { return m_vtime_ratio; }
 
 	MediaCommit hdd_commit_strategy() const { return m_hdd_commit; }
+	void media_written() { m_media_writes++; }
 
 	std::shared_ptr<MpsPrinter> get_printer() {
 		return m_printer;
@@ -230,6 +243,7 @@ public:
 	void cmd_cycles_adjust(double _factor);
 	void cmd_save_state(StateBuf &_state, std::mutex &_mutex, std::condition_variable &_cv);
 	void cmd_restore_state(StateBuf &_state, std::mutex &_mutex, std::condition_variable &_cv);
+	void cmd_rewind(unsigned _steps);
 	void cmd_insert_floppy(uint8_t _drive, std::string _file, bool _wp, std::function<void(bool)> _cb);
 	void cmd_insert_floppy(uint8_t _drive, FloppyDisk *_floppy, std::function<void(bool)> _cb, int _config_id);
 	void cmd_eject_floppy(uint8_t _drive, std::function<void(bool)> _cb);
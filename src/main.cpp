@@ -95,7 +95,7 @@ int main(int argc, char** argv)
 	g_syslog.remove(templog, false);
 
 	if(start) {
-		g_program.start();
+		return_value = g_program.start();
 	}
 
 	PINFO(LOG_V0, "Program stop\n");
@@ -88,38 +88,51 @@ void Mixer::init(Machine *_machine)
 	m_machine = _machine;
 	m_pacer.start();
 	m_bench.init(m_pacer.chrono(), 1000);
+	m_prof_mix = g_profiler.zone("Mix", "mixer");
 
 	m_paused = true;
 
-	if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
-		PERRF(LOG_MIXER, "Unable to init SDL audio: %s\n", SDL_GetError());
-		throw std::exception();
+	bool headless = g_program.is_headless();
+	if(!headless) {
+		if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+			PERRF(LOG_MIXER, "Unable to init SDL audio: %s\n", SDL_GetError());
+			throw std::exception();
+		}
+
+		int i, count = SDL_GetNumAudioDevices(0);
+		if(count == 0) {
+			PERRF(LOG_MIXER, "Unable to find any audio device\n");
+			return;
+		}
+		for(i=0; i<count; ++i) {
+			PINFOF(LOG_V1, LOG_MIXER, "Audio device %d: %s\n", i, SDL_GetAudioDeviceName(i, 0));
+			PINFOF(LOG_V1, LOG_MIXER, "  Driver: %s\n", SDL_GetAudioDriver(i));
+		}
 	}
 
 	m_paused = false;
 
-	int i, count = SDL_GetNumAudioDevices(0);
-	if(count == 0) {
-		PERRF(LOG_MIXER, "Unable to find any audio device\n");
-		return;
-	}
-	for(i=0; i<count; ++i) {
-		PINFOF(LOG_V1, LOG_MIXER, "Audio device %d: %s\n", i, SDL_GetAudioDeviceName(i, 0));
-		PINFOF(LOG_V1, LOG_MIXER, "  Driver: %s\n", SDL_GetAudioDriver(i));
-	}
-
 	int frequency = g_program.config().get_int_or_default(MIXER_SECTION, MIXER_RATE, 11025, 49716);
 	int samples = g_program.config().get_int_or_default(MIXER_SECTION, MIXER_SAMPLES, 256, 4096);
 
-	try {
-		assert(MIXER_CHANNELS == 2);
-		open_audio_device(frequency, MIXER_FORMAT, MIXER_CHANNELS, samples);
-	} catch(std::exception &e) {
-		PERRF(LOG_MIXER, "Audio output disabled\n");
+	auto set_default_spec = [this]() {
 		m_audio_spec.freq = MIXER_FREQUENCY;
 		m_audio_spec.format = MIXER_FORMAT;
 		m_audio_spec.channels = MIXER_CHANNELS;
 		m_audio_spec.silence = 0;
+	};
+	if(headless) {
+		// channels are still mixed, but nothing is sent to an audio device
+		PINFOF(LOG_V0, LOG_MIXER, "Headless mode, audio output disabled\n");
+		set_default_spec();
+	} else {
+		try {
+			assert(MIXER_CHANNELS == 2);
+			open_audio_device(frequency, MIXER_FORMAT, MIXER_CHANNELS, samples);
+		} catch(std::exception &e) {
+			PERRF(LOG_MIXER, "Audio output disabled\n");
+			set_default_spec();
+		}
 	}
 
 	m_volume.meter.set_rate(m_audio_spec.freq);
@@ -397,7 +410,10 @@ void Mixer::main_loop()
 
 		if(!active_channels.empty()) {
 
-			mix_channels(time_span_ns, active_channels, vtime_ratio);
+			{
+				ProfileScope prof(m_prof_mix);
+				mix_channels(time_span_ns, active_channels, vtime_ratio);
+			}
 
 			limit_audio_data(active_channels, vtime_ratio);
 
@@ -20,7 +20,7 @@
 #ifndef IBMULATOR_MIXER_H
 #define IBMULATOR_MIXER_H
 
-#include "shared_queue.h"
+#include "lockfree_queue.h"
 #include "pacer.h"
 #include "hwbench.h"
 #include "ring_buffer.h"
@@ -49,7 +49,7 @@ typedef std::function<void(const std::vector<int16_t> &_data, int _category)> Au
 class Mixer
 {
 private:
-	RingBuffer m_out_buffer; // the SDL multithread-safe output buffer
+	SPSCRingBuffer m_out_buffer; // Mixer -> SDL audio callback, never locks
 	std::vector<float> m_out_mix;
 	std::vector<float> m_ch_mix[MixerChannel::CategoryCount];
 	size_t m_mix_bufsize_fr;
@@ -71,6 +71,7 @@ private:
 	Machine *m_machine;
 	Pacer m_pacer;
 	HWBench m_bench;
+	Profiler::ZoneID m_prof_mix = PROFILER_NULL_ZONE;
 	uint64_t m_heartbeat_us;
 	uint64_t m_elapsed_time_us;
 
@@ -81,7 +82,7 @@ private:
 	SDL_AudioSpec m_audio_spec;
 	int m_frame_size;
 
-	shared_queue<Mixer_fun_t> m_cmd_queue;
+	mpsc_queue<Mixer_fun_t> m_cmd_queue;
 
 	std::map<std::string, std::shared_ptr<MixerChannel>> m_mix_channels;
 
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2016-2025  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "profiler.h"
+#include "filesys.h"
+#include "utils.h"
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+Profiler g_profiler;
+
+
+Profiler::Profiler()
+{
+	m_t0 = std::chrono::steady_clock::now();
+}
+
+Profiler::ZoneID Profiler::zone(const std::string &_name, const char *_category)
+{
+	std::lock_guard<std::mutex> lock(m_zones_mtx);
+
+	unsigned count = m_zones_count.load(std::memory_order_relaxed);
+	for(unsigned z = 0; z < count; z++) {
+		if(m_zones[z].name == _name && m_zones[z].category == _category) {
+			return z;
+		}
+	}
+	if(count >= PROFILER_MAX_ZONES) {
+		PDEBUGF(LOG_V0, LOG_PROGRAM, "Profiler: too many zones, '%s' won't be profiled\n", _name.c_str());
+		return PROFILER_NULL_ZONE;
+	}
+	m_zones[count].name = _name;
+	m_zones[count].category = _category;
+	m_zones_count.store(count + 1, std::memory_order_release);
+
+	return count;
+}
+
+void Profiler::enable(bool _enabled)
+{
+	if(_enabled && !m_enabled) {
+		reset();
+	}
+	m_enabled = _enabled;
+	PINFOF(LOG_V1, LOG_PROGRAM, "Profiler %s\n", _enabled ? "enabled" : "disabled");
+}
+
+void Profiler::reset()
+{
+	unsigned count = m_zones_count.load(std::memory_order_acquire);
+	for(unsigned z = 0; z < count; z++) {
+		m_zones[z].total_ns = 0;
+		m_zones[z].calls = 0;
+		m_zones[z].max_ns = 0;
+		m_zones[z].last_total_ns = 0;
+		m_zones[z].last_calls = 0;
+	}
+	m_reset_time = now();
+	m_stats_time = m_reset_time;
+	m_stats.clear();
+}
+
+void Profiler::add(ZoneID _zone, uint64_t _start_ns)
+{
+	uint64_t end = now();
+	uint64_t dur = end - _start_ns;
+	Zone &zone = m_zones[_zone];
+
+	zone.total_ns.fetch_add(dur, std::memory_order_relaxed);
+	zone.calls.fetch_add(1, std::memory_order_relaxed);
+	// zones are (mostly) used by a single thread, an exact max is not needed
+	if(dur > zone.max_ns.load(std::memory_order_relaxed)) {
+		zone.max_ns.store(dur, std::memory_order_relaxed);
+	}
+
+	if(m_tracing.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(m_trace_mtx);
+		if(m_trace.size() < PROFILER_MAX_TRACE_EVENTS) {
+			m_trace.push_back({_zone, thread_id(), _start_ns, dur});
+		}
+	}
+}
+
+unsigned Profiler::thread_id()
+{
+	// m_trace_mtx must be locked
+	static thread_local std::thread::id this_thread = std::this_thread::get_id();
+	static std::vector<std::thread::id> threads;
+	auto it = std::find(threads.begin(), threads.end(), this_thread);
+	if(it != threads.end()) {
+		return it - threads.begin();
+	}
+	threads.push_back(this_thread);
+	return threads.size() - 1;
+}
+
+void Profiler::start_trace()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_trace_mtx);
+		m_trace.clear();
+		m_trace.reserve(PROFILER_MAX_TRACE_EVENTS / 8);
+	}
+	if(!m_enabled) {
+		enable(true);
+	}
+	m_tracing = true;
+	PINFOF(LOG_V0, LOG_PROGRAM, "Profiler: trace recording started\n");
+}
+
+void Profiler::stop_trace(const std::string &_filename)
+{
+	m_tracing = false;
+
+	std::lock_guard<std::mutex> lock(m_trace_mtx);
+	try {
+		save_trace(_filename);
+	} catch(std::exception &) {
+		m_trace.clear();
+		throw;
+	}
+	m_trace.clear();
+	m_trace.shrink_to_fit();
+}
+
+void Profiler::save_trace(const std::string &_filename)
+{
+	// m_trace_mtx must be locked
+	auto file = FileSys::make_ofstream(_filename.c_str());
+	if(!file.is_open()) {
+		throw std::runtime_error(str_format("cannot open '%s' for writing", _filename.c_str()));
+	}
+
+	if(m_trace.size() >= PROFILER_MAX_TRACE_EVENTS) {
+		PWARNF(LOG_V0, LOG_PROGRAM, "Profiler: the trace is truncated to %u events\n", PROFILER_MAX_TRACE_EVENTS);
+	}
+
+	// Chrome trace event format, complete events with microsecond timestamps.
+	// Threads are named after the category of their first event.
+	std::vector<const char*> thread_names;
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for(auto &evt : m_trace) {
+		const Zone &zone = m_zones[evt.zone];
+		if(evt.tid >= thread_names.size()) {
+			thread_names.resize(evt.tid + 1, nullptr);
+		}
+		if(!thread_names[evt.tid]) {
+			thread_names[evt.tid] = zone.category.c_str();
+		}
+		file << (first ? "" : ",\n") << str_format(
+			"{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+			str_to_json(zone.name).c_str(), str_to_json(zone.category).c_str(),
+			evt.start_ns / 1000.0, evt.dur_ns / 1000.0, evt.tid);
+		first = false;
+	}
+	for(unsigned tid = 0; tid < thread_names.size(); tid++) {
+		if(thread_names[tid]) {
+			file << (first ? "" : ",\n") << str_format(
+				"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+				tid, str_to_json(thread_names[tid]).c_str());
+			first = false;
+		}
+	}
+	file << "\n]}\n";
+
+	if(file.fail()) {
+		throw std::runtime_error(str_format("cannot write to '%s'", _filename.c_str()));
+	}
+
+	PINFOF(LOG_V0, LOG_PROGRAM, "Profiler: %zu trace events written to %s\n", m_trace.size(), _filename.c_str());
+}
+
+const std::vector<Profiler::ZoneStats> & Profiler::get_stats()
+{
+	uint64_t time = now();
+	uint64_t elapsed = time - m_stats_time;
+	if(!elapsed || (elapsed < 1'000'000'000 && !m_stats.empty())) {
+		return m_stats;
+	}
+	m_stats_time = time;
+	m_stats.clear();
+
+	unsigned count = m_zones_count.load(std::memory_order_acquire);
+	for(unsigned z = 0; z < count; z++) {
+		Zone &zone = m_zones[z];
+		uint64_t total = zone.total_ns.load(std::memory_order_relaxed);
+		uint64_t calls = zone.calls.load(std::memory_order_relaxed);
+		uint64_t d_total = total - zone.last_total_ns;
+		uint64_t d_calls = calls - zone.last_calls;
+		zone.last_total_ns = total;
+		zone.last_calls = calls;
+		if(!d_calls) {
+			continue;
+		}
+		m_stats.push_back({
+			zone.name,
+			zone.category,
+			double(d_calls) * 1e9 / elapsed,
+			double(d_total) / d_calls / 1e3,
+			double(zone.max_ns.exchange(0, std::memory_order_relaxed)) / 1e3,
+			double(d_total) / elapsed
+		});
+	}
+	std::sort(m_stats.begin(), m_stats.end(), [](const ZoneStats &_a, const ZoneStats &_b) {
+		return _a.load > _b.load;
+	});
+
+	return m_stats;
+}
+
+std::vector<Profiler::ZoneStats> Profiler::get_totals() const
+{
+	std::vector<ZoneStats> totals;
+	uint64_t elapsed = now() - m_reset_time;
+	if(!elapsed) {
+		return totals;
+	}
+	unsigned count = m_zones_count.load(std::memory_order_acquire);
+	for(unsigned z = 0; z < count; z++) {
+		const Zone &zone = m_zones[z];
+		uint64_t total = zone.total_ns.load(std::memory_order_relaxed);
+		uint64_t calls = zone.calls.load(std::memory_order_relaxed);
+		if(!calls) {
+			continue;
+		}
+		totals.push_back({
+			zone.name,
+			zone.category,
+			double(calls) * 1e9 / elapsed,
+			double(total) / calls / 1e3,
+			// the max is reset by get_stats()
+			double(zone.max_ns.load(std::memory_order_relaxed)) / 1e3,
+			double(total) / elapsed
+		});
+	}
+	std::sort(totals.begin(), totals.end(), [](const ZoneStats &_a, const ZoneStats &_b) {
+		return _a.load > _b.load;
+	});
+
+	return totals;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2016-2025  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_PROFILER_H
+#define IBMULATOR_PROFILER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+
+class Profiler;
+extern Profiler g_profiler;
+
+#define PROFILER_MAX_ZONES 256
+#define PROFILER_MAX_TRACE_EVENTS 2'000'000
+#define PROFILER_NULL_ZONE PROFILER_MAX_ZONES
+
+/* Host time profiler.
+ * Code is instrumented with ProfileScope objects on named zones. When the
+ * profiler is disabled a scope costs a single flag test.
+ * Zones are never removed and the same name and category always map to the
+ * same zone, so ids can be cached by devices, timers and channels that come
+ * and go.
+ * Every zone accumulates its time and number of calls. While a trace is being
+ * recorded every scope is also stored as a complete event that can be
+ * exported as a Chrome trace (chrome://tracing, Perfetto).
+ */
+class Profiler
+{
+public:
+	typedef unsigned ZoneID;
+
+	struct ZoneStats {
+		std::string name;
+		std::string category;
+		double calls;  // per second
+		double avg_us; // per call
+		double max_us;
+		double load;   // fraction of host time
+	};
+
+private:
+	struct Zone {
+		std::string name;
+		std::string category;
+		std::atomic<uint64_t> total_ns = 0;
+		std::atomic<uint64_t> calls = 0;
+		std::atomic<uint64_t> max_ns = 0;
+		// GUI thread
+		uint64_t last_total_ns = 0;
+		uint64_t last_calls = 0;
+	};
+	struct TraceEvent {
+		ZoneID zone;
+		unsigned tid;
+		uint64_t start_ns;
+		uint64_t dur_ns;
+	};
+
+	std::atomic<bool> m_enabled = false;
+	std::atomic<bool> m_tracing = false;
+	std::chrono::steady_clock::time_point m_t0;
+
+	std::mutex m_zones_mtx; // zones registration
+	Zone m_zones[PROFILER_MAX_ZONES];
+	std::atomic<unsigned> m_zones_count = 0;
+
+	std::mutex m_trace_mtx;
+	std::vector<TraceEvent> m_trace;
+	std::vector<std::string> m_threads;
+
+	// stats, GUI thread
+	uint64_t m_reset_time = 0;
+	uint64_t m_stats_time = 0;
+	std::vector<ZoneStats> m_stats;
+
+public:
+	Profiler();
+
+	ZoneID zone(const std::string &_name, const char *_category);
+
+	void enable(bool _enabled);
+	bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+	void reset();
+
+	void start_trace();
+	void stop_trace(const std::string &_filename);
+	bool is_tracing() const { return m_tracing.load(std::memory_order_relaxed); }
+
+	// the statistics are updated once per second
+	const std::vector<ZoneStats> & get_stats();
+	// the statistics accumulated since the last reset
+	std::vector<ZoneStats> get_totals() const;
+
+	uint64_t now() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - m_t0).count();
+	}
+	void add(ZoneID _zone, uint64_t _start_ns);
+
+private:
+	unsigned thread_id();
+	void save_trace(const std::string &_filename);
+};
+
+class ProfileScope
+{
+	Profiler::ZoneID m_zone;
+	uint64_t m_start = 0;
+
+public:
+	explicit ProfileScope(Profiler::ZoneID _zone) : m_zone(_zone) {
+		if(UNLIKELY(g_profiler.is_enabled()) && _zone < PROFILER_NULL_ZONE) {
+			m_start = g_profiler.now() | 1; // 0 is "not started"
+		}
+	}
+	~ProfileScope() {
+		if(UNLIKELY(m_start)) {
+			g_profiler.add(m_zone, m_start);
+		}
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif
@@ -40,6 +40,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <optional>
+#include <future>
 #ifdef _WIN32
 #include "wincompat.h"
 #endif
@@ -56,7 +57,8 @@ m_machine(nullptr),
 m_mixer(nullptr),
 m_gui(nullptr),
 m_start_machine(false),
-m_restore_fn(nullptr)
+m_restore_fn(nullptr),
+m_benchmark_secs(0)
 {
 
 }
@@ -97,9 +99,9 @@ void Program::save_state(
 		}
 	}
 
-	std::optional<StateRecord> sstate;
+	std::shared_ptr<StateRecord> sstate;
 	try {
-		sstate.emplace(capture_path, _info.name, false);
+		sstate = std::make_shared<StateRecord>(capture_path, _info.name, false);
 	} catch(std::runtime_error &e) {
 		PERRF(LOG_PROGRAM, "%s\n", e.what());
 		if(_on_fail) {
@@ -113,6 +115,10 @@ void Program::save_state(
 	sstate->info().user_desc = _info.user_desc;
 	sstate->config().copy(m_config[1]);
 
+	// the memory of the previous savestate can be the base of this one (see
+	// Memory::save_state()), it must be on disk before the machine looks for it
+	wait_state_writer();
+
 	bool paused = m_machine->is_paused();
 	{
 		std::unique_lock<std::mutex> lock(ms_lock);
@@ -199,24 +205,31 @@ void Program::save_state(
 		}
 	}
 
-	try {
-		sstate->save();
-	} catch(std::runtime_error &e) {
-		PERRF(LOG_PROGRAM, "%s\n", e.what());
-		if(_on_fail) {
-			_on_fail(e.what());
-		}
-		return;
-	}
-
 	if(!paused) {
 		m_machine->cmd_resume(false);
 	}
 
-	PINFOF(LOG_V0, LOG_PROGRAM, "State saved\n");
-	if(_on_success != nullptr) {
-		_on_success(_info);
-	}
+	// the state has been copied, the machine doesn't need to wait for the disk
+	m_state_writer_queue.push([=]() {
+		try {
+			sstate->save();
+		} catch(std::runtime_error &e) {
+			PERRF(LOG_PROGRAM, "%s\n", e.what());
+			if(_on_fail) {
+				std::string error(e.what());
+				m_main_queue.push([=]() {
+					_on_fail(error);
+				});
+			}
+			return;
+		}
+		PINFOF(LOG_V0, LOG_PROGRAM, "State saved\n");
+		if(_on_success != nullptr) {
+			m_main_queue.push([=]() {
+				_on_success(_info);
+			});
+		}
+	});
 }
 
 void Program::restore_state(
@@ -232,6 +245,9 @@ void Program::restore_state(
 	 * otherwise a deadlock on the RmlUi mutex caused by the SysLog will occur.
 	 */
 	m_restore_fn = [=](){
+		// the state could still be in the writer's queue
+		wait_state_writer();
+
 		std::string capture_path = m_config[0].get_file(CAPTURE_SECTION, CAPTURE_DIR, FILE_TYPE_USER);
 		if(capture_path.empty()) {
 			PERRF(LOG_PROGRAM, "The capture directory is not set\n");
@@ -286,7 +302,9 @@ void Program::restore_state(
 		m_mixer->cmd_pause_and_signal(ms_lock, ms_cv);
 		ms_cv.wait(restore_lock);
 
-		m_gui->config_changing();
+		if(m_gui) {
+			m_gui->config_changing();
+		}
 
 		m_machine->sig_config_changed(ms_lock, ms_cv);
 		ms_cv.wait(restore_lock);
@@ -301,12 +319,14 @@ void Program::restore_state(
 			m_mixer->cmd_restore_state(sstate->state(), ms_lock, ms_cv);
 			ms_cv.wait(restore_lock);
 
-			// we need to pause the syslog because it'll use the GUI otherwise
-			g_syslog.cmd_pause_and_signal(ms_lock, ms_cv);
-			ms_cv.wait(restore_lock);
-			m_gui->config_changed(false);
-			m_gui->sig_state_restored();
-			g_syslog.cmd_resume();
+			if(m_gui) {
+				// we need to pause the syslog because it'll use the GUI otherwise
+				g_syslog.cmd_pause_and_signal(ms_lock, ms_cv);
+				ms_cv.wait(restore_lock);
+				m_gui->config_changed(false);
+				m_gui->sig_state_restored();
+				g_syslog.cmd_resume();
+			}
 
 			// mixer resume cmd is issued by the machine
 			m_machine->cmd_resume(false);
@@ -316,10 +336,12 @@ void Program::restore_state(
 				_on_success();
 			}
 		} else {
-			g_syslog.cmd_pause_and_signal(ms_lock, ms_cv);
-			ms_cv.wait(restore_lock);
-			m_gui->config_changed(false);
-			g_syslog.cmd_resume();
+			if(m_gui) {
+				g_syslog.cmd_pause_and_signal(ms_lock, ms_cv);
+				ms_cv.wait(restore_lock);
+				m_gui->config_changed(false);
+				g_syslog.cmd_resume();
+			}
 
 			PERRF(LOG_PROGRAM, "The restored state is not valid, please restart " PACKAGE_NAME "\n");
 			if(_on_fail != nullptr) {
@@ -339,6 +361,7 @@ void Program::delete_state(StateRecord::Info _info)
 		assert(false);
 		return;
 	}
+	wait_state_writer();
 	// check the path before constructing the state record, otherwise it'll
 	// create a new directory if it doesn't exist
 	std::string statepath = capture_path + FS_SEP + _info.name;
@@ -570,6 +593,14 @@ bool Program::initialize(int argc, char** argv)
 		throw;
 	}
 
+	if(is_headless()) {
+		// no window, no audio device, no pacing; the GUI is never created
+		m_machine->set_unpaced(true);
+		m_mixer->config_changed(true);
+		g_profiler.enable(true);
+		return true;
+	}
+
 	static std::map<std::string, unsigned> renderers = {
 		{ "", GUI_RENDERER_OPENGL },
 		{ "opengl", GUI_RENDERER_OPENGL },
@@ -702,7 +733,7 @@ void Program::parse_arguments(int argc, char** argv)
 
 	opterr = 0;
 
-	while((c = getopt(argc, argv, "v:c:u:r:s")) != -1) {
+	while((c = getopt(argc, argv, "v:c:u:r:sb:")) != -1) {
 		switch(c) {
 			case 'c': {
 				m_cfg_file = "";
@@ -754,7 +785,12 @@ void Program::parse_arguments(int argc, char** argv)
 					}
 				}
 				if(!state.empty()) {
-					restore_state({state, "","",0,0}, nullptr, nullptr);
+					restore_state({state, "","",0,0}, nullptr, [this](std::string _error){
+						if(is_headless()) {
+							// don't benchmark something else
+							throw std::runtime_error("Cannot restore the savestate: " + _error);
+						}
+					});
 				}
 				break;
 			}
@@ -762,8 +798,18 @@ void Program::parse_arguments(int argc, char** argv)
 				m_start_machine = true;
 				break;
 			}
+			case 'b': {
+				int secs = atoi(optarg);
+				if(secs <= 0) {
+					PERRF(LOG_PROGRAM, "Invalid benchmark duration: '%s'\n", optarg);
+					throw std::exception();
+				}
+				m_benchmark_secs = secs;
+				PINFOF(LOG_V0, LOG_PROGRAM, "Benchmark mode, running for %d virtual seconds\n", secs);
+				break;
+			}
 			case '?':
-				if(optopt == 'c')
+				if(optopt == 'c' || optopt == 'b')
 					PERRF(LOG_PROGRAM, "Option -%c requires an argument\n", optopt);
 				else if(isprint(optopt))
 					PERRF(LOG_PROGRAM, "Unknown option `-%c'\n", optopt);
@@ -801,20 +847,34 @@ void Program::main_loop()
 {
 	m_bench.start();
 
+	Profiler::ZoneID prof_gui_update = g_profiler.zone("GUI update", "gui");
+	Profiler::ZoneID prof_gui_render = g_profiler.zone("GUI render", "gui");
+
 	while(!m_quit) {
 		m_bench.frame_start();
 
 		process_evts();
-		m_gui->update(m_pacer.chrono().get_nsec());
+		{
+			ProfileScope prof(prof_gui_update);
+			m_gui->update(m_pacer.chrono().get_nsec());
+		}
 		// in the following function, this thread will wait for the Machine 
 		// which will notify on VGA's vertical retrace.
 		// see InterfaceScreen::sync_with_device()
-		m_gui->render();
+		{
+			ProfileScope prof(prof_gui_render);
+			m_gui->render();
+		}
 
 		if(m_restore_fn != nullptr) {
 			m_restore_fn();
 			m_restore_fn = nullptr;
 		}
+
+		std::function<void()> fn;
+		while(m_main_queue.try_and_pop(fn)) {
+			fn();
+		}
 		
 		m_bench.load_end();
 		
@@ -824,21 +884,109 @@ void Program::main_loop()
 	}
 }
 
-void Program::start()
+void Program::benchmark_loop()
+{
+	if(m_restore_fn != nullptr) {
+		m_restore_fn();
+		m_restore_fn = nullptr;
+	}
+	if(!m_machine->is_on()) {
+		m_machine->cmd_power_on();
+		while(!m_machine->is_on()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	HWBench &hwbench = m_machine->get_bench();
+	uint64_t icount = hwbench.tot_icount;
+	uint64_t ccount = hwbench.tot_ccount;
+	uint64_t vtime_start = m_machine->get_virt_time_ns_mt();
+	uint64_t vtime_end = vtime_start + uint64_t(m_benchmark_secs) * 1'000'000'000;
+	g_profiler.reset();
+	int64_t time_start = m_pacer.chrono().get_nsec();
+
+	PINFOF(LOG_V0, LOG_PROGRAM, "Benchmark started\n");
+
+	uint64_t vtime = vtime_start;
+	while(vtime < vtime_end) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if(!m_machine->is_on()) {
+			throw std::runtime_error("the machine has been powered off");
+		}
+		std::function<void()> fn;
+		while(m_main_queue.try_and_pop(fn)) {
+			fn();
+		}
+		vtime = m_machine->get_virt_time_ns_mt();
+	}
+
+	m_machine->cmd_pause(false);
+
+	double host_s = double(m_pacer.chrono().get_nsec() - time_start) / 1e9;
+	double virt_s = double(vtime - vtime_start) / 1e9;
+	icount = hwbench.tot_icount - icount;
+	ccount = hwbench.tot_ccount - ccount;
+
+	PINFOF(LOG_V0, LOG_PROGRAM, "Benchmark ended: %.3f virtual seconds in %.3f seconds\n", virt_s, host_s);
+
+	std::string json = "{\n";
+	json += str_format("  \"virtual_time_s\": %.6f,\n", virt_s);
+	json += str_format("  \"host_time_s\": %.6f,\n", host_s);
+	json += str_format("  \"vtime_ratio\": %.6f,\n", virt_s / host_s);
+	json += str_format("  \"instructions\": %llu,\n", icount);
+	json += str_format("  \"cycles\": %llu,\n", ccount);
+	json += str_format("  \"ips\": %.0f,\n", double(icount) / host_s);
+	json += str_format("  \"cps\": %.0f,\n", double(ccount) / host_s);
+	json += "  \"zones\": [";
+	bool first = true;
+	for(auto &zone : g_profiler.get_totals()) {
+		json += first ? "\n" : ",\n";
+		json += str_format("    {\"name\": \"%s\", \"category\": \"%s\", "
+				"\"calls_per_s\": %.1f, \"avg_us\": %.3f, \"max_us\": %.3f, \"load\": %.6f}",
+				str_to_json(zone.name).c_str(), str_to_json(zone.category).c_str(),
+				zone.calls, zone.avg_us, zone.max_us, zone.load);
+		first = false;
+	}
+	json += first ? "]\n}\n" : "\n  ]\n}\n";
+
+	// the log goes to stderr, stdout is reserved for the results
+	fputs(json.c_str(), stdout);
+	fflush(stdout);
+}
+
+int Program::start()
 {
 	PDEBUGF(LOG_V0, LOG_PROGRAM, "Program thread started\n");
 	std::thread machine(&Machine::start,m_machine);
 	std::thread mixer(&Mixer::start,m_mixer);
+	m_state_writer = std::thread(&Program::state_writer_thread, this);
+
+	int result = 0;
+	if(is_headless()) {
+		try {
+			benchmark_loop();
+		} catch(std::exception &e) {
+			PERRF(LOG_PROGRAM, "Benchmark failed: %s\n", e.what());
+			result = 1;
+		}
+	} else {
+		main_loop();
+	}
 
-	main_loop();
+	// an empty function stops the writer after the pending states
+	m_state_writer_queue.push(nullptr);
+	m_state_writer.join();
+	PDEBUGF(LOG_V0, LOG_PROGRAM, "State writer thread stopped\n");
 
 	std::unique_lock<std::mutex> lock(ms_lock);
 	
 	m_machine->cmd_power_off();
 
-	// Capture thread needs Mixer and Machine to be alive when stopping
-	m_gui->cmd_stop_capture_and_signal(ms_lock, ms_cv);
-	ms_cv.wait(lock);
+	if(m_gui) {
+		// Capture thread needs Mixer and Machine to be alive when stopping
+		m_gui->cmd_stop_capture_and_signal(ms_lock, ms_cv);
+		ms_cv.wait(lock);
+	}
 	
 	// Mixer needs Machine to be alive when stopping capture
 	m_mixer->cmd_stop_capture();
@@ -855,7 +1003,34 @@ void Program::start()
 	mixer.join();
 	PDEBUGF(LOG_V0, LOG_PROGRAM, "Mixer thread stopped\n");
 
-	m_gui->shutdown();
+	if(m_gui) {
+		m_gui->shutdown();
+	}
+
+	return result;
+}
+
+void Program::state_writer_thread()
+{
+	while(true) {
+		std::function<void()> fn;
+		m_state_writer_queue.wait_and_pop(fn);
+		if(!fn) {
+			break;
+		}
+		fn();
+	}
+}
+
+void Program::wait_state_writer()
+{
+	if(m_state_writer.joinable()) {
+		std::promise<void> done;
+		m_state_writer_queue.push([&done] () {
+			done.set_value();
+		});
+		done.get_future().wait();
+	}
 }
 
 void Program::stop()
@@ -24,7 +24,9 @@
 #include "bench.h"
 #include "appconfig.h"
 #include "state_record.h"
+#include "shared_queue.h"
 #include <condition_variable>
+#include <thread>
 
 class GUI;
 class Machine;
@@ -52,9 +54,22 @@ class Program
 	bool m_start_machine;
 	std::function<void()> m_restore_fn;
 
+	// benchmark mode: the machine runs headless and unpaced for this amount
+	// of virtual seconds, then the results are printed on stdout
+	unsigned m_benchmark_secs;
+
+	// savestates are compressed and written to disk by a separate thread,
+	// its results are delivered to the main loop
+	std::thread m_state_writer;
+	shared_queue<std::function<void()>> m_state_writer_queue;
+	shared_queue<std::function<void()>> m_main_queue;
+
 	void init_SDL();
 	void process_evts();
 	void main_loop();
+	void benchmark_loop();
+	void state_writer_thread();
+	void wait_state_writer();
 
 	std::string get_assets_dir(int argc, char** argv);
 	void parse_arguments(int argc, char** argv);
@@ -70,9 +85,11 @@ public:
 	~Program();
 
 	bool initialize(int argc, char** argv);
-	void start();
+	int start();
 	void stop();
 
+	bool is_headless() const { return m_benchmark_secs > 0; }
+
 	int64_t heartbeat() const { return m_heartbeat; }
 	void set_heartbeat(int64_t _ns);
 	Pacer & pacer() { return m_pacer; }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016-2025  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "rewind.h"
+#include "timers.h"
+#include <cstring>
+
+
+void Rewind::set_config(unsigned _interval_ms, unsigned _budget_mb)
+{
+	m_interval_ns = MS_TO_NS(uint64_t(_interval_ms));
+	m_budget = size_t(_budget_mb) * 1024 * 1024;
+	clear();
+}
+
+void Rewind::clear()
+{
+	m_deltas.clear();
+	m_last.clear();
+	m_last.shrink_to_fit();
+	m_used = 0;
+	m_at_last = false;
+	m_next_vtime = 0;
+}
+
+unsigned Rewind::available() const
+{
+	if(m_last.empty()) {
+		return 0;
+	}
+	return m_deltas.size() + (m_at_last ? 0 : 1);
+}
+
+unsigned Rewind::available(uint64_t _media) const
+{
+	if(m_last.empty()) {
+		return 0;
+	}
+	unsigned steps = 0;
+	if(!m_at_last) {
+		if(m_last_media != _media) {
+			return 0;
+		}
+		steps++;
+	}
+	for(auto delta = m_deltas.rbegin(); delta != m_deltas.rend() && delta->media == _media; delta++) {
+		steps++;
+	}
+	return steps;
+}
+
+void Rewind::capture(const uint8_t *_state, size_t _size, uint64_t _vtime, uint64_t _media)
+{
+	if(!m_last.empty()) {
+		Delta delta{m_last_vtime, m_last_media, _size != m_last.size(), {}, {}};
+		if(delta.whole) {
+			delta.data.swap(m_last);
+			m_last.assign(_state, _state + _size);
+		} else {
+			// keep the old content of the changed blocks, update the rest in place
+			for(size_t offset = 0; offset < _size; offset += BLOCK_SIZE) {
+				size_t len = std::min(BLOCK_SIZE, _size - offset);
+				if(memcmp(&m_last[offset], &_state[offset], len) != 0) {
+					delta.blocks.push_back(offset / BLOCK_SIZE);
+					delta.data.insert(delta.data.end(), &m_last[offset], &m_last[offset] + len);
+					memcpy(&m_last[offset], &_state[offset], len);
+				}
+			}
+		}
+		m_used += delta.bytes();
+		m_deltas.push_back(std::move(delta));
+	} else {
+		m_last.assign(_state, _state + _size);
+	}
+	m_last_vtime = _vtime;
+	m_last_media = _media;
+	m_at_last = false;
+	m_next_vtime = _vtime + m_interval_ns;
+
+	enforce_budget();
+}
+
+const std::vector<uint8_t> & Rewind::step_back(unsigned _steps)
+{
+	assert(_steps && available());
+
+	// if the machine is still at the newest snapshot step 1 means the one before
+	_steps = std::min(_steps + (m_at_last ? 1 : 0), unsigned(m_deltas.size() + 1));
+
+	while(--_steps) {
+		Delta &delta = m_deltas.back();
+		if(delta.whole) {
+			m_last.swap(delta.data);
+		} else {
+			const uint8_t *data = delta.data.data();
+			for(auto block : delta.blocks) {
+				size_t offset = size_t(block) * BLOCK_SIZE;
+				size_t len = std::min(BLOCK_SIZE, m_last.size() - offset);
+				memcpy(&m_last[offset], data, len);
+				data += len;
+			}
+		}
+		m_last_vtime = delta.vtime;
+		m_last_media = delta.media;
+		m_used -= delta.bytes();
+		m_deltas.pop_back();
+	}
+
+	return m_last;
+}
+
+void Rewind::restored(uint64_t _vtime)
+{
+	m_at_last = true;
+	m_next_vtime = _vtime + m_interval_ns;
+}
+
+void Rewind::enforce_budget()
+{
+	while(!m_deltas.empty() && m_used + m_last.size() > m_budget) {
+		m_used -= m_deltas.front().bytes();
+		m_deltas.pop_front();
+	}
+}
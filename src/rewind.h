@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016-2025  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_REWIND_H
+#define IBMULATOR_REWIND_H
+
+#include <deque>
+#include <vector>
+
+/* In-memory ring of machine state snapshots.
+ * Only the newest snapshot is kept whole. Every older one is stored as the
+ * blocks that differ from the snapshot that follows it, so stepping back
+ * means undoing deltas starting from the newest. The oldest deltas are
+ * dropped when the memory budget is exceeded.
+ * To be used only by the Machine thread.
+ */
+class Rewind
+{
+private:
+	static constexpr size_t BLOCK_SIZE = 256;
+
+	struct Delta {
+		uint64_t vtime;              // virtual time of the snapshot it restores
+		uint64_t media;              // media writes count of the snapshot
+		bool whole;                   // data is the whole snapshot
+		std::vector<uint32_t> blocks; // changed blocks otherwise
+		std::vector<uint8_t> data;
+		size_t bytes() const { return data.size() + blocks.size() * sizeof(uint32_t); }
+	};
+
+	std::deque<Delta> m_deltas; // oldest first
+	std::vector<uint8_t> m_last;
+	uint64_t m_last_vtime = 0;
+	uint64_t m_last_media = 0;
+	bool m_at_last = false; // the machine has been restored to m_last
+	size_t m_used = 0;
+
+	uint64_t m_interval_ns = 0;
+	size_t m_budget = 0;
+	uint64_t m_next_vtime = 0;
+
+public:
+	void set_config(unsigned _interval_ms, unsigned _budget_mb);
+	void clear();
+
+	bool is_enabled() const { return m_interval_ns; }
+	bool is_due(uint64_t _vtime) const { return m_interval_ns && _vtime >= m_next_vtime; }
+	unsigned available() const;
+	// Returns the steps back to snapshots taken with the given media writes count.
+	unsigned available(uint64_t _media) const;
+
+	void capture(const uint8_t *_state, size_t _size, uint64_t _vtime, uint64_t _media);
+	// Returns the snapshot _steps intervals back, dropping the newer ones.
+	const std::vector<uint8_t> & step_back(unsigned _steps);
+	void restored(uint64_t _vtime);
+
+private:
+	void enforce_budget();
+};
+
+#endif
@@ -176,3 +176,145 @@ void RingBuffer::p_clear()
 	m_write_ptr = 0;
 	m_write_avail = m_size;
 }
+
+
+void SPSCRingBuffer::set_size(size_t _size)
+{
+	m_data.resize(_size);
+	m_size = _size;
+	std::fill(m_data.begin(), m_data.end(), 0);
+	m_read_pos = 0;
+	m_write_pos = 0;
+	m_skip_pos = 0;
+}
+
+void SPSCRingBuffer::clear()
+{
+	shrink_data(0);
+}
+
+size_t SPSCRingBuffer::read_start() const
+{
+	// the consumer can be behind a drop requested by the producer
+	return std::max(m_read_pos.load(std::memory_order_relaxed),
+			m_skip_pos.load(std::memory_order_acquire));
+}
+
+size_t SPSCRingBuffer::read(uint8_t *_data, size_t _len)
+{
+	if(_data == nullptr || !_len || !m_size) {
+		return 0;
+	}
+
+	size_t rpos = read_start();
+	size_t read_avail = m_write_pos.load(std::memory_order_acquire) - rpos;
+	if(!read_avail) {
+		if(rpos != m_read_pos.load(std::memory_order_relaxed)) {
+			m_read_pos.store(rpos, std::memory_order_release);
+		}
+		return 0;
+	}
+
+	if(_len > read_avail) {
+		_len = read_avail;
+	}
+
+	size_t ptr = rpos % m_size;
+	if(_len > m_size - ptr) {
+		size_t len = m_size - ptr;
+		memcpy(_data, &m_data[ptr], len);
+		memcpy(_data+len, &m_data[0], _len-len);
+	} else {
+		memcpy(_data, &m_data[ptr], _len);
+	}
+
+	m_read_pos.store(rpos + _len, std::memory_order_release);
+
+	return _len;
+}
+
+size_t SPSCRingBuffer::read(uint8_t *_data)
+{
+	return read(_data, 1);
+}
+
+size_t SPSCRingBuffer::write(uint8_t *_data, size_t _len)
+{
+	if(!_data) {
+		return 0;
+	}
+
+	if(!_len) {
+		PDEBUGF(LOG_V0, LOG_PROGRAM, "SPSCRingBuffer: nothing to write (0)\n");
+		return 0;
+	}
+
+	size_t wpos = m_write_pos.load(std::memory_order_relaxed);
+	// space is freed only when the consumer has actually moved past it
+	size_t write_avail = m_size - (wpos - m_read_pos.load(std::memory_order_acquire));
+
+	if(write_avail == 0) {
+		PDEBUGF(LOG_V0, LOG_PROGRAM, "SPSCRingBuffer: WRITE OVERFLOW: 0 of %zu\n", _len);
+		return 0;
+	}
+
+	size_t orig_len = _len;
+
+	if(_len > write_avail) {
+		_len = write_avail;
+	}
+
+	size_t ptr = wpos % m_size;
+	if(_len > m_size - ptr) {
+		size_t len = m_size - ptr;
+		memcpy(&m_data[ptr], _data, len);
+		memcpy(&m_data[0], &_data[len], _len-len);
+	} else {
+		memcpy(&m_data[ptr], _data, _len);
+	}
+
+	m_write_pos.store(wpos + _len, std::memory_order_release);
+
+	if(_len != orig_len) {
+		PDEBUGF(LOG_V0, LOG_PROGRAM, "SPSCRingBuffer: WRITE OVERFLOW: %zu of %zu\n", _len, orig_len);
+	}
+	return _len;
+}
+
+size_t SPSCRingBuffer::write(uint8_t _data)
+{
+	return write(&_data, 1);
+}
+
+size_t SPSCRingBuffer::shrink_data(size_t _limit)
+{
+	size_t wpos = m_write_pos.load(std::memory_order_relaxed);
+	size_t read_avail = wpos - read_start();
+	if(read_avail <= _limit) {
+		return read_avail;
+	}
+	// only the producer writes the skip position
+	m_skip_pos.store(std::max(wpos - _limit, m_skip_pos.load(std::memory_order_relaxed)),
+			std::memory_order_release);
+	return _limit;
+}
+
+void SPSCRingBuffer::get_status(size_t &_size, size_t &_wr_avail, size_t &_rd_avail) const
+{
+	_size = m_size;
+	_rd_avail = get_read_avail();
+	_wr_avail = get_write_avail();
+}
+
+size_t SPSCRingBuffer::get_read_avail() const
+{
+	size_t rpos = read_start();
+	size_t wpos = m_write_pos.load(std::memory_order_acquire);
+	return (wpos > rpos) ? (wpos - rpos) : 0;
+}
+
+size_t SPSCRingBuffer::get_write_avail() const
+{
+	size_t used = m_write_pos.load(std::memory_order_acquire) - m_read_pos.load(std::memory_order_acquire);
+	return (used < m_size) ? (m_size - used) : 0;
+}
@@ -21,6 +21,7 @@
 #define IBMULATOR_RINGBUFFER_H
 
 #include <vector>
+#include <atomic>
 
 class RingBuffer
 {
@@ -58,4 +59,46 @@ private:
 	void p_clear();
 };
 
+/* Wait-free ring buffer for exactly one producer thread and one consumer thread.
+ * The read and write positions are only ever advanced by their owner and
+ * live on separate cache lines. Data dropped by the producer with
+ * shrink_data() or clear() is skipped by the consumer on its next read.
+ * set_size() must be called while neither thread is using the buffer.
+ */
+class SPSCRingBuffer
+{
+protected:
+	std::vector<uint8_t> m_data;
+	size_t m_size = 0;
+	// monotonic positions, modulo m_size to index the data
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_read_pos = 0;  // consumer
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_write_pos = 0; // producer
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_skip_pos = 0;  // producer
+
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer(const SPSCRingBuffer&&) = delete;
+
+public:
+	SPSCRingBuffer() {}
+	virtual ~SPSCRingBuffer() {}
+
+	void set_size(size_t _size);
+	size_t get_size() const { return m_size; }
+	void clear(); // producer
+
+	virtual size_t read(uint8_t *_data, size_t _len); // consumer
+	virtual size_t write(uint8_t *_data, size_t _len); // producer
+	size_t read(uint8_t *_data);
+	size_t write(uint8_t _data);
+	size_t shrink_data(size_t _limit); // producer
+
+	void get_status(size_t &_size, size_t &_wr_avail, size_t &_rd_avail) const;
+	size_t get_read_avail() const;
+	size_t get_write_avail() const;
+
+private:
+	size_t read_start() const;
+};
+
 #endif
@@ -42,7 +42,7 @@ m_state(m_basefile)
 
 	m_info_path   = m_basefile + ".txt";
 	m_ini_path    = m_basefile + ".ini";
-	m_state_path  = m_basefile + ".bin";
+	m_state_path  = m_basefile + STATEBUF_FILE_EXT;
 	m_screen_path = m_basefile + ".png";
 
 	if(FileSys::is_directory(m_path.c_str())) {
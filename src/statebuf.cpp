@@ -20,7 +20,9 @@
 #include "ibmulator.h"
 #include "statebuf.h"
 #include "filesys.h"
+#include "miniz/miniz.h"
 #include <cstring>
+#include <vector>
 
 /*******************************************************************************
  * StateHeader
@@ -219,6 +221,20 @@ void StateBuf::skip()
 	m_curptr += h.data_size;
 }
 
+bool StateBuf::find(const std::string &_name)
+{
+	m_curptr = m_buf;
+	while(get_bytesleft()) {
+		StateHeader h;
+		h.read(m_curptr, get_bytesleft());
+		if(h.name == _name) {
+			return true;
+		}
+		skip();
+	}
+	return false;
+}
+
 void StateBuf::check(const StateHeader &_header)
 {
 	if(!_header.check(m_curptr, get_bytesleft())) {
@@ -233,6 +249,28 @@ void StateBuf::get_next_lump_header(StateHeader &_header) const
 	_header.read(m_curptr, get_bytesleft());
 }
 
+/*******************************************************************************
+ * State files
+ * The buffer is split in frames that are deflated independently, so that it
+ * can be decompressed while it's read. The frame index follows the header.
+ * Files without the header are uncompressed buffers.
+ */
+
+#define STATEFILE_MAGIC      "IBMUSTZ"
+#define STATEFILE_FRAME_SIZE (1024 * 1024)
+// zlib streams are at least 8 bytes long (header, empty block, checksum) and
+// deflate can't compress more than 1032:1
+#define STATEFILE_MIN_FRAME  8
+#define STATEFILE_MAX_RATIO  1032
+
+struct statefile_header_t
+{
+	char magic[8];
+	uint64_t data_size;
+	uint32_t frame_size;
+	uint32_t frames;
+};
+
 void StateBuf::load(const std::string &_path)
 {
 	std::ifstream binfile = FileSys::make_ifstream(_path.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
@@ -245,12 +283,74 @@ void StateBuf::load(const std::string &_path)
 	std::streampos size = binfile.tellg();
 	binfile.seekg(0, std::ios::beg);
 
+	statefile_header_t h;
+	std::vector<uint32_t> index;
+	bool compressed = false;
+	if(size_t(size) >= sizeof(h)) {
+		binfile.read((char*)&h, sizeof(h));
+		if(memcmp(h.magic, STATEFILE_MAGIC, sizeof(h.magic)) == 0) {
+			compressed = true;
+			// validate the header and the frame index before allocating
+			// anything with their values
+			uint64_t file_size = size;
+			uint64_t max_size = uint64_t(h.frames) * h.frame_size;
+			bool valid = (h.data_size > 0 && h.frame_size > 0 && h.frame_size <= STATEFILE_FRAME_SIZE &&
+					h.data_size <= max_size && h.data_size > max_size - h.frame_size &&
+					h.data_size <= SIZE_MAX &&
+					uint64_t(h.frames) * (sizeof(uint32_t) + STATEFILE_MIN_FRAME) <= file_size - sizeof(h));
+			if(valid) {
+				index.resize(h.frames);
+				binfile.read((char*)index.data(), index.size() * sizeof(uint32_t));
+				uint64_t total = sizeof(h) + index.size() * sizeof(uint32_t);
+				uint64_t left = h.data_size;
+				for(auto frame_size : index) {
+					uint64_t len = std::min(left, uint64_t(h.frame_size));
+					if(frame_size < STATEFILE_MIN_FRAME || uint64_t(frame_size) * STATEFILE_MAX_RATIO < len) {
+						valid = false;
+					}
+					total += frame_size;
+					left -= len;
+				}
+				valid = valid && !(binfile.rdstate() & std::ifstream::failbit) && total <= file_size;
+			}
+			if(!valid) {
+				PERRF(LOG_FS,"error reading the state image file\n");
+				throw std::exception();
+			}
+			size = h.data_size;
+		} else {
+			binfile.seekg(0, std::ios::beg);
+		}
+	}
+
 	uint8_t* newbuf = (uint8_t*)malloc(size);
 	if(newbuf == nullptr) {
+		PERRF(LOG_FS,"unable to allocate %zu bytes for the state image file\n", size_t(size));
 		throw std::exception();
 	}
 
-	binfile.read((char*)newbuf, size);
+	if(compressed) {
+		std::vector<uint8_t> frame;
+		size_t offset = 0;
+		for(auto frame_size : index) {
+			frame.resize(frame_size);
+			binfile.read((char*)frame.data(), frame_size);
+			if(binfile.rdstate() & std::ifstream::failbit) {
+				break;
+			}
+			mz_ulong len = std::min(size_t(h.frame_size), size_t(size) - offset);
+			if(mz_uncompress(newbuf + offset, &len, frame.data(), frame_size) != MZ_OK) {
+				binfile.setstate(std::ifstream::failbit);
+				break;
+			}
+			offset += len;
+		}
+		if(offset != size_t(size)) {
+			binfile.setstate(std::ifstream::failbit);
+		}
+	} else {
+		binfile.read((char*)newbuf, size);
+	}
 
 	if(binfile.rdstate() & std::ifstream::failbit) {
 		free(newbuf);
@@ -265,6 +365,21 @@ void StateBuf::load(const std::string &_path)
 	m_last_restore = true;
 }
 
+void StateBuf::load(const uint8_t *_data, size_t _size)
+{
+	uint8_t* newbuf = (uint8_t*)malloc(_size);
+	if(newbuf == nullptr) {
+		throw std::exception();
+	}
+	memcpy(newbuf, _data, _size);
+
+	free(m_buf);
+	m_buf = newbuf;
+	m_size = _size;
+	m_curptr = m_buf;
+	m_last_restore = true;
+}
+
 void StateBuf::save(const std::string &_path) const
 {
 	std::ofstream binfile = FileSys::make_ofstream(_path.c_str(), std::ios::binary);
@@ -274,7 +389,29 @@ void StateBuf::save(const std::string &_path) const
 		throw std::exception();
 	}
 
-	binfile.write((char*)m_buf, m_size);
+	statefile_header_t h;
+	memcpy(h.magic, STATEFILE_MAGIC, sizeof(h.magic));
+	h.data_size = m_size;
+	h.frame_size = STATEFILE_FRAME_SIZE;
+	h.frames = (m_size + STATEFILE_FRAME_SIZE - 1) / STATEFILE_FRAME_SIZE;
+	std::vector<uint32_t> index(h.frames);
+
+	binfile.write((char*)&h, sizeof(h));
+	binfile.write((char*)index.data(), index.size() * sizeof(uint32_t));
+
+	std::vector<uint8_t> frame(mz_compressBound(STATEFILE_FRAME_SIZE));
+	for(unsigned f=0; f<h.frames; f++) {
+		size_t offset = size_t(f) * STATEFILE_FRAME_SIZE;
+		mz_ulong len = frame.size();
+		if(mz_compress2(frame.data(), &len, m_buf + offset,
+				std::min(m_size - offset, size_t(STATEFILE_FRAME_SIZE)), MZ_BEST_SPEED) != MZ_OK) {
+			PERRF(LOG_FS,"error compressing the state image file\n");
+			throw std::exception();
+		}
+		binfile.write((char*)frame.data(), len);
+		index[f] = len;
+	}
+	FileSys::write_at(binfile, sizeof(h), index.data(), index.size() * sizeof(uint32_t));
 
 	if(binfile.rdstate() & std::ofstream::failbit) {
 		PERRF(LOG_FS,"error writing the state image file\n");
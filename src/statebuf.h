@@ -22,6 +22,8 @@
 
 #include <string>
 
+#define STATEBUF_FILE_EXT ".bin"
+
 struct StateHeader
 {
 	size_t data_size;
@@ -56,9 +58,12 @@ public:
 	void seek(size_t _pos);
 	void advance(size_t _off);
 	void skip();
+	bool find(const std::string &_name);
 	void get_next_lump_header(StateHeader &_header) const;
 
 	std::string get_basename() const { return m_basename; }
+	// in-memory states have no basename and no files (disk images etc.)
+	bool in_memory() const { return m_basename.empty(); }
 	constexpr const uint8_t * get_buf() const { return m_curptr; }
 	constexpr size_t get_size() const { return m_size; }
 	constexpr size_t get_bytesleft() const {
@@ -66,6 +71,7 @@ public:
 	}
 
 	void load(const std::string &_path);
+	void load(const uint8_t *_data, size_t _size);
 	void save(const std::string &_path) const;
 };
 
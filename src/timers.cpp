@@ -27,9 +27,6 @@ EventTimers::EventTimers()
 {
 	m_s.time = 0;
 	m_s.next_timer_time = TIME_NEVER;
-	for(unsigned i=0; i<MAX_TIMERS; i++) {
-		m_s.timers[i].in_use = false;
-	}
 	m_mt_time = 0;
 	m_next_timer = 0;
 }
@@ -41,48 +38,55 @@ EventTimers::~EventTimers()
 void EventTimers::save_state(StateBuf &_state)
 {
 	_state.write(&m_s, {sizeof(m_s), "EventTimers"});
+	_state.write(m_timers.data(), {m_next_timer * sizeof(EventTimer), "EventTimersList"});
 }
 
 void EventTimers::restore_state(StateBuf &_state)
 {
-	_state.check({sizeof(m_s), "EventTimers"});
+	_state.read(&m_s, {sizeof(m_s), "EventTimers"});
+
+	StateHeader h;
+	_state.get_next_lump_header(h);
+	if(h.name.compare("EventTimersList") != 0 || (h.data_size % sizeof(EventTimer))) {
+		PERRF(m_log_fac, "EventTimersList expected in state buffer, found %s\n", h.name.c_str());
+		throw std::exception();
+	}
+	std::vector<EventTimer> savtimers(h.data_size / sizeof(EventTimer));
+	if(h.data_size) {
+		_state.read(savtimers.data(), h);
+	} else {
+		_state.skip();
+	}
 
 	// timers MUST be registered before calling this function
 
 	//for every timer in the savestate
-	EventTimer savtimer;
-	for(unsigned t=0; t<MAX_TIMERS; t++) {
-		memcpy(&savtimer, _state.get_buf(), sizeof(EventTimer));
+	for(auto &savtimer : savtimers) {
 		if(savtimer.in_use) {
 			unsigned mchtidx;
 			// here we reset the timing period and related data only.
-			for(mchtidx=0; mchtidx<MAX_TIMERS; mchtidx++) {
-				if(strcmp(m_s.timers[mchtidx].name, savtimer.name) == 0) {
+			for(mchtidx=0; mchtidx<m_next_timer; mchtidx++) {
+				if(strcmp(m_timers[mchtidx].name, savtimer.name) == 0) {
 					break;
 				}
 			}
-			if(mchtidx >= MAX_TIMERS) {
+			if(mchtidx >= m_next_timer) {
 				PERRF(m_log_fac, "Cannot find timer '%s'\n", savtimer.name);
 				throw std::exception();
 			}
-			if(!m_s.timers[mchtidx].in_use) {
-				PERRF(m_log_fac, "Timer '%s' is not in use\n", m_s.timers[mchtidx].name);
+			if(!m_timers[mchtidx].in_use) {
+				PERRF(m_log_fac, "Timer '%s' is not in use\n", m_timers[mchtidx].name);
 				throw std::exception();
 			}
-			m_s.timers[mchtidx].period = savtimer.period;
-			m_s.timers[mchtidx].time_to_fire = savtimer.time_to_fire;
-			m_s.timers[mchtidx].active = savtimer.active;
-			m_s.timers[mchtidx].continuous = savtimer.continuous;
-			m_s.timers[mchtidx].data = savtimer.data;
+			m_timers[mchtidx].period = savtimer.period;
+			m_timers[mchtidx].time_to_fire = savtimer.time_to_fire;
+			m_timers[mchtidx].active = savtimer.active;
+			m_timers[mchtidx].continuous = savtimer.continuous;
+			m_timers[mchtidx].data = savtimer.data;
 		}
-		_state.advance(sizeof(EventTimer));
 	}
 
-	memcpy(&m_s.time, _state.get_buf(), sizeof(uint64_t));
-	_state.advance(sizeof(uint64_t));
-
-	memcpy(&m_s.next_timer_time, _state.get_buf(), sizeof(uint64_t));
-	_state.advance(sizeof(uint64_t));
+	heap_rebuild();
 
 	m_mt_time = m_s.time;
 }
@@ -90,86 +94,139 @@ void EventTimers::restore_state(StateBuf &_state)
 void EventTimers::init()
 {
 	m_next_timer = 0;
+	m_timers.clear();
+	m_callbacks.clear();
+	m_prof_zones.clear();
+	m_heap.clear();
+	m_heap_pos.clear();
 }
 
 void EventTimers::reset()
 {
 	m_s.time = 0;
 	m_mt_time = 0;
-	m_s.next_timer_time = TIME_NEVER;
 	for(unsigned i = 0; i < m_next_timer; i++) {
-		if(m_s.timers[i].in_use && m_s.timers[i].active && m_s.timers[i].continuous) {
-			m_s.timers[i].time_to_fire = m_s.timers[i].period;
+		if(m_timers[i].in_use && m_timers[i].active && m_timers[i].continuous) {
+			m_timers[i].time_to_fire = m_timers[i].period;
 		}
 	}
+	heap_rebuild();
 }
 
-bool EventTimers::update(uint64_t _current_time)
+void EventTimers::update(uint64_t _current_time)
 {
-	// We need to service all the active timers, and invoke callbacks
-	// from those timers which have fired.
-	m_s.next_timer_time = TIME_NEVER;
-	m_triggered.clear();
-	for(unsigned i=0; i<m_next_timer; i++) {
-		if(m_s.timers[i].in_use && m_s.timers[i].active) {
-			if(m_s.timers[i].time_to_fire <= _current_time) {
-
-				// timers need to fire in an ordered manner
-				m_triggered.emplace(m_s.timers[i].time_to_fire, i);
-
-			} else {
-
-				// This timer is not ready to fire yet.
-				if(m_s.timers[i].time_to_fire < m_s.next_timer_time) {
-					m_s.next_timer_time = m_s.timers[i].time_to_fire;
-				}
-
-			}
+	// Fire the timers which have expired, in time order.
+	// Callbacks can activate and deactivate any timer, even the one being
+	// fired; the heap keeps the order correct.
+	while(!m_heap.empty()) {
+		TimerID thistimer = m_heap[0];
+		uint64_t thistimer_time = m_timers[thistimer].time_to_fire;
+		if(thistimer_time > _current_time) {
+			break;
 		}
-	}
-
-	uint64_t prevtimer_time = 0;
-	for(auto &timer : m_triggered) {
-		unsigned thistimer = timer.second;
-		uint64_t thistimer_time = timer.first;
-
-		assert(thistimer_time >= prevtimer_time);
-		assert(thistimer_time <= _current_time);
-
-		// Call requested timer function.  It may request a different
-		// timer period or deactivate etc.
-		// it can even reactivate the same timer and set it to fire BEFORE the next cycle
-		if(!m_s.timers[thistimer].continuous) {
+		if(!m_timers[thistimer].continuous) {
 			// If triggered timer is one-shot, deactive.
-			m_s.timers[thistimer].active = false;
+			m_timers[thistimer].active = false;
+			heap_remove(thistimer);
 		} else {
 			// Continuous timer, increment time-to-fire by period.
-			m_s.timers[thistimer].time_to_fire += m_s.timers[thistimer].period;
-			if(m_s.timers[thistimer].time_to_fire < m_s.next_timer_time) {
-				m_s.next_timer_time = m_s.timers[thistimer].time_to_fire;
-			}
+			m_timers[thistimer].time_to_fire += m_timers[thistimer].period;
+			heap_sift_down(0);
 		}
+		update_next_timer_time();
+
 		if(m_callbacks[thistimer] != nullptr) {
 			// the current time is when the timer fires
-			// time must advance in a monotonic way (that's why we use a map)
+			// time must advance in a monotonic way
 			m_s.time = thistimer_time;
 			m_mt_time = thistimer_time;
 
+			// Call requested timer function.  It may request a different
+			// timer period or deactivate etc.
+			ProfileScope prof(m_prof_zones[thistimer]);
+			UpdateScope in_update(m_in_update);
 			m_callbacks[thistimer](m_s.time);
-
-			if(m_s.timers[thistimer].time_to_fire <= _current_time) {
-				// the timer set itself to fire again before or at the time point
-				// we need to reorder
-				return false;
-			}
 		}
-		prevtimer_time = thistimer_time;
 	}
 
 	m_s.time = _current_time;
 	m_mt_time = _current_time;
+}
+
+void EventTimers::heap_sift_up(unsigned _pos)
+{
+	TimerID timer = m_heap[_pos];
+	while(_pos > 0) {
+		unsigned parent = (_pos - 1) / 2;
+		if(!heap_before(timer, m_heap[parent])) {
+			break;
+		}
+		heap_place(_pos, m_heap[parent]);
+		_pos = parent;
+	}
+	heap_place(_pos, timer);
+}
 
-	return true;
+void EventTimers::heap_sift_down(unsigned _pos)
+{
+	TimerID timer = m_heap[_pos];
+	unsigned size = m_heap.size();
+	while(true) {
+		unsigned child = _pos * 2 + 1;
+		if(child >= size) {
+			break;
+		}
+		if(child + 1 < size && heap_before(m_heap[child + 1], m_heap[child])) {
+			child++;
+		}
+		if(!heap_before(m_heap[child], timer)) {
+			break;
+		}
+		heap_place(_pos, m_heap[child]);
+		_pos = child;
+	}
+	heap_place(_pos, timer);
+}
+
+void EventTimers::heap_schedule(TimerID _timer)
+{
+	unsigned pos = m_heap_pos[_timer];
+	if(pos == NOT_IN_HEAP) {
+		// capacity is reserved in register_timer()
+		m_heap.push_back(_timer);
+		pos = m_heap.size() - 1;
+		m_heap_pos[_timer] = pos;
+	}
+	heap_sift_up(pos);
+	heap_sift_down(m_heap_pos[_timer]);
+}
+
+void EventTimers::heap_remove(TimerID _timer)
+{
+	unsigned pos = m_heap_pos[_timer];
+	if(pos == NOT_IN_HEAP) {
+		return;
+	}
+	m_heap_pos[_timer] = NOT_IN_HEAP;
+	TimerID last = m_heap.back();
+	m_heap.pop_back();
+	if(pos < m_heap.size()) {
+		heap_place(pos, last);
+		heap_sift_up(pos);
+		heap_sift_down(m_heap_pos[last]);
+	}
+}
+
+void EventTimers::heap_rebuild()
+{
+	m_heap.clear();
+	for(unsigned i = 0; i < m_next_timer; i++) {
+		m_heap_pos[i] = NOT_IN_HEAP;
+		if(m_timers[i].in_use && m_timers[i].active) {
+			heap_schedule(i);
+		}
+	}
+	update_next_timer_time();
 }
 
 void EventTimers::set_time(uint64_t _time)
@@ -180,16 +237,21 @@ void EventTimers::set_time(uint64_t _time)
 
 TimerID EventTimers::register_timer(TimerFn _func, const std::string &_name, unsigned _data)
 {
+	if(m_in_update) {
+		PERRF(m_log_fac, "Cannot register timer '%s' from a timer callback\n", _name.c_str());
+		throw std::exception();
+	}
+
 	unsigned timer = NULL_TIMER_ID;
 
 	// search for new timer
 	for(unsigned i = 0; i < m_next_timer; i++) {
 		// check if there's another timer with the same name
-		if(m_s.timers[i].in_use && strcmp(m_s.timers[i].name, _name.c_str())==0) {
+		if(m_timers[i].in_use && strcmp(m_timers[i].name, _name.c_str())==0) {
 			// cannot be 2 timers with the same name
 			return NULL_TIMER_ID;
 		}
-		if(!m_s.timers[i].in_use) {
+		if(!m_timers[i].in_use) {
 			// free timer found
 			timer = i;
 			break;
@@ -197,22 +259,30 @@ TimerID EventTimers::register_timer(TimerFn _func, const std::string &_name, uns
 	}
 	if(timer == NULL_TIMER_ID) {
 		// If we didn't find a free slot, increment the bound.
-		if(m_next_timer >= MAX_TIMERS) {
+		if(m_next_timer >= NULL_TIMER_ID) {
 			PERRF(m_log_fac, "Too many registered timers\n");
 			throw std::exception();
 		}
 		timer = m_next_timer;
 		m_next_timer++;
+		if(m_timers.size() < m_next_timer) {
+			m_timers.resize(m_next_timer);
+			m_callbacks.resize(m_next_timer);
+			m_prof_zones.resize(m_next_timer, PROFILER_NULL_ZONE);
+			m_heap_pos.resize(m_next_timer, NOT_IN_HEAP);
+			m_heap.reserve(m_next_timer);
+		}
 	}
-	m_s.timers[timer].in_use = true;
-	m_s.timers[timer].period = 0;
-	m_s.timers[timer].time_to_fire = 0;
-	m_s.timers[timer].active = false;
-	m_s.timers[timer].continuous = false;
-	m_s.timers[timer].data = _data;
-	snprintf(m_s.timers[timer].name, TIMER_NAME_LEN, "%s", _name.c_str());
+	m_timers[timer].in_use = true;
+	m_timers[timer].period = 0;
+	m_timers[timer].time_to_fire = 0;
+	m_timers[timer].active = false;
+	m_timers[timer].continuous = false;
+	m_timers[timer].data = _data;
+	snprintf(m_timers[timer].name, TIMER_NAME_LEN, "%s", _name.c_str());
 
 	m_callbacks[timer] = _func;
+	m_prof_zones[timer] = g_profiler.zone(_name, "timer");
 
 	PDEBUGF(LOG_V2, m_log_fac, "Timer %d registered for '%s'\n", timer, _name.c_str());
 
@@ -221,24 +291,31 @@ TimerID EventTimers::register_timer(TimerFn _func, const std::string &_name, uns
 
 void EventTimers::unregister_timer(TimerID &_timer)
 {
+	if(m_in_update) {
+		PERRF(m_log_fac, "Cannot unregister timer %u from a timer callback\n", _timer);
+		throw std::exception();
+	}
+
 	if(_timer == NULL_TIMER_ID || _timer>=m_next_timer) {
 		PDEBUGF(LOG_V0, m_log_fac, "Invalid TimerID!\n");
 		return;
 	}
-	if(!m_s.timers[_timer].in_use) {
+	if(!m_timers[_timer].in_use) {
 		PDEBUGF(LOG_V0, m_log_fac, "Cannot unregister timer %u: not in use!\n", _timer);
 		return;
 	}
-	m_s.timers[_timer].in_use = false;
-	m_s.timers[_timer].active = false;
+	m_timers[_timer].in_use = false;
+	m_timers[_timer].active = false;
 	m_callbacks[_timer] = nullptr;
+	heap_remove(_timer);
+	update_next_timer_time();
 	assert(m_next_timer > 0);
 	if(_timer == m_next_timer-1) {
 		// update timers tail index
 		m_next_timer--;
 	}
 	PDEBUGF(LOG_V2, m_log_fac, "Unregistering timer %u '%s'. Remaining timers: %u\n",
-			_timer, m_s.timers[_timer].name, get_timers_count());
+			_timer, m_timers[_timer].name, get_timers_count());
 	_timer = NULL_TIMER_ID;
 }
 
@@ -249,24 +326,23 @@ void EventTimers::activate_timer(TimerID _timer, uint64_t _delay, uint64_t _peri
 		return;
 	}
 
-	if(!m_s.timers[_timer].in_use) {
+	if(!m_timers[_timer].in_use) {
 		PDEBUGF(LOG_V0, m_log_fac, "Timer %u is activated but not used!\n", _timer);
 		return;
 	}
 
 	if(_period == 0) {
 		//use default stored in period field
-		_period = m_s.timers[_timer].period;
+		_period = m_timers[_timer].period;
 	}
 
-	m_s.timers[_timer].active = true;
-	m_s.timers[_timer].period = _period;
-	m_s.timers[_timer].time_to_fire = m_s.time + _delay;
-	m_s.timers[_timer].continuous = _continuous;
+	m_timers[_timer].active = true;
+	m_timers[_timer].period = _period;
+	m_timers[_timer].time_to_fire = m_s.time + _delay;
+	m_timers[_timer].continuous = _continuous;
 
-	if(m_s.timers[_timer].time_to_fire < m_s.next_timer_time) {
-		m_s.next_timer_time = m_s.timers[_timer].time_to_fire;
-	}
+	heap_schedule(_timer);
+	update_next_timer_time();
 }
 
 void EventTimers::activate_timer(TimerID _timer, uint64_t _period, bool _continuous)
@@ -281,7 +357,9 @@ void EventTimers::deactivate_timer(TimerID _timer)
 		return;
 	}
 
-	m_s.timers[_timer].active = false;
+	m_timers[_timer].active = false;
+	heap_remove(_timer);
+	update_next_timer_time();
 }
 
 uint64_t EventTimers::get_timer_eta(TimerID _timer) const
@@ -291,12 +369,12 @@ uint64_t EventTimers::get_timer_eta(TimerID _timer) const
 		return TIME_NEVER;
 	}
 
-	if(!m_s.timers[_timer].active) {
+	if(!m_timers[_timer].active) {
 		// TODO does it make sense to return 0 (now)?
 		return 0;
 	}
-	assert(m_s.timers[_timer].time_to_fire >= m_s.time);
-	return (m_s.timers[_timer].time_to_fire - m_s.time);
+	assert(m_timers[_timer].time_to_fire >= m_s.time);
+	return (m_timers[_timer].time_to_fire - m_s.time);
 }
 
 void EventTimers::set_timer_callback(TimerID _timer, TimerFn _func, unsigned _data)
@@ -307,7 +385,7 @@ void EventTimers::set_timer_callback(TimerID _timer, TimerFn _func, unsigned _da
 	}
 
 	m_callbacks[_timer] = _func;
-	m_s.timers[_timer].data = _data;
+	m_timers[_timer].data = _data;
 }
 
 bool EventTimers::is_timer_active(TimerID _timer) const
@@ -317,8 +395,8 @@ bool EventTimers::is_timer_active(TimerID _timer) const
 		return false;
 	}
 
-	if(m_s.timers[_timer].in_use) {
-		return m_s.timers[_timer].active;
+	if(m_timers[_timer].in_use) {
+		return m_timers[_timer].active;
 	}
 	return false;
 }
@@ -327,7 +405,7 @@ unsigned EventTimers::get_timers_count() const
 {
 	unsigned count = 0;
 	for(unsigned i = 0; i < m_next_timer; i++) {
-		if(m_s.timers[i].in_use) {
+		if(m_timers[i].in_use) {
 			count++;
 		}
 	}
@@ -341,8 +419,8 @@ const EventTimer & EventTimers::get_event_timer(TimerID _timer) const
 		PDEBUGF(LOG_V0, m_log_fac, "Invalid TimerID!\n");
 		return dummy;
 	}
-	if(!m_s.timers[_timer].in_use) {
+	if(!m_timers[_timer].in_use) {
 		return dummy;
 	}
-	return m_s.timers[_timer];
+	return m_timers[_timer];
 }
\ No newline at end of file
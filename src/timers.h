@@ -21,6 +21,7 @@
 #define IBMULATOR_TIMERS_H
 
 #include "statebuf.h"
+#include "profiler.h"
 #include "limits.h"
 
 #define NULL_TIMER_ID 10000
@@ -37,7 +38,6 @@
 #define SEC_TO_NSEC(sec) (double(sec) * 1'000'000'000.0)
 #define MSEC_TO_NSEC(msec) (double(msec) * 1'000'000.0)
 #define USEC_TO_SEC(usec) (double(usec) / 1'000'000.0)
-#define MAX_TIMERS 32
 #define TIMER_NAME_LEN 20
 
 constexpr uint64_t operator"" _us ( unsigned long long int _t ) { return _t * MSEC_PER_SECOND; }
@@ -74,15 +74,34 @@ class EventTimers
 {
 protected:
 	struct {
-		EventTimer timers[MAX_TIMERS];
 		uint64_t time;
 		uint64_t next_timer_time;
 	} m_s;
+	std::vector<EventTimer> m_timers;
+	std::vector<TimerFn> m_callbacks;
+	std::vector<Profiler::ZoneID> m_prof_zones;
 	std::atomic<uint64_t> m_mt_time;
 	unsigned m_next_timer;
-	TimerFn m_callbacks[MAX_TIMERS];
-	std::multimap<uint64_t,TimerID> m_triggered;
 	unsigned m_log_fac = LOG_MACHINE;
+	// true while a callback is running, timers can't be (un)registered then
+	// because the vectors above can move and the running callback is stored
+	// in m_callbacks
+	bool m_in_update = false;
+	// sets m_in_update for its lifetime, exceptions included
+	struct UpdateScope {
+		bool &flag;
+		UpdateScope(bool &_flag) : flag(_flag) { flag = true; }
+		~UpdateScope() { flag = false; }
+	};
+
+	/* Active timers are kept in a binary min-heap ordered by time to fire and
+	 * then by TimerID, which is the order they are fired in.
+	 * The storage is reserved when timers are registered, so nothing is
+	 * allocated while the machine runs.
+	 */
+	static constexpr unsigned NOT_IN_HEAP = UINT_MAX;
+	std::vector<TimerID> m_heap;
+	std::vector<unsigned> m_heap_pos; // position of every timer in m_heap
 
 public:
 	EventTimers();
@@ -92,9 +111,11 @@ public:
 	void reset();
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
-	bool update(uint64_t _current_time);
+	void update(uint64_t _current_time);
 
 	void set_time(uint64_t _time);
+	// advances the time without updating the multithread copy
+	void advance_time(uint64_t _time) { m_s.time = _time; }
 
 	uint64_t get_time() const { return m_s.time; }
 	uint64_t get_time_mt() const { return m_mt_time; }
@@ -116,6 +137,24 @@ public:
 	void set_log_facility(unsigned _fac) {
 		m_log_fac = _fac;
 	}
+
+private:
+	bool heap_before(TimerID _t1, TimerID _t2) const {
+		return (m_timers[_t1].time_to_fire < m_timers[_t2].time_to_fire) ||
+		       (m_timers[_t1].time_to_fire == m_timers[_t2].time_to_fire && _t1 < _t2);
+	}
+	void heap_place(unsigned _pos, TimerID _timer) {
+		m_heap[_pos] = _timer;
+		m_heap_pos[_timer] = _pos;
+	}
+	void heap_sift_up(unsigned _pos);
+	void heap_sift_down(unsigned _pos);
+	void heap_schedule(TimerID _timer);
+	void heap_remove(TimerID _timer);
+	void heap_rebuild();
+	void update_next_timer_time() {
+		m_s.next_timer_time = m_heap.empty() ? TIME_NEVER : m_timers[m_heap[0]].time_to_fire;
+	}
 };
 
 #endif
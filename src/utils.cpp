@@ -365,6 +365,21 @@ std::string str_to_html(std::string _text, bool _nbsp)
 	return _text;
 }
 
+std::string str_to_json(const std::string &_str)
+{
+	std::string result;
+	for(char c : _str) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+		} else if(uint8_t(c) < 0x20) {
+			result += str_format("\\u%04x", uint8_t(c));
+			continue;
+		}
+		result += c;
+	}
+	return result;
+}
+
 std::string bitfield_to_string(uint8_t _bitfield,
 		const std::array<std::string, 8> &_set_names)
 {
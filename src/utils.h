@@ -96,6 +96,7 @@ std::vector<std::string> str_parse_tokens(std::string _str, std::string _regex_s
 std::string::const_iterator str_find_ci(const std::string &_haystack, const std::string &_needle);
 std::string str_format_time(time_t _time, const std::string &_fmt);
 std::string str_to_html(std::string _text, bool _nbsp=false);
+std::string str_to_json(const std::string &_str);
 std::string str_format_special(const char *_str);
 std::string str_format_special(char _ch);
 std::string str_convert(std::string _str, const char *_to_code, const char *_from_code);